@@ -1,312 +1,280 @@
-/* file: BackJob.cpp
-   
-   Background Job Class Implementation File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the code needed to redirect,
-   execute, check the status of, and wait for a background
-   job.
-   
-*/
-
-#include "BackJob.h"
-
-using namespace std;
-
-/******************************************************
-   This is the basic constructor for the class.
-   
-   PRE:  new_command must a parsed Command object
-   
-   POST: my_command is set and all of the booleans
-         are initialized to false
-*/
-BackJob::BackJob(Command new_command) {
-   my_command = new_command;
-   
-   is_running = false;
-   is_terminated = false;
-   is_finished = false;
-   is_failed = false;
-   
-   my_process_id = -1;
-}
-
-/******************************************************
-   Tries to execute the background job.
-   
-   POST: Returns true if the background job was
-         successfully started. Returns false if there
-         was an error.
-*/
-bool BackJob::execute() {
-   
-   // linux system call
-   int pid = fork();
-   
-   // error
-   if (pid < 0) {
-      cout << "Execution error: " << endl;
-      cout << "  Could not create process." << endl;
-      
-      is_failed = true;
-      return false;
-   }
-   
-   // child process
-   if (pid == 0) {
-      
-      // check for input redirection
-      if (my_command.isInputRedirected()) {
-         redirectInput();
-      }
-      
-      // check for output redirection
-      if (my_command.isOutputRedirected()) {
-         redirectOutput();
-      }
-      
-      // linux system call
-      execvp(my_command.getCommandName().c_str(), my_command.getArgsArray());
-      
-      // still here, must be an error
-      is_failed = true;
-      cout << endl << "Execution error:" << endl;
-      
-      if (errno == 2)
-         cout << "  Command not found." << endl;   
-      else
-         cout << "  " << strerror(errno) << "." << endl;
-      
-      // kludge to fix prompting inelegance
-      cout << "wsh: ";
-      
-      exit(-1);
-   }
-   
-   // still here, must be the parent
-   my_process_id = pid;
-   
-   is_running = true;
-   return true;
-}
-
-/******************************************************
-   Tries to suspend the process until the background
-   job specified by my_process_id is finished executing.
-   
-   PRE:  The background job specified by my_command
-         has been started successfully
-         (i.e. execute() has been called)
-   
-   POST: Returns true after the background process is
-         finished. Returns false if there was an error
-         trying to wait.
-*/
-bool BackJob::waitForMe() {
-   
-   int pid_success = waitpid(my_process_id, NULL, 0);
-   
-   // check if something nasty happend
-   if (pid_success == -1) {
-      cout << "Could not wait for job:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      return false;
-   }
-   
-   setFinished(true);
-   
-   return true;
-}
-
-/******************************************************
-   Returns the background job's Command object.
-   
-   POST: my_command is returned.
-*/
-Command BackJob::getCommand() const {
-   return my_command;
-}
-
-/******************************************************
-   Returns the background job's process id.
-   
-   POST: my_process_id is returned.
-*/
-int BackJob::getPid() const {
-   return my_process_id;
-}
-
-/******************************************************
-   Returns whether the background job is currently
-   running.
-   
-   POST: is_running is returned.
-*/
-bool BackJob::isRunning() const {
-   return is_running;
-}
-
-/******************************************************
-   Returns whether the background job has finished
-   running but has not been displayed to the user yet.
-   
-   POST: is_finished is returned.
-*/
-bool BackJob::isFinished() const {
-   return is_finished;
-}
-
-/******************************************************
-   Returns whether the background job has terminated,
-   the user has been notified, and this object is
-   now historic information.
-   
-   POST: is_terminated is returned.
-*/
-bool BackJob::isTerminated() const {
-   return is_terminated;
-}
-
-/******************************************************
-   Returns whether the background job encountered
-   an error when it was being started.
-   
-   POST: is_failed is returned.
-*/
-bool BackJob::isFailed() const {
-   return is_failed;
-}
-
-/******************************************************
-   Sets whether the process has finished running but
-   has not been displayed to the user yet.
-   
-   PRE:  yes_no is a valid boolean.
-   
-   POST: is_finished is set and the other booleans
-         are set to false.
-*/
-void BackJob::setFinished(bool yes_no) {
-   is_running = false;
-   is_finished = yes_no;
-   is_terminated = false;
-}
-
-/******************************************************
-   Sets whether the process has terminated, the user
-   has been notified, and this object is now historical
-   information.
-   
-   PRE:  yes_no is a valid boolean.
-   
-   POST: is_terminated is set and the other booleans
-         are set to false.
-*/
-void BackJob::setTerminated(bool yes_no) {
-   is_running = false;
-   is_finished = false;
-   is_terminated = yes_no;
-}
-
-/******************************************************
-   Tries to redirect the output of the job to the file
-   specified in the my_command object.
-   
-   PRE:  my_command has been parsed.
-   
-   POST: Returns after a successful redirect attempt.
-         Otherwise, an error message is printed and
-         the process terminates.
-*/
-void BackJob::redirectOutput() {
-   
-   // convert filename string into char array
-   char *file_ptr = NULL;
-   file_ptr = new char [my_command.getOutputFileName().size() + 1]; 
-   strcpy(file_ptr, my_command.getOutputFileName().c_str());
-    
-   // linux system call get file descriptor
-   int file_descriptor = open(file_ptr, O_CREAT|O_WRONLY|O_TRUNC, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
-   
-   // check if something nasty happened
-   if (file_descriptor == -1) {
-      
-      cout << "Output file error:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }
-   
-   // linux system call to redirect output
-   int redirect_success = dup2(file_descriptor, 1);
-   
-   // check if something nasty happened
-   if (redirect_success == -1) {
-      
-      cout << "Output file redirect error:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }
-   
-   close(file_descriptor);
-   
-   // check if something nasty happened
-   if (redirect_success == -1) {
-      
-      cout << "Output file error:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   } 
-}
-
-/******************************************************
-   Tries to redirect the input of the job to the file
-   specified in the my_command object.
-   
-   PRE:  my_command has been parsed.
-   
-   POST: Returns after a successful redirect attempt.
-         Otherwise, an error message is printed and
-         the process terminates.
-*/
-void BackJob::redirectInput() {
-   
-   // convert filename string into char array
-   char *file_ptr = NULL;
-   file_ptr = new char [my_command.getInputFileName().size() + 1]; 
-   strcpy(file_ptr, my_command.getInputFileName().c_str());
-    
-   // linux system call get file descriptor
-   int file_descriptor = open(file_ptr, O_RDONLY);
-   
-   // check if something nasty happened
-   if (file_descriptor == -1) {
-      
-      cout << "Input file error:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }
-   
-   // linux system call to redirect input
-   int redirect_success = dup2(file_descriptor, 0);
-   
-   // check if something nasty happened
-   if (redirect_success == -1) {
-      
-      cout << "Input file redirect error:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }
-   
-   close(file_descriptor);
-   
-   // check if something nasty happened
-   if (redirect_success == -1) {
-      
-      cout << "Input file error:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }  
-}
+/* file: BackJob.cpp
+   
+   Background Job Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the code needed to redirect,
+   execute, check the status of, and wait for a background
+   job.
+   
+*/
+
+#include "BackJob.h"
+#include <sys/syscall.h>
+
+using namespace std;
+
+/******************************************************
+   This is the basic constructor for the class.
+   
+   PRE:  new_command must a parsed Command object
+   
+   POST: my_command is set and all of the booleans
+         are initialized to false
+*/
+BackJob::BackJob(const Command &new_command) : my_command(new_command) {
+   
+   is_running = false;
+   is_finished = false;
+   is_failed = false;
+   is_queued = false;
+   
+   my_process_id = -1;
+   my_pid_fd = -1;
+   wait_status = -1;
+}
+
+/******************************************************
+   Tries to execute the background job.
+   
+   POST: Returns true if the background job was
+         successfully started. Returns false if there
+         was an error.
+*/
+bool BackJob::execute() {
+   
+   is_queued = false;
+   
+   Spawner spawner;
+   
+   // the new process does the redirections before it execs
+   if (my_command.isInputRedirected()) {
+      spawner.addOpen(0, my_command.getInputFilePath(), O_RDONLY, 0);
+   }
+   
+   if (my_command.isOutputRedirected()) {
+      spawner.addOpen(1, my_command.getOutputFilePath(), O_CREAT|O_WRONLY|O_TRUNC, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+   }
+   
+   int pid = spawner.spawn(my_command.getArgsArray());
+   
+   // error, the process couldn't be started or couldn't exec
+   if (pid < 0) {
+      spawner.printFailure();
+      
+      is_failed = true;
+      return false;
+   }
+   
+   // still here, must be the parent
+   my_process_id = pid;
+   clock_gettime(CLOCK_MONOTONIC, &start_time);
+   
+   // readable once the process exits, and close-on-exec
+#ifdef SYS_pidfd_open
+   my_pid_fd = syscall(SYS_pidfd_open, pid, 0);
+#endif
+   
+   is_running = true;
+   return true;
+}
+
+/******************************************************
+   Tries to suspend the process until the background
+   job specified by my_process_id is finished executing.
+   
+   PRE:  The background job specified by my_command
+         has been started successfully
+         (i.e. execute() has been called)
+   
+   POST: Returns true after the background process is
+         finished, with its status and resource usage
+         kept. Returns false if there was an error
+         trying to wait.
+*/
+bool BackJob::waitForMe() {
+   
+   int status;
+   struct rusage child_usage;
+   
+   // the same reap waitpid() would do, the usage comes with it
+   int pid_success = wait4(my_process_id, &status, 0, &child_usage);
+   
+   // check if something nasty happend
+   if (pid_success == -1) {
+      cout << "Could not wait for job:" << endl;
+      cout << "  " << strerror(errno) << "." << endl;
+      return false;
+   }
+   
+   setResult(status, child_usage);
+   
+   return true;
+}
+
+/******************************************************
+   Returns the background job's Command object.
+   
+   POST: my_command is returned.
+*/
+const Command & BackJob::getCommand() const {
+   return my_command;
+}
+
+/******************************************************
+   Returns the background job's process id.
+   
+   POST: my_process_id is returned.
+*/
+int BackJob::getPid() const {
+   return my_process_id;
+}
+
+/******************************************************
+   Returns the pidfd of the background job's process.
+   
+   POST: my_pid_fd is returned.
+*/
+int BackJob::getPidFd() const {
+   return my_pid_fd;
+}
+
+/******************************************************
+   Returns how long the job has run, in seconds. A job
+   that is still running is timed up to now.
+   
+   PRE:  The job has been executed.
+   
+   POST: Returns the time between start_time and
+         finish_time, or now.
+*/
+double BackJob::getRunTime() const {
+   
+   struct timespec end_time = finish_time;
+   
+   if (is_running)
+      clock_gettime(CLOCK_MONOTONIC, &end_time);
+   
+   return (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+}
+
+/******************************************************
+   Returns whether the job's wait status and resource
+   usage are known.
+   
+   POST: Returns true once setResult() has been called.
+*/
+bool BackJob::hasResult() const {
+   return wait_status != -1;
+}
+
+/******************************************************
+   Returns the job's wait status, for the W macros.
+   
+   PRE:  hasResult() is true.
+*/
+int BackJob::getWaitStatus() const {
+   return wait_status;
+}
+
+/******************************************************
+   Returns the resource usage of the job's process.
+   
+   PRE:  hasResult() is true.
+*/
+const struct rusage & BackJob::getUsage() const {
+   return usage;
+}
+
+/******************************************************
+   Returns whether the background job is currently
+   running.
+   
+   POST: is_running is returned.
+*/
+bool BackJob::isRunning() const {
+   return is_running;
+}
+
+/******************************************************
+   Returns whether the background job has finished
+   running but has not been displayed to the user yet.
+   
+   POST: is_finished is returned.
+*/
+bool BackJob::isFinished() const {
+   return is_finished;
+}
+
+/******************************************************
+   Returns whether the background job is waiting for
+   its turn to be executed.
+   
+   POST: is_queued is returned.
+*/
+bool BackJob::isQueued() const {
+   return is_queued;
+}
+
+/******************************************************
+   Returns whether the background job encountered
+   an error when it was being started.
+   
+   POST: is_failed is returned.
+*/
+bool BackJob::isFailed() const {
+   return is_failed;
+}
+
+/******************************************************
+   Sets whether the process has finished running but
+   has not been displayed to the user yet.
+   
+   PRE:  yes_no is a valid boolean.
+   
+   POST: is_finished is set and the other booleans
+         are set to false. If the job was running, the
+         finish time is now and the pidfd is closed.
+*/
+void BackJob::setFinished(bool yes_no) {
+   
+   if (is_running) {
+      clock_gettime(CLOCK_MONOTONIC, &finish_time);
+      
+      if (my_pid_fd != -1) {
+         close(my_pid_fd);
+         my_pid_fd = -1;
+      }
+   }
+   
+   is_running = false;
+   is_finished = yes_no;
+}
+
+/******************************************************
+   Sets whether the job is waiting for its turn to be
+   executed.
+   
+   PRE:  The job hasn't been executed yet.
+   
+   POST: is_queued is set.
+*/
+void BackJob::setQueued(bool yes_no) {
+   is_queued = yes_no;
+}
+
+/******************************************************
+   Keeps what wait4() gave back for the job's process
+   and sets the job to finished.
+   
+   POST: hasResult() is true and the job is finished.
+*/
+void BackJob::setResult(int status, const struct rusage &new_usage) {
+   
+   wait_status = status;
+   usage = new_usage;
+   
+   setFinished(true);
+}
@@ -1,191 +1,250 @@
-/* file: BackJob.h
-   
-   Background Job Class Header File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the code needed to redirect,
-   execute, check the status of, and wait for a background
-   job.
-   
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on constructors:                   !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   BackJob(Command new_command)
-   --------------------------------------------------
-      This is the basic constructor for the class.
-      
-      PRE:  new_command must a parsed Command object
-   
-      POST: The object has been initialized. new_command
-            is now the value of this object's command.
-            
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on public methods:                 !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   bool execute()
-   --------------------------------------------------
-      Tries to execute the background job. Does not
-      wait for it to finish executing.
-   
-      POST: Returns true if the background job was
-            successfully started. Returns false if there
-            was an error.
-      
-      
-   bool waitForMe()
-   --------------------------------------------------
-      Tries to suspend the process until the background
-      job specified by my_process_id is finished executing.
-      
-      PRE:  The method execute() has already been succesfully
-            called.
-      
-      POST: Returns true after the background process is
-            finished. Returns false if there was an error
-            trying to wait.
-         
-   
-   Command getCommand() const
-   --------------------------------------------------
-      Returns the background job's Command object.
-   
-      POST: Returns a Command object.
-      
-      
-   int getPid() const
-   --------------------------------------------------
-      Returns the background job's process id.
-   
-      POST: Returns an integer corresponding to this
-            background job's process id. Returns -1 if
-            the job has not been executed.
-      
-      
-   bool isRunning() const
-   --------------------------------------------------
-      Returns whether the background job is currently
-      running.
-   
-      POST: Returns true if the job is running. Returns
-            false if it is not.
-      
-      
-   bool isFinished() const
-   --------------------------------------------------
-      Returns whether the background job has finished
-      running but has not been displayed to the user yet.
-   
-      POST: Returns true if the job has finished but
-            the user has not been notified. Returns
-            false if those conditions are not true.
-      
-      
-   bool isTerminated() const
-   --------------------------------------------------
-      Returns whether the background job has terminated,
-      the user has been notified, and this object is
-      now historic information.
-   
-      POST: Returns true if the job has terminated and
-            the user has been notified. Returns false if
-            those conditions are not true.
-      
-      
-   bool isFailed() const
-   --------------------------------------------------
-      Returns whether the background job encountered
-      an error when it was being started.
-   
-      POST: Returns true if there was an error trying to
-            run the job. Returns false if there was not.
-    
-    
-    void setFinished(bool yes_no)
-    --------------------------------------------------
-      Sets whether the process has finished running but
-      has not been displayed to the user yet.
-      
-      PRE:  yes_no is a valid boolean.
-      
-      POST: If yes_no is true, then the method isFinished()
-            will return true. If yes_no is false, then this
-            object basically has no status assigned.
-    
-    
-    void setTerminated(bool yes_no)
-    --------------------------------------------------
-      Sets whether the process has terminated, the user
-      has been notified, and this object is now historical
-      information.
-      
-      PRE:  yes_no is a valid boolean.
-      
-      POST: If yes_no is true, then the method isTerminated()
-            will return true. If yes_no is false, then this
-            object basically has no status assigned.
-   
-*/
-
-#ifndef BACK_HEADER
-#define BACK_HEADER
-
-#include <string>
-#include <vector>
-#include <iostream>
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <fcntl.h>
-#include <errno.h>
-#include "Command.h"
-
-using namespace std;
-
-class BackJob {
-   
-   public:
-   
-         // constructor
-         BackJob(Command new_command);
-         
-         // execute the job
-         bool execute();
-         bool waitForMe();
-         
-         // get commands
-         Command getCommand() const;
-         int getPid() const;
-         bool isRunning() const;
-         bool isFinished() const;
-         bool isTerminated() const;
-         bool isFailed() const;
-         
-         // set commands
-         void setFinished(bool yes_no);
-         void setTerminated(bool yes_no);
-   
-   private:
-         
-         // redirection commands
-         void redirectOutput();
-         void redirectInput();
-         
-         //------------------------------------------------------------
-         // Data
-         //------------------------------------------------------------
-         int my_process_id;
-         bool is_running;
-         bool is_finished;   // job just finished, will be displayed next time
-         bool is_terminated; // job is essentially dead weight now
-         bool is_failed;
-         Command my_command;
-   
-};
-
-#endif
+/* file: BackJob.h
+   
+   Background Job Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the code needed to redirect,
+   execute, check the status of, and wait for a background
+   job.
+   
+   Each job keeps a pidfd of its process, which becomes
+   readable the moment the process exits, so the
+   JobManager can wait for it along with the shell's
+   input. The times the job started and finished are
+   kept for reporting how long it ran, along with the
+   wait status and resource usage wait4() gave back
+   when it was reaped.
+   
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   BackJob(const Command &new_command)
+   --------------------------------------------------
+      This is the basic constructor for the class.
+      
+      PRE:  new_command must a parsed Command object
+   
+      POST: The object has been initialized. This object
+            keeps its own copy of new_command, since the
+            job outlives the command line it came from.
+            
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   bool execute()
+   --------------------------------------------------
+      Tries to execute the background job. Does not
+      wait for it to finish executing.
+   
+      POST: Returns true if the background job was
+            successfully started. Returns false if there
+            was an error.
+      
+      
+   bool waitForMe()
+   --------------------------------------------------
+      Tries to suspend the process until the background
+      job specified by my_process_id is finished executing.
+      
+      PRE:  The method execute() has already been succesfully
+            called.
+      
+      POST: Returns true after the background process is
+            finished, with its result kept. Returns false
+            if there was an error trying to wait.
+         
+   
+   const Command & getCommand() const
+   --------------------------------------------------
+      Returns the background job's Command object.
+   
+      POST: Returns a reference to the Command object,
+            which is good as long as this object is.
+      
+      
+   int getPid() const
+   --------------------------------------------------
+      Returns the background job's process id.
+   
+      POST: Returns an integer corresponding to this
+            background job's process id. Returns -1 if
+            the job has not been executed.
+      
+      
+   int getPidFd() const
+   --------------------------------------------------
+      Returns the pidfd of the background job's process.
+   
+      POST: Returns -1 if the job isn't running or the
+            kernel doesn't have pidfd_open().
+      
+      
+   double getRunTime() const
+   --------------------------------------------------
+      Returns how long the job has run, in seconds.
+   
+      PRE:  The job has been executed.
+   
+      POST: For a finished job this is the time from
+            when it was started to when it was seen to
+            finish, to the microsecond.
+      
+      
+   bool hasResult() const
+   int getWaitStatus() const
+   const struct rusage & getUsage() const
+   --------------------------------------------------
+      Return whether the job's wait status and resource
+      usage are known, and what they are.
+      
+      POST: There is no result until the job has been
+            reaped by this object or setResult(), and
+            never if somebody else reaped it.
+      
+      
+   bool isRunning() const
+   --------------------------------------------------
+      Returns whether the background job is currently
+      running.
+   
+      POST: Returns true if the job is running. Returns
+            false if it is not.
+      
+      
+   bool isFinished() const
+   --------------------------------------------------
+      Returns whether the background job has finished
+      running but has not been displayed to the user yet.
+   
+      POST: Returns true if the job has finished but
+            the user has not been notified. Returns
+            false if those conditions are not true.
+      
+      
+   bool isQueued() const
+   --------------------------------------------------
+      Returns whether the background job is waiting for
+      its turn to be executed.
+   
+      POST: Returns true if the job is queued. Returns
+            false if it is not.
+      
+      
+   bool isFailed() const
+   --------------------------------------------------
+      Returns whether the background job encountered
+      an error when it was being started.
+   
+      POST: Returns true if there was an error trying to
+            run the job. Returns false if there was not.
+    
+    
+    void setFinished(bool yes_no)
+    --------------------------------------------------
+      Sets whether the process has finished running but
+      has not been displayed to the user yet.
+      
+      PRE:  yes_no is a valid boolean.
+      
+      POST: If yes_no is true, then the method isFinished()
+            will return true. If yes_no is false, then this
+            object basically has no status assigned. A job
+            that was running has its finish time set and
+            its pidfd closed.
+    
+    
+    void setQueued(bool yes_no)
+    --------------------------------------------------
+      Sets whether the job is waiting for its turn to be
+      executed.
+      
+      PRE:  The job hasn't been executed yet.
+      
+      POST: If yes_no is true, then the method isQueued()
+            will return true until execute() is called.
+    
+    
+    void setResult(int status, const struct rusage &new_usage)
+    --------------------------------------------------
+      Keeps what wait4() gave back for the job's process
+      and sets the job to finished.
+      
+      POST: hasResult() returns true.
+   
+*/
+
+#ifndef BACK_HEADER
+#define BACK_HEADER
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "Command.h"
+#include "Spawner.h"
+
+using namespace std;
+
+class BackJob {
+   
+   public:
+   
+         // constructor
+         BackJob(const Command &new_command);
+         
+         // execute the job
+         bool execute();
+         bool waitForMe();
+         
+         // get commands
+         const Command & getCommand() const;
+         int getPid() const;
+         int getPidFd() const;
+         double getRunTime() const;
+         bool hasResult() const;
+         int getWaitStatus() const;
+         const struct rusage & getUsage() const;
+         bool isRunning() const;
+         bool isFinished() const;
+         bool isQueued() const;
+         bool isFailed() const;
+         
+         // set commands
+         void setFinished(bool yes_no);
+         void setQueued(bool yes_no);
+         void setResult(int status, const struct rusage &new_usage);
+   
+   private:
+         
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+         int my_process_id;
+         int my_pid_fd;      // closed once the job has finished
+         struct timespec start_time;
+         struct timespec finish_time;
+         
+         // from wait4(), wait_status is -1 until it is known
+         int wait_status;
+         struct rusage usage;
+         bool is_running;
+         bool is_finished;   // job just finished, will be displayed next time
+         bool is_failed;
+         bool is_queued;     // waiting for a free slot to run in
+         Command my_command;
+   
+};
+
+#endif
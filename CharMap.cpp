@@ -0,0 +1,270 @@
+/* file: CharMap.cpp
+
+   Character Map Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class classifies every char of a command line
+   in one pass and stores the result as bitmasks, one
+   bit per char.
+
+*/
+
+#include "CharMap.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: text_size is set to zero.
+*/
+CharMap::CharMap() {
+   text_size = 0;
+}
+
+/******************************************************
+   Builds the bitmasks for text. Whole 64 char blocks
+   go through the SSE2 code if there is any, the
+   leftover chars at the end are done one at a time.
+
+   POST: The masks describe text.
+*/
+void CharMap::classify(const string &text) {
+
+   text_size = text.size();
+   int num_words = (text_size + 63) / 64;
+
+   // assign() keeps the capacity around for the next line
+   MaskWord empty = { 0, 0, 0, 0, 0, 0 };
+   masks.assign(num_words, empty);
+
+   int num_blocks = 0;
+
+#if defined(__SSE2__)
+   num_blocks = text_size / 64;
+
+   for (int blockCtr = 0; blockCtr < num_blocks; blockCtr++) {
+      classifyBlock(text.data(), blockCtr);
+   }
+#endif
+
+   classifyScalar(text.data(), num_blocks * 64, text_size);
+}
+
+/******************************************************
+   Finds the first char at or after currentPos that
+   ends a run of plain word chars: a separator, quote,
+   glob or escape char.
+
+   POST: Returns its position, or text_size if there
+         are none left.
+*/
+int CharMap::nextBreak(int currentPos) const {
+   return nextMatch(currentPos, false);
+}
+
+/******************************************************
+   Finds the first quote or escape char at or after
+   currentPos.
+
+   POST: Returns its position, or text_size if there
+         are none left.
+*/
+int CharMap::nextQuote(int currentPos) const {
+   return nextMatch(currentPos, true);
+}
+
+/******************************************************
+   Skips the spaces and tabs at currentPos.
+
+   POST: Returns the first position at or after
+         currentPos that isn't one, or text_size if
+         there are none left.
+*/
+int CharMap::skipSpaces(int currentPos) const {
+
+   if (currentPos >= text_size)
+      return text_size;
+
+   int word = currentPos / 64;
+
+   // ignore the chars before currentPos
+   unsigned long long bits = ~masks[word].space_bits & (~0ULL << (currentPos % 64));
+
+   while (bits == 0) {
+      word++;
+
+      if (word == masks.size())
+         return text_size;
+
+      bits = ~masks[word].space_bits;
+   }
+
+   // the bits past the end of the line aren't spaces
+   return min(word * 64 + __builtin_ctzll(bits), text_size);
+}
+
+/******************************************************
+   Counts the '|' chars in the line.
+
+   POST: Returns the number of pipe bits that are set.
+*/
+int CharMap::countPipes() const {
+
+   int num_pipes = 0;
+
+   for (int word = 0; word < masks.size(); word++) {
+      num_pipes += __builtin_popcountll(masks[word].pipe_bits);
+   }
+
+   return num_pipes;
+}
+
+/******************************************************
+   Finds the first char at or after currentPos whose
+   bit is set in the masks being looked for.
+
+   POST: Returns its position, or text_size if there
+         are none left.
+*/
+int CharMap::nextMatch(int currentPos, bool in_quotes) const {
+
+   if (currentPos >= text_size)
+      return text_size;
+
+   int word = currentPos / 64;
+
+   // ignore the chars before currentPos
+   unsigned long long bits = matchBits(word, in_quotes) & (~0ULL << (currentPos % 64));
+
+   while (bits == 0) {
+      word++;
+
+      if (word == masks.size())
+         return text_size;
+
+      bits = matchBits(word, in_quotes);
+   }
+
+   return word * 64 + __builtin_ctzll(bits);
+}
+
+/******************************************************
+   Returns the bits of one mask word that end a run of
+   plain chars. Inside of quotes only quotes and escape
+   chars do, outside separators and globs do too.
+*/
+unsigned long long CharMap::matchBits(int word, bool in_quotes) const {
+
+   unsigned long long bits = masks[word].quote_bits | masks[word].escape_bits;
+
+   if (!in_quotes)
+      bits |= masks[word].sep_bits | masks[word].glob_bits;
+
+   return bits;
+}
+
+/******************************************************
+   Classifies chars one at a time.
+
+   PRE:  The masks are big enough for endPos chars.
+
+   POST: The bits for chars startPos to endPos (not
+         including endPos) are set.
+*/
+void CharMap::classifyScalar(const char *text, int startPos, int endPos) {
+
+   for (int currentPos = startPos; currentPos < endPos; currentPos++) {
+
+      unsigned long long bit = 1ULL << (currentPos % 64);
+      int word = currentPos / 64;
+
+      switch (text[currentPos]) {
+         case '|':
+            masks[word].pipe_bits |= bit;
+            masks[word].sep_bits |= bit;
+            break;
+         case ' ':
+         case '\t':
+            masks[word].space_bits |= bit;
+            masks[word].sep_bits |= bit;
+            break;
+         case ';':
+         case '<':
+         case '>':
+         case '&':
+            masks[word].sep_bits |= bit;
+            break;
+         case '"':
+         case '\'':
+            masks[word].quote_bits |= bit;
+            break;
+         case '*':
+         case '?':
+         case '~':
+            masks[word].glob_bits |= bit;
+            break;
+         case '\\':
+            masks[word].escape_bits |= bit;
+            break;
+      }
+   }
+}
+
+#if defined(__SSE2__)
+
+// bitmask of the bytes in v that are equal to c
+#define MATCH(v, c) ((unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8((v), _mm_set1_epi8(c))))
+
+/******************************************************
+   Classifies the 64 chars of the given block with
+   four 16 byte SSE2 compares per char class.
+
+   PRE:  The block is entirely inside of the line.
+
+   POST: The mask words for the block are set.
+*/
+void CharMap::classifyBlock(const char *text, int word) {
+
+   const char *block = text + word * 64;
+
+   for (int quarter = 0; quarter < 4; quarter++) {
+
+      __m128i chars = _mm_loadu_si128((const __m128i *) (block + quarter * 16));
+
+      unsigned int pipes = MATCH(chars, '|');
+      unsigned int spaces = MATCH(chars, ' ') | MATCH(chars, '\t');
+      unsigned int seps = pipes | spaces | MATCH(chars, '<') | MATCH(chars, '>') | MATCH(chars, '&') | MATCH(chars, ';');
+      unsigned int quotes = MATCH(chars, '"') | MATCH(chars, '\'');
+      unsigned int globs = MATCH(chars, '*') | MATCH(chars, '?') | MATCH(chars, '~');
+      unsigned int escapes = MATCH(chars, '\\');
+
+      int shift = quarter * 16;
+      masks[word].sep_bits |= (unsigned long long) seps << shift;
+      masks[word].space_bits |= (unsigned long long) spaces << shift;
+      masks[word].pipe_bits |= (unsigned long long) pipes << shift;
+      masks[word].quote_bits |= (unsigned long long) quotes << shift;
+      masks[word].glob_bits |= (unsigned long long) globs << shift;
+      masks[word].escape_bits |= (unsigned long long) escapes << shift;
+   }
+}
+
+#undef MATCH
+
+#else
+
+/******************************************************
+   No vector instructions, classify() does every char
+   with classifyScalar() and never calls this.
+*/
+void CharMap::classifyBlock(const char *text, int word) {
+   classifyScalar(text, word * 64, word * 64 + 64);
+}
+
+#endif
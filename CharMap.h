@@ -0,0 +1,133 @@
+/* file: CharMap.h
+
+   Character Map Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class classifies every char of a command line
+   in one pass and stores the result as bitmasks, one
+   bit per char. The lexer uses it to jump straight to
+   the next separator, quote or pipe instead of testing
+   chars one at a time. Whole 64 char blocks are done
+   with SSE2, which every x86-64 compiler turns on, and
+   anything else uses plain C++.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   CharMap()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: The object has been initialized. It maps
+            an empty line.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   void classify(const string &text)
+   --------------------------------------------------
+      Builds the bitmasks for text. The masks of any
+      earlier line are thrown away.
+
+      POST: All of the other methods now answer
+            questions about text.
+
+
+   int nextBreak(int currentPos) const
+   --------------------------------------------------
+      Finds the first separator (a space, '<', '>', '&',
+      '|' or ';'), quote, glob (*, ? or ~) or escape char (\)
+      at or after currentPos. Everything before it is a
+      plain word char.
+
+      POST: Returns its position, or the length of the
+            line if there are none left.
+
+
+   int nextQuote(int currentPos) const
+   --------------------------------------------------
+      Finds the first quote (' or ") or escape char at
+      or after currentPos, which is as far as a quoted
+      part of a word can be skipped.
+
+      POST: Returns its position, or the length of the
+            line if there are none left.
+
+
+   int skipSpaces(int currentPos) const
+   --------------------------------------------------
+      Skips the spaces at currentPos. A space is a ' '
+      or a tab, the same as the lexer splits words on,
+      so every parser agrees on what one is.
+
+      POST: Returns the first position at or after
+            currentPos that isn't a space, or the length
+            of the line if there are none left.
+
+
+   int countPipes() const
+   --------------------------------------------------
+      Returns the number of '|' chars in the line.
+
+*/
+
+#ifndef CHARMAP_HEADER
+#define CHARMAP_HEADER
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class CharMap {
+
+    public:
+
+         // constructor
+         CharMap();
+
+         // build the masks
+         void classify(const string &text);
+
+         // lookups
+         int nextBreak(int currentPos) const;
+         int nextQuote(int currentPos) const;
+         int skipSpaces(int currentPos) const;
+         int countPipes() const;
+
+    private:
+
+         // classification passes
+         void classifyScalar(const char *text, int startPos, int endPos);
+         void classifyBlock(const char *text, int word);
+
+         // search helpers
+         int nextMatch(int currentPos, bool in_quotes) const;
+         unsigned long long matchBits(int word, bool in_quotes) const;
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         // length of the line that was classified
+         int text_size;
+
+         // one bit per char, char i is bit (i % 64) of masks[i / 64]
+         struct MaskWord {
+            unsigned long long sep_bits;
+            unsigned long long space_bits;
+            unsigned long long pipe_bits;
+            unsigned long long quote_bits;
+            unsigned long long glob_bits;
+            unsigned long long escape_bits;
+         };
+
+         vector<MaskWord> masks;
+};
+
+#endif
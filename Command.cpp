@@ -1,598 +1,816 @@
-/* file: Command.cpp
-   
-   Command Class Implementation File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the data and functions
-   needed for storing and parsing command lines.
-   
-*/
-
-#include "Command.h"
-
-using namespace std;
-
-/******************************************************
-   This is the basic constructor for the class.
-   
-   POST: All of the string vars are initialized to "none".
-*/
-Command::Command() {
-   
-   // set flags
-   input_redirect = false;
-   output_redirect = false;
-   background_job = false;
-   piped_job = false;
-   
-   // init data to "none"
-   command_text = "none";
-   cmd_name = "none";
-   input_file = "none";
-   output_file = "none";
-   error_reason = "none";
-}
-
-/******************************************************
-   This is the constructor for commands that are part
-   of a larger piped job. 
-   
-   PRE:  pipe_me is any string.
-   
-   POST: All of the string vars are initialized to "none".
-         If the passed string pipe_me equal "pipe", then 
-         the command will be set up to belong to a larger
-         PipedCommand object.
-*/
-Command::Command(string pipe_me) {
-   
-   // set flags
-   input_redirect = false;
-   output_redirect = false;
-   background_job = false;
-   
-   if ("pipe" == pipe_me) {
-      piped_job = true;
-   } else {
-      piped_job = false;
-   }
-   
-   // init data to "none"
-   command_text = "none";
-   cmd_name = "none";
-   input_file = "none";
-   output_file = "none";
-   error_reason = "none";
-}
-
-/******************************************************
-   Sets the command text variable.
-   
-   PRE:  new_cmd_text is a string containing the new
-         command line
-         
-   POST: command_text is replaced with the new string
-*/
-void Command::setCommandText(string new_cmd_text) {
-   
-   command_text = new_cmd_text;
-}
-
-/******************************************************
-   Returns the command text variable.
-   
-   POST: A string containing the text of the command
-         line is returned.
-*/
-string Command::getCommandText() const {
-   
-   return command_text;
-}
-
-/******************************************************
-   Returns the reason the command couldn't be parsed.
-
-   POST: If command couldn't be parsed, returns a string
-         containing the reason.
-         If command was parsed successfully or has not
-         been parsed at all, returns "none".
-*/
-string Command::getErrorReason() const {
-   return error_reason;  
-}
-
-/******************************************************
-   Returns the name of the executable for the command.
-
-   POST: cmd_name is returned.
-*/
-string Command::getCommandName() const {
-   return cmd_name;
-}
-
-/******************************************************
-   Returns the name of the file that input should
-   be redirected to.
-
-   POST: input_file is returned.
-*/
-string Command::getInputFileName() const {
-   return input_file;
-}
-
-/******************************************************
-   Returns the name of the file that output should
-   be redirected to.
-
-   POST: output_file is returned.
-*/
-string Command::getOutputFileName() const {
-   return output_file;
-}
-
-/******************************************************
-   Returns the vector that contains all of the command
-   arguments.
-   
-   POST: cmd_arguments is returned.
-*/
-vector<string> Command::getArgs() const {
-   return cmd_arguments;
-}
-
-/******************************************************
-   Returns a pointer to an array of pointers to null
-   terminated character arrays containing the command
-   arguments. This data structure is appropriate for
-   use with the execv() system call.
-   
-   PRE:  The command has been parsed.
-   
-   POST: The pointer to the dynamically allocated
-         array is returned. 
-*/
-char ** Command::getArgsArray() {
-   
-   // figure out how big array should be
-   int array_size = cmd_arguments.size();
-   array_size += 2; // argv[0] is command, last entry is NULL
-   
-   char **argv = new char*[array_size]; 
-   
-   // convert command name to null terminated char array
-   // and save into argv array
-   // THIS IS UGLY BECAUSE CSTRINGS SUCK!
-   argv[0] = NULL;
-   argv[0] = new char[cmd_name.size() + 1];
-   strcpy(argv[0], cmd_name.c_str());
-   
-   // put all of the arguments in vector into array
-   for (int arg_ctr = 1; arg_ctr < (array_size-1); arg_ctr++) {
-      
-      // get string from vector
-      int vector_ctr = arg_ctr - 1;
-      string current_arg = cmd_arguments[vector_ctr];
-      
-      // convert to cstring and save into argv array
-      argv[arg_ctr] = NULL;
-      argv[arg_ctr] = new char[current_arg.size() + 1];
-      strcpy(argv[arg_ctr], current_arg.c_str());
-   }
-   
-   argv[array_size-1] = NULL;
-   
-   return argv;
-}
-
-/******************************************************
-   Returns whether the command will have its input
-   redirected to a file instead of std input.
-   
-   POST: Returns true if the input is redirected.
-         Returns false if it is not.
-*/
-bool Command::isInputRedirected() const{
-   return input_redirect;
-}
-
-/******************************************************
-   Returns whether the command will have its output
-   redirected to a file instead of std out.
-   
-   POST: Returns true if the output is redirected.
-         Returns false if it is not.
-*/
-bool Command::isOutputRedirected() const {
-   return output_redirect;
-}
-
-/******************************************************
-   Returns whether the command will execute as a
-   background job.
-   
-   POST: Returns true if the command is a background job.
-         Returns false if it is not.
-*/
-bool Command::isBackgroundJob() const {
-   return background_job;
-}
-
-
-/******************************************************
-   Returns whether the command is part of a larger
-   piped command object.
-   
-   POST: Returns true if the command will be piped.
-         Returns false if it won't be.
-*/
-bool Command::isPipedJob() const {
-   return piped_job;
-}
-
-/******************************************************
-   Takes the command text variable and parses it
-   into a command and its arguments by words.
-   
-   PRE:  command_text has been set.
-   
-   POST: A boolean is returned based on whether the
-         command was parsed correctly or not. If not,
-         the member variable error_reason is set to
-         the reason for the error. If the command was
-         parsed correctly, all of the data will be set
-         correctly and the member vector cmd_arguments
-         will contain the arguments of the command.
-*/
-bool Command::parseCommandText() {
-   
-   if (command_text == "") {
-      error_reason = "Empty command.";
-      return false;
-   }
-   
-   // check for unsupported features
-   string unsupported = checkForUnsupportedFeatures();
-   if (unsupported != "none") {
-      cout << "Warning:" << endl;
-      cout << "  Unsupported feature: " << unsupported << endl;
-   }
-   
-   // always start at the beginning of the string!
-   int currentPos = 0;
-   
-   // ignore leading spaces
-   currentPos = parseLeadingSpaces(currentPos);
-   
-   //check to make sure there's a command left
-   if (currentPos == command_text.size()) {
-      error_reason = "Empty command.";
-      return false;
-   }
-   
-   currentPos = parseCmdString(currentPos);
-   
-   // keep parsing until the end of the string, unless error
-   while (currentPos < command_text.size()) {
-       
-      if (command_text[currentPos] == ' ') { // skip space
-         currentPos++;
-         
-      } else if (command_text[currentPos] == '<') { // redirect input
-   
-         // check for piping, redirection is not allowed in a piped job
-         if (piped_job) {
-            error_reason = "Redirection is not supported for piped commands.";
-            return false;
-         }
-         
-         // check for multiple redirect statements
-         if (input_redirect) {
-            error_reason = "Too many input redirects.";
-            return false;
-         }
-         
-         input_redirect = true;
-         currentPos = parseInputFileString(currentPos);
-   
-      } else if (command_text[currentPos] == '>') { // redirect output
-   
-         // check for piping, redirection is not allowed in a piped job
-         if (piped_job) {
-            error_reason = "Redirection is not supported for piped commands.";
-            return false;
-         }
-         
-         // check for multiple redirect statements
-         if (output_redirect) {
-            error_reason = "Too many output redirects.";
-            return false;
-         }
-         
-         output_redirect = true;
-         currentPos = parseOutputFileString(currentPos);
-   
-      } else if (command_text[currentPos] == '&') { // background job
-            
-         // check for piping, pipes can't be executed in a background job
-         if (piped_job) {
-            error_reason = "Piped jobs cannot be run in the background.";
-            return false;
-         }
-         
-         background_job = true;
-         currentPos++;
-   
-      } else { // surely must be an argument to parse
-         
-         currentPos = parseArgString(currentPos);
-      }
-   }
-   
-   return true;
-}
-
-/******************************************************
-   Resets the entire object to its original state,
-   as if it had just been constructed.
-   
-   POST: Object is reset.
-*/
-void Command::resetCommand() {
-   
-   // set flags
-   input_redirect = false;
-   output_redirect = false;
-   background_job = false;
-   piped_job = false;
-   
-   // init data to "none"
-   command_text = "none";
-   cmd_name = "none";
-   input_file = "none";
-   output_file = "none";
-   error_reason = "none";
-   
-   // clear vector
-   cmd_arguments.clear();
-}
-
-/******************************************************
-   Check to see if the user is using unsupported
-   features. These include:
-      - single and double quotes
-      - the '*' operator
-      - the '?' operator
-      - the '~' operator
-      - escape characters
-   
-   PRE:   The string 'command_text' has been set.
-   
-   POST:  Returns a string containing the name of
-          the unsupported feature.  If none found,
-          returns "none".
-           
-*/
-string Command::checkForUnsupportedFeatures() {
-   
-   int currentPos = 0;
-   string unsupported = "none";
-   
-   while (currentPos < command_text.size()) {
-    
-      // double quotes
-      if (command_text[currentPos] == (char) 0x22)
-         unsupported = "quoted arguments";
-      
-      // single quotes
-      else if (command_text[currentPos] == (char) 0x27)
-         unsupported = "quoted arguments";
-         
-      // * operator
-      else if (command_text[currentPos] == (char) 0x2A)
-         unsupported = "wildcard characters";
-         
-      // ? operator
-      else if (command_text[currentPos] == (char) 0x3F)
-         unsupported = "wildcard characters";
-         
-      // ~ operator
-      else if (command_text[currentPos] == (char) 0x7E)
-         unsupported = "tilde for home directory";
-         
-      // escaped characters '\'
-      else if (command_text[currentPos] == (char) 0x5C)
-         unsupported = "escaped characters";
-      
-      currentPos++;
-   }
-      
-   return unsupported;
-}
-
-/******************************************************
-   Returns whether or not the char at position
-   'currentPos' is a word separator. Words are separated
-   by the following:
-      - ' ' (space)
-      - '>' (output redirect)
-      - '<' (input redirect)
-      - '&' (backgorund job)
-   
-   PRE:  The integer currentPos is the next char in
-         command_text to be read.
-   
-   POST:  Returns true if the char at position currentPos
-          is a word separator.
-*/
-bool Command::isSep(int currentPos) {
-   
-   if (command_text[currentPos] == ' ') {
-      return true;
-   } else if (command_text[currentPos] == '>') {
-      return true;
-   } else if (command_text[currentPos] == '<') {
-      return true;
-   } else if (command_text[currentPos] == '&') {
-      return true;
-   }
-   
-   // still here, must not be a separator
-   return false;
-}
-
-/******************************************************
-   Parses an entire command word, then skips the trailing
-   space.
-   
-   PRE:  The integer 'currentPos' is the next char in
-         the string 'command_text' to be read.
-   
-   POST: The command name is stored in the string 'cmd_name'.
-         Return value is next char in 'command_text' to be read.
-*/
-int Command::parseCmdString(int currentPos) {
-   
-   cmd_name = "";
-  
-   // everything up to space is the cmd name
-   while ((currentPos < command_text.size()) 
-          && 
-          (!isSep(currentPos))) 
-   {         
-      cmd_name += command_text[currentPos];
-      currentPos++;
-   }
-   
-   //return location of char directly after command word
-   return currentPos;
-}
-
-/******************************************************
-   Parses an entire command word, then skips the trailing
-   space.
-   
-   PRE:  The integer 'currentPos' is the next char in
-         the string 'command_text' to be read.
-   
-   POST: The argument word is stored in the next available
-         space in the arguments vector.
-         Return value is next char in 'command_text' to be read.
-*/
-int Command::parseArgString(int currentPos){
-   
-   bool firstChar = true;
-   int currentArg;
-   
-   // everything up to separator char is the argument word
-   while ((currentPos < command_text.size()) 
-          && 
-          (!isSep(currentPos)))
-   {
-      if (firstChar) {
-         
-         firstChar = false;
-         
-         // push a blank string onto the vector so we can
-         // add to the end of it
-         cmd_arguments.push_back("");
-         
-         // get address of newest arg
-         currentArg = cmd_arguments.size() - 1;
-      }
-            
-      cmd_arguments[currentArg] += command_text[currentPos];
-      currentPos++;
-   }
-   
-   // return location of char directly after argument word
-   return currentPos;
-}
-
-/******************************************************
-   Parses a redirect input command, from the beginning
-   '<' char all the way to skipping the trailing space
-   
-   PRE:  The integer currentPos is the next char in
-         command_text to be read, the '<' char.
-   
-   POST: The input file name is stored in the string 'input_file'.
-         Return value is next char in the string 'command_text'
-         to be read.
-*/
-int Command::parseInputFileString(int currentPos) {
-   
-   input_file = "";
-   
-   // skip past < char
-   currentPos++;
-   
-   // get to file name
-   currentPos = parseLeadingSpaces(currentPos);
-  
-   // everything up to separator char is the file name
-   while ((currentPos < command_text.size()) 
-          && 
-          (!isSep(currentPos))) 
-   {         
-      input_file += command_text[currentPos];
-      currentPos++;
-   }
-   
-   // return location of char directly after filename
-   return currentPos;
-}
-
-/******************************************************
-   Parses a redirect output command, from the beginning
-   '>' char all the way to skipping the trailing space
-   
-   PRE:  The integer currentPos is the next char in
-         command_text to be read, the '>' char.
-   
-   POST: The output file name is stored in the string 'output_file'.
-         Return value is next char in the string 'command_text'
-         to be read.
-*/
-int Command::parseOutputFileString(int currentPos) {
-   
-   output_file = "";
-   
-   // skip past > char
-   currentPos++;
-   
-   // get to file name
-   currentPos = parseLeadingSpaces(currentPos);
-  
-   // everything up to separator char is the file name
-   while ((currentPos < command_text.size()) 
-          && 
-          (!isSep(currentPos))) 
-   {         
-      output_file += command_text[currentPos];
-      currentPos++;
-   }
-   
-   // return location of char directly after filename
-   return currentPos;
-}
-
-/******************************************************
-   Removes the leading spaces from the string 'command_text'
-   starting from currentPos
-   
-   PRE:  The integer currentPos is the next char in
-         command_text to be read.
-   
-   POST:  The value of currentPos is the next char that
-          isn't a space. 
-*/
-int Command::parseLeadingSpaces(int currentPos) {
-   
-   while (command_text[currentPos] == ' ')
-      currentPos++;
-      
-   return currentPos;
-   
-}
+/* file: Command.cpp
+   
+   Command Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the data and functions
+   needed for storing and parsing command lines.
+   
+*/
+
+#include "Command.h"
+
+using namespace std;
+
+/******************************************************
+   This is the basic constructor for the class.
+   
+   POST: All of the string vars are initialized to "none"
+         and none of the word spans are set.
+*/
+Command::Command() {
+   
+   // set flags
+   input_redirect = false;
+   output_redirect = false;
+   background_job = false;
+   piped_job = false;
+   
+   // init data to "none"
+   command_text = "none";
+   error_reason = "none";
+   unsupported_feature = "none";
+   
+   // no words found yet
+   cmd_name.start = -1;
+   input_file.start = -1;
+   output_file.start = -1;
+   arg_ptrs.clear();
+}
+
+/******************************************************
+   This is the constructor for commands that are part
+   of a larger piped job. 
+   
+   PRE:  pipe_me is any string.
+   
+   POST: All of the string vars are initialized to "none"
+         and none of the word spans are set.
+         If the passed string pipe_me equal "pipe", then 
+         the command will be set up to belong to a larger
+         PipedCommand object.
+*/
+Command::Command(string pipe_me) {
+   
+   // set flags
+   input_redirect = false;
+   output_redirect = false;
+   background_job = false;
+   
+   if ("pipe" == pipe_me) {
+      piped_job = true;
+   } else {
+      piped_job = false;
+   }
+   
+   // init data to "none"
+   command_text = "none";
+   error_reason = "none";
+   unsupported_feature = "none";
+   
+   // no words found yet
+   cmd_name.start = -1;
+   input_file.start = -1;
+   output_file.start = -1;
+   arg_ptrs.clear();
+}
+
+/******************************************************
+   This is the copy constructor for the class.
+   
+   POST: This object is a copy of other. The argument
+         array points into this object's own arena.
+         The scratch char_map is not copied.
+*/
+Command::Command(const Command &other)
+   : command_text(other.command_text),
+     cmd_name(other.cmd_name),
+     input_file(other.input_file),
+     output_file(other.output_file),
+     error_reason(other.error_reason),
+     unsupported_feature(other.unsupported_feature),
+     cmd_arguments(other.cmd_arguments),
+     word_chars(other.word_chars),
+     arg_ptrs(other.arg_ptrs)
+{
+   input_redirect = other.input_redirect;
+   output_redirect = other.output_redirect;
+   background_job = other.background_job;
+   piped_job = other.piped_job;
+   
+   moveArgPointers(other);
+}
+
+/******************************************************
+   Copies another command into this one. Buffers that
+   are already big enough are reused.
+   
+   POST: This object is a copy of other. The argument
+         array points into this object's own arena.
+*/
+Command & Command::operator=(const Command &other) {
+   
+   if (this == &other)
+      return *this;
+   
+   input_redirect = other.input_redirect;
+   output_redirect = other.output_redirect;
+   background_job = other.background_job;
+   piped_job = other.piped_job;
+   
+   command_text = other.command_text;
+   cmd_name = other.cmd_name;
+   input_file = other.input_file;
+   output_file = other.output_file;
+   error_reason = other.error_reason;
+   unsupported_feature = other.unsupported_feature;
+   cmd_arguments = other.cmd_arguments;
+   word_chars = other.word_chars;
+   arg_ptrs = other.arg_ptrs;
+   
+   moveArgPointers(other);
+   
+   return *this;
+}
+
+/******************************************************
+   Sets the command text variable.
+   
+   PRE:  new_cmd_text is a string containing the new
+         command line
+         
+   POST: command_text is replaced with the new string.
+         Any words that were parsed out of the old text
+         are forgotten.
+*/
+void Command::setCommandText(const string &new_cmd_text) {
+   
+   command_text = new_cmd_text;
+   
+   cmd_name.start = -1;
+   input_file.start = -1;
+   output_file.start = -1;
+   cmd_arguments.clear();
+   arg_ptrs.clear();
+}
+
+/******************************************************
+   Returns the command text variable.
+   
+   POST: A string containing the text of the command
+         line is returned.
+*/
+const string & Command::getCommandText() const {
+   
+   return command_text;
+}
+
+/******************************************************
+   Returns the reason the command couldn't be parsed.
+
+   POST: If command couldn't be parsed, returns a string
+         containing the reason.
+         If command was parsed successfully or has not
+         been parsed at all, returns "none".
+*/
+const string & Command::getErrorReason() const {
+   return error_reason;  
+}
+
+/******************************************************
+   Returns the unsupported feature found by the last parse.
+
+   POST: unsupported_feature is returned.
+*/
+const string & Command::getUnsupportedFeature() const {
+   return unsupported_feature;
+}
+
+/******************************************************
+   Returns the name of the executable for the command.
+
+   POST: The cmd_name word is returned, or "none" if
+         it hasn't been parsed.
+*/
+string Command::getCommandName() const {
+   return spanToString(cmd_name);
+}
+
+/******************************************************
+   Checks the name of the executable without building
+   a string for it. The name is already null terminated
+   at the front of the argument arena.
+
+   POST: Returns true if the command has been parsed and
+         its name is name.
+*/
+bool Command::hasCommandName(const char *name) const {
+   
+   if (arg_ptrs.empty())
+      return false;
+   
+   return strcmp(arg_ptrs[0], name) == 0;
+}
+
+/******************************************************
+   Returns the name of the file that input should
+   be redirected to.
+
+   POST: The input_file word is returned, or "none" if
+         it hasn't been parsed.
+*/
+string Command::getInputFileName() const {
+   return spanToString(input_file);
+}
+
+/******************************************************
+   Returns the name of the file that output should
+   be redirected to.
+
+   POST: The output_file word is returned, or "none" if
+         it hasn't been parsed.
+*/
+string Command::getOutputFileName() const {
+   return spanToString(output_file);
+}
+
+/******************************************************
+   Returns the input file name as a C string in the
+   word arena, where the lexer put a '\0' after it.
+
+   POST: Returns NULL if input isn't redirected.
+*/
+const char * Command::getInputFilePath() const {
+
+   if (input_file.start == -1)
+      return NULL;
+
+   return &word_chars[input_file.start];
+}
+
+/******************************************************
+   Returns the output file name as a C string in the
+   word arena.
+
+   POST: Returns NULL if output isn't redirected.
+*/
+const char * Command::getOutputFilePath() const {
+
+   if (output_file.start == -1)
+      return NULL;
+
+   return &word_chars[output_file.start];
+}
+
+/******************************************************
+   Returns the vector that holds where all of the
+   command arguments are in word_chars.
+   
+   POST: cmd_arguments is returned.
+*/
+const vector<WordSpan> & Command::getArgs() const {
+   return cmd_arguments;
+}
+
+/******************************************************
+   Returns the number of arguments the command has,
+   not counting the command name.
+   
+   POST: The size of cmd_arguments is returned.
+*/
+int Command::getArgCount() const {
+   return cmd_arguments.size();
+}
+
+/******************************************************
+   Returns a single command argument.
+   
+   PRE:  0 <= arg_index < getArgCount()
+   
+   POST: The argument word at arg_index is returned.
+*/
+string Command::getArg(int arg_index) const {
+   return spanToString(cmd_arguments[arg_index]);
+}
+
+/******************************************************
+   Returns a pointer to an array of pointers to null
+   terminated character arrays containing the command
+   arguments. This data structure is appropriate for
+   use with the execv() system call. The array was laid
+   out by the parser, so nothing is allocated here.
+   
+   PRE:  The command has been parsed.
+   
+   POST: The pointer to the argument array is returned.
+         It stays good until this object is parsed again,
+         reset, or destroyed. Returns NULL if the command
+         hasn't been parsed.
+*/
+char * const * Command::getArgsArray() const {
+   
+   if (arg_ptrs.empty())
+      return NULL;
+   
+   return &arg_ptrs[0];
+}
+
+/******************************************************
+   Returns whether the command will have its input
+   redirected to a file instead of std input.
+   
+   POST: Returns true if the input is redirected.
+         Returns false if it is not.
+*/
+bool Command::isInputRedirected() const{
+   return input_redirect;
+}
+
+/******************************************************
+   Returns whether the command will have its output
+   redirected to a file instead of std out.
+   
+   POST: Returns true if the output is redirected.
+         Returns false if it is not.
+*/
+bool Command::isOutputRedirected() const {
+   return output_redirect;
+}
+
+/******************************************************
+   Returns whether the command will execute as a
+   background job.
+   
+   POST: Returns true if the command is a background job.
+         Returns false if it is not.
+*/
+bool Command::isBackgroundJob() const {
+   return background_job;
+}
+
+
+/******************************************************
+   Returns whether the command is part of a larger
+   piped command object.
+   
+   POST: Returns true if the command will be piped.
+         Returns false if it won't be.
+*/
+bool Command::isPipedJob() const {
+   return piped_job;
+}
+
+/******************************************************
+   Returns whether the command is a fan-out branch that
+   only writes to a file.
+   
+   POST: Returns true if there is an output file but no
+         command name.
+*/
+bool Command::isFileStage() const {
+   return output_redirect && (cmd_name.start == -1);
+}
+
+/******************************************************
+   Takes the command text variable and parses it
+   into a command and its arguments by words.
+   
+   PRE:  command_text has been set.
+   
+   POST: A boolean is returned based on whether the
+         command was parsed correctly or not. If not,
+         the member variable error_reason is set to
+         the reason for the error. If the command was
+         parsed correctly, all of the data will be set
+         correctly and the member vector cmd_arguments
+         will contain the arguments of the command.
+*/
+bool Command::parseCommandText() {
+   
+   // always start at the beginning of the string!
+   int currentPos = 0;
+   
+   // find all of the special chars in one go
+   char_map.classify(command_text);
+   
+   if (!parseWords(command_text, char_map, currentPos))
+      return false;
+   
+   // a lone command can't contain pipes or command lists,
+   // PipedCommand and CommandList handle those
+   if (currentPos < command_text.size()) {
+      
+      if ((command_text[currentPos] == '|') && (command_text[currentPos + 1] != '|'))
+         error_reason = "Unexpected pipe.";
+      else
+         error_reason = "Unexpected command separator.";
+      
+      return false;
+   }
+   
+   buildArgsArray();
+   
+   return true;
+}
+
+/******************************************************
+   Parses one stage of a piped command line directly out
+   of the whole line, so the line doesn't need to be cut
+   up into separate strings first.
+   
+   PRE:  line is a piped command line and map has been
+         classified from it. currentPos is the first char
+         of this stage in line.
+   
+   POST: Returns the same as parseCommandText(). The text
+         of this stage is copied into command_text. currentPos
+         is left on the '|' that ended the stage, or at the
+         end of line if this is the last stage.
+*/
+bool Command::parsePipeStage(const string &line, const CharMap &map, int &currentPos) {
+   
+   int stage_start = currentPos;
+   
+   bool parsed = parseWords(line, map, currentPos);
+   
+   // keep our own copy of the stage for printing jobs
+   command_text.assign(line, stage_start, currentPos - stage_start);
+   
+   if (parsed)
+      buildArgsArray();
+   
+   return parsed;
+}
+
+/******************************************************
+   Parses a fan-out branch made of nothing but a '>'
+   and a file name. There's no command to run, so no
+   argument array is laid out.
+   
+   PRE:  map has been classified from line. currentPos
+         is the first char of this stage in line, and
+         the stage starts with a '>' char.
+   
+   POST: Returns the same as parsePipeStage(), and the
+         output file is set if it worked.
+*/
+bool Command::parseFileStage(const string &line, const CharMap &map, int &currentPos) {
+   
+   int stage_start = currentPos;
+   
+   currentPos = parseLeadingSpaces(map, currentPos);
+   word_chars.clear();
+   
+   Lexer lexer(line, map, currentPos, word_chars);
+   WordSpan word;
+   TokenType token = lexer.nextToken(word);
+   bool parsed = false;
+   
+   if (token == TOKEN_OUTPUT) {
+      
+      token = lexer.nextToken(output_file);
+      
+      if (token == TOKEN_WORD) {
+         output_redirect = true;
+         token = lexer.nextToken(word);
+      } else if (token != TOKEN_ERROR) {
+         error_reason = "Missing output file name.";
+      }
+   }
+   
+   if (output_redirect) {
+      
+      if (endsCommand(token))
+         parsed = true;
+      else if (token == TOKEN_BACKGROUND)
+         error_reason = "Piped jobs cannot be run in the background.";
+      else if (token != TOKEN_ERROR)
+         error_reason = "Unexpected word after fan-out file.";
+   }
+   
+   if (token == TOKEN_ERROR)
+      error_reason = lexer.getErrorReason();
+   
+   currentPos = lexer.getPosition();
+   unsupported_feature = lexer.getUnsupportedFeature();
+   
+   // keep our own copy of the stage for printing jobs
+   command_text.assign(line, stage_start, currentPos - stage_start);
+   
+   return parsed;
+}
+
+/******************************************************
+   Resets the entire object to its original state,
+   as if it had just been constructed.
+   
+   POST: Object is reset.
+*/
+void Command::resetCommand() {
+   
+   // set flags
+   input_redirect = false;
+   output_redirect = false;
+   background_job = false;
+   piped_job = false;
+   
+   // init data to "none"
+   command_text = "none";
+   error_reason = "none";
+   unsupported_feature = "none";
+   
+   // no words found yet
+   cmd_name.start = -1;
+   input_file.start = -1;
+   output_file.start = -1;
+   arg_ptrs.clear();
+   
+   // clear vector, keeps its capacity for the next line
+   cmd_arguments.clear();
+}
+
+/******************************************************
+   Takes the command name off so the first argument is
+   the name. The words stay where they are in the
+   arena, only the spans and argument array change.
+   
+   PRE:  The command has been parsed.
+   
+   POST: Returns false and sets error_reason if there
+         are no arguments.
+*/
+bool Command::dropCommandName() {
+   
+   if (cmd_arguments.empty()) {
+      error_reason = "Missing command name.";
+      return false;
+   }
+   
+   cmd_name = cmd_arguments[0];
+   cmd_arguments.erase(cmd_arguments.begin());
+   
+   buildArgsArray();
+   
+   return true;
+}
+
+/******************************************************
+   Parses the words of a command out of text, starting
+   at currentPos and stopping at the end of text or at
+   a '|', ';', '&&' or '||' outside of quotes, or just
+   after a '&', whichever comes first.
+   The lexer puts the unquoted words in word_chars and
+   the parsed words are recorded as spans into it.
+   
+   PRE:  currentPos is the first char of the command
+         in text, map has been classified from text.
+   
+   POST: Returns true if the command was parsed correctly,
+         otherwise error_reason is set and false is returned.
+         currentPos is the next char in text to be read.
+*/
+bool Command::parseWords(const string &text, const CharMap &map, int &currentPos) {
+   
+   // ignore leading spaces
+   currentPos = parseLeadingSpaces(map, currentPos);
+   
+   // keeps its capacity, so parsing again doesn't allocate
+   word_chars.clear();
+   
+   Lexer lexer(text, map, currentPos, word_chars);
+   WordSpan word;
+   TokenType token = lexer.nextToken(word);
+   
+   //check to make sure there's a command left
+   if (endsCommand(token)) {
+      currentPos = lexer.getPosition();
+      error_reason = "Empty command.";
+      return false;
+   }
+   
+   // the first word is the command name
+   if (token == TOKEN_WORD) {
+      cmd_name = word;
+      token = lexer.nextToken(word);
+   } else if (token != TOKEN_ERROR) {
+      currentPos = lexer.getPosition();
+      error_reason = "Missing command name.";
+      return false;
+   }
+   
+   // keep parsing until the end of the command, unless error
+   while (!endsCommand(token)) {
+      
+      if (token == TOKEN_ERROR) { // unfinished quote or escape
+         
+         currentPos = lexer.getPosition();
+         error_reason = lexer.getErrorReason();
+         return false;
+         
+      } else if (token == TOKEN_INPUT) { // redirect input
+         
+         if (!parseRedirect(lexer, input_redirect, input_file, "input")) {
+            currentPos = lexer.getPosition();
+            return false;
+         }
+         
+      } else if (token == TOKEN_OUTPUT) { // redirect output
+         
+         if (!parseRedirect(lexer, output_redirect, output_file, "output")) {
+            currentPos = lexer.getPosition();
+            return false;
+         }
+         
+      } else if (token == TOKEN_BACKGROUND) { // background job
+         
+         // check for piping, pipes can't be executed in a background job
+         if (piped_job) {
+            currentPos = lexer.getPosition();
+            error_reason = "Piped jobs cannot be run in the background.";
+            return false;
+         }
+         
+         // the '&' ends the command, like a ';' would
+         background_job = true;
+         break;
+         
+      } else { // surely must be an argument
+         
+         cmd_arguments.push_back(word);
+      }
+      
+      token = lexer.nextToken(word);
+   }
+   
+   currentPos = lexer.getPosition();
+   
+   // the shell warns about features it can't handle
+   unsupported_feature = lexer.getUnsupportedFeature();
+   
+   return true;
+}
+
+/******************************************************
+   Checks whether a token is the end of a command.
+   
+   POST: Returns true for the end of the line, a pipe,
+         or a command list operator.
+*/
+bool Command::endsCommand(TokenType token) {
+   
+   return (token == TOKEN_END) || (token == TOKEN_PIPE) || (token == TOKEN_SEMICOLON) ||
+          (token == TOKEN_AND) || (token == TOKEN_OR);
+}
+
+/******************************************************
+   Parses the file name after a '<' or '>' char.
+   
+   PRE:  The lexer just read the '<' or '>' char. which
+         is "input" or "output", for the error messages.
+   
+   POST: Returns true and sets redirect and file_name if
+         the redirect is allowed and has a file name.
+         Otherwise error_reason is set and false is
+         returned.
+*/
+bool Command::parseRedirect(Lexer &lexer, bool &redirect, WordSpan &file_name, const char *which) {
+   
+   // check for piping, redirection is not allowed in a piped job
+   if (piped_job) {
+      error_reason = "Redirection is not supported for piped commands.";
+      return false;
+   }
+   
+   // check for multiple redirect statements
+   if (redirect) {
+      error_reason = string("Too many ") + which + " redirects.";
+      return false;
+   }
+   
+   redirect = true;
+   
+   TokenType token = lexer.nextToken(file_name);
+   
+   if (token == TOKEN_ERROR) {
+      error_reason = lexer.getErrorReason();
+      return false;
+   }
+   
+   if (token != TOKEN_WORD) {
+      error_reason = string("Missing ") + which + " file name.";
+      return false;
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Turns a command that was parsed as a lone command
+   into one that is part of a larger piped command, and
+   checks that it doesn't use anything pipes can't.
+   
+   POST: Returns true if the command can be piped.
+         Otherwise error_reason is set and false is
+         returned.
+*/
+bool Command::makePipedJob() {
+   
+   piped_job = true;
+   
+   // redirection is not allowed in a piped job
+   if (input_redirect || output_redirect) {
+      error_reason = "Redirection is not supported for piped commands.";
+      return false;
+   }
+   
+   // pipes can't be executed in a background job
+   if (background_job) {
+      error_reason = "Piped jobs cannot be run in the background.";
+      return false;
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Lays out the exec argument array. The lexer already
+   wrote every word into word_chars as a null terminated
+   string, so arg_ptrs only has to point at the command
+   name and each argument and end with NULL. The buffer
+   keeps its capacity, so a reused object only allocates
+   when a line is bigger than any line before it.
+   
+   PRE:  The command has been parsed and the spans
+         point into word_chars.
+   
+   POST: getArgsArray() returns the finished array.
+*/
+void Command::buildArgsArray() {
+   
+   int num_words = cmd_arguments.size() + 1; // argv[0] is command
+   
+   arg_ptrs.resize(num_words + 1); // last entry is NULL
+   
+   arg_ptrs[0] = &word_chars[cmd_name.start];
+   
+   for (int arg_ctr = 0; arg_ctr < cmd_arguments.size(); arg_ctr++) {
+      arg_ptrs[arg_ctr + 1] = &word_chars[cmd_arguments[arg_ctr].start];
+   }
+   
+   arg_ptrs[num_words] = NULL;
+}
+
+/******************************************************
+   Points the argument array at this object's arena
+   after the arena and array were copied from other.
+   
+   PRE:  word_chars and arg_ptrs were just copied from
+         other.
+   
+   POST: Every entry of arg_ptrs points to the same
+         place in word_chars that it pointed to in other.
+*/
+void Command::moveArgPointers(const Command &other) {
+   
+   for (int ptr_ctr = 0; ptr_ctr < arg_ptrs.size(); ptr_ctr++) {
+      
+      if (arg_ptrs[ptr_ctr] != NULL)
+         arg_ptrs[ptr_ctr] = &word_chars[0] + (other.arg_ptrs[ptr_ctr] - &other.word_chars[0]);
+   }
+}
+
+/******************************************************
+   Builds a string out of a word span.
+   
+   PRE:  word points into the current word_chars, or
+         was never set.
+   
+   POST: Returns the chars of word_chars covered by
+         word. Returns "none" if word was never set.
+*/
+string Command::spanToString(const WordSpan &word) const {
+   
+   if (word.start < 0)
+      return "none";
+   
+   return string(&word_chars[word.start], word.length);
+}
+
+/******************************************************
+   Removes the leading spaces from the text the map
+   was classified from, starting from currentPos
+   
+   PRE:  The integer currentPos is the next char in
+         text to be read.
+   
+   POST:  The value of currentPos is the next char that
+          isn't a space, or the length of text if the rest
+          of it is all spaces.
+*/
+int Command::parseLeadingSpaces(const CharMap &map, int currentPos) {
+   
+   return map.skipSpaces(currentPos);
+   
+}
@@ -1,260 +1,426 @@
-/* file: Command.h
-   
-   Command Class Header File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the data and functions
-   needed for storing and parsing command lines.
-   
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on constructors:                   !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   Command()
-   --------------------------------------------------
-      This is the basic constructor for the class.
-      
-      POST: The object has been initialized.
-      
-      
-   Command(string pipe_me)
-   --------------------------------------------------
-      This is the constructor for commands that are part
-      of a larger piped job. 
-      
-      PRE:  pipe_me is a string.
-      
-      POST: The object has been initialized.
-            If the passed string pipe_me equal "pipe",
-            then the command will be set up to belong
-            to a larger PipedCommand object.
-            
-            
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on public methods:                 !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   void setCommandText(string new_cmd_text)
-   --------------------------------------------------
-      Sets the command text of this object.
-   
-      PRE:  new_cmd_text is a string containing the text
-            of a command line.
-         
-      POST: new_cmd_text is now the value of this object's
-            command text.
-   
-   
-   string getCommandText() const
-   --------------------------------------------------
-      Returns the command text of this object.
-   
-      POST: A string containing the text of the command
-            line is returned.
-    
-      
-   string getErrorReason() const
-   --------------------------------------------------
-      Returns the reason the command couldn't be parsed.
-
-      POST: If command couldn't be parsed, returns a string
-            containing the reason. If command was parsed
-            successfully or has not been parsed at all,
-            returns "none".
-      
-      
-   string getCommandName() const
-   --------------------------------------------------
-      Returns the name of the executable for the command.
-
-      POST: Returns the name of the executable. Returns
-            "none" if the command hasn't been parsed.
-      
-      
-   string getInputFileName() const
-   --------------------------------------------------
-      Returns the name of the file that input should
-      be redirected to.
-
-      POST: Returns the filename. If the command has not
-            been parsed or is not input redirected,
-            "none" is returned.
-      
-      
-   string getOutputFileName() const
-   --------------------------------------------------
-      Returns the name of the file that output should
-      be redirected to.
-
-      POST: Returns the filename. If the command has not
-            been parsed or is not output redirected,
-            "none" is returned.
-      
-      
-   vector<string> getArgs() const
-   --------------------------------------------------
-      Returns the vector that contains all of the command
-      arguments.
-   
-      POST: Returns the vector. If the command has
-            not been parsed or the command has no
-            arguments, an empty vector is returned.
-      
-      
-   char ** getArgsArray()
-   --------------------------------------------------
-      Returns a pointer to an array of pointers to null
-      terminated character arrays containing the command
-      arguments. This data structure is appropriate for
-      use with the execv() system call.
-      
-      PRE:  The command has been parsed.
-      
-      POST: The pointer to the dynamically allocated
-            array is returned.
-   
-   
-   bool isInputRedirected() const
-   --------------------------------------------------
-      Returns whether the command will have its input
-      redirected to a file instead of std input.
-      
-      POST: Returns true if the input is redirected.
-            Returns false if it is not.
-      
-      
-   bool isOutputRedirected() const
-   --------------------------------------------------
-      Returns whether the command will have its output
-      redirected to a file instead of std out.
-      
-      POST: Returns true if the output is redirected.
-            Returns false if it is not.
-     
-      
-   bool isBackgroundJob() const
-   --------------------------------------------------
-      Returns whether the command will execute as a
-      background job.
-   
-      POST: Returns true if the command is a background
-            job. Returns false if it is not.
-     
-      
-   bool isPipedJob() const
-   --------------------------------------------------
-      Returns whether the command is part of a larger
-      PipedCommand object.
-   
-      POST: Returns true if the command will be piped.
-            Returns false if it won't be.
-   
-   
-   bool parseCommandText()
-   --------------------------------------------------
-      Takes the command line text of this object and
-      parses it into an executable word, arguments,
-      and redirects based on separator chars.
-   
-      PRE:  The command line text of this object has
-            been set.
-   
-      POST: A boolean is returned based on whether the
-            command was parsed correctly or not. If false
-            is returned, the reason is stored by this
-            object. If the command was parsed correctly
-            and true is returned, all of the data
-            will be set correctly and available using
-            the public "get" commands.
-    
-      
-   void resetCommand()
-   --------------------------------------------------
-      Resets the entire object to its original state,
-      as if it had just been constructed using the
-      basic constructor.
-   
-      POST: This object is reset.
-      
-*/
-
-#ifndef CMD_HEADER
-#define CMD_HEADER
-
-#include <string>
-#include <vector>
-#include <iostream>
-
-using namespace std;
-
-class Command {
-   
-    public:
-    
-         // constructors
-         Command();
-         Command(string pipe_me);
-         
-         // set functions
-         void setCommandText(string new_cmd_text);
-         
-         // get functions
-         string getCommandText() const;
-         string getErrorReason() const;
-         string getCommandName() const;
-         string getInputFileName() const;
-         string getOutputFileName() const;
-         vector<string> getArgs() const;
-         char ** getArgsArray();
-         
-         // bool functions that return special command options
-         bool isInputRedirected() const;
-         bool isOutputRedirected() const;
-         bool isBackgroundJob() const;
-         bool isPipedJob() const;
-         
-         // other functions
-         bool parseCommandText();
-         void resetCommand();
-         
-    
-    private:
-    
-         // checkers
-         string checkForUnsupportedFeatures();
-         bool isSep(int currentPos);
-         
-         // word parsing functions
-         int parseCmdString(int currentPos);
-         int parseArgString(int currentPos);
-         int parseInputFileString(int currentPos);
-         int parseOutputFileString(int currentPos);
-         int parseLeadingSpaces(int currentPos);
-    
-         //------------------------------------------------------------
-         // Data
-         //------------------------------------------------------------
-         
-         // special command option flags (input/output redirect & pipes)
-         bool input_redirect;
-         bool output_redirect;
-         bool background_job;
-         bool piped_job;
-         
-         // text of entire cmd line
-         string command_text;
-         
-         // parsed command data
-         string cmd_name;
-         string input_file;
-         string output_file;
-         string error_reason;
-         
-         // space for arguments
-         vector<string> cmd_arguments;
-};
-
-#endif
+/* file: Command.h
+   
+   Command Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the data and functions
+   needed for storing and parsing command lines.
+   
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   Command()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+      
+      POST: The object has been initialized.
+      
+      
+   Command(string pipe_me)
+   --------------------------------------------------
+      This is the constructor for commands that are part
+      of a larger piped job. 
+      
+      PRE:  pipe_me is a string.
+      
+      POST: The object has been initialized.
+            If the passed string pipe_me equal "pipe",
+            then the command will be set up to belong
+            to a larger PipedCommand object.
+            
+            
+   Command(const Command &other)
+   Command & operator=(const Command &other)
+   --------------------------------------------------
+      Copies another command. The copy gets its own
+      argument arena, so it can outlive other.
+      
+      
+   Command(Command &&other)
+   Command & operator=(Command &&other)
+   --------------------------------------------------
+      Moves another command into this one without copying
+      any of its buffers. The argument array moves along
+      with its arena. other is left empty.
+            
+            
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   void setCommandText(const string &new_cmd_text)
+   --------------------------------------------------
+      Sets the command text of this object.
+   
+      PRE:  new_cmd_text is a string containing the text
+            of a command line.
+         
+      POST: new_cmd_text is now the value of this object's
+            command text.
+   
+   
+   const string & getCommandText() const
+   --------------------------------------------------
+      Returns the command text of this object.
+   
+      POST: A string containing the text of the command
+            line is returned.
+    
+      
+   const string & getErrorReason() const
+   --------------------------------------------------
+      Returns the reason the command couldn't be parsed.
+
+      POST: If command couldn't be parsed, returns a string
+            containing the reason. If command was parsed
+            successfully or has not been parsed at all,
+            returns "none".
+      
+      
+   const string & getUnsupportedFeature() const
+   --------------------------------------------------
+      Returns the name of an unsupported feature (like
+      wildcards) that the command uses. The
+      shell warns the user about it.
+
+      POST: Returns the name of the feature found by the
+            last parse, or "none" if there wasn't one.
+      
+      
+   string getCommandName() const
+   --------------------------------------------------
+      Returns the name of the executable for the command.
+
+      POST: Returns the name of the executable. Returns
+            "none" if the command hasn't been parsed.
+      
+      
+   bool hasCommandName(const char *name) const
+   --------------------------------------------------
+      Checks the name of the executable without building
+      a string for it.
+      
+      POST: Returns true if the command has been parsed
+            and its name is name.
+      
+      
+   string getInputFileName() const
+   --------------------------------------------------
+      Returns the name of the file that input should
+      be redirected to.
+
+      POST: Returns the filename. If the command has not
+            been parsed or is not input redirected,
+            "none" is returned.
+      
+      
+   string getOutputFileName() const
+   --------------------------------------------------
+      Returns the name of the file that output should
+      be redirected to.
+
+      POST: Returns the filename. If the command has not
+            been parsed or is not output redirected,
+            "none" is returned.
+      
+      
+   const char * getInputFilePath() const
+   const char * getOutputFilePath() const
+   --------------------------------------------------
+      Return the redirect file names straight out of
+      the word arena, ready to be passed to open().
+      
+      POST: Returns NULL if the command isn't redirected
+            that way. The pointer stays good until the
+            command is parsed again or destroyed.
+      
+      
+   const vector<WordSpan> & getArgs() const
+   --------------------------------------------------
+      Returns the vector that holds where all of the
+      command arguments are in this object's word arena.
+   
+      POST: Returns the vector of spans. Use getArg() for
+            the text of an argument. If the command has not
+            been parsed or the command has no arguments, an
+            empty vector is returned.
+      
+      
+   int getArgCount() const
+   --------------------------------------------------
+      Returns the number of arguments the command has,
+      not counting the command name.
+      
+      POST: Returns the number of arguments. Returns 0 if
+            the command has not been parsed.
+      
+      
+   string getArg(int arg_index) const
+   --------------------------------------------------
+      Returns a single command argument without building
+      the whole argument vector.
+      
+      PRE:  0 <= arg_index < getArgCount()
+      
+      POST: Returns the argument at position arg_index.
+      
+      
+   char * const * getArgsArray() const
+   --------------------------------------------------
+      Returns a pointer to an array of pointers to null
+      terminated character arrays containing the command
+      arguments. This data structure is appropriate for
+      use with the execv() system call. The array is laid
+      out once by the parser in a single arena owned by
+      this object, so it's free to call this and nothing
+      needs to be deleted.
+      
+      PRE:  The command has been parsed.
+      
+      POST: The pointer to the array is returned. It stays
+            good until this object is parsed again, reset,
+            or destroyed. NULL is returned if the command
+            hasn't been parsed.
+   
+   
+   bool isInputRedirected() const
+   --------------------------------------------------
+      Returns whether the command will have its input
+      redirected to a file instead of std input.
+      
+      POST: Returns true if the input is redirected.
+            Returns false if it is not.
+      
+      
+   bool isOutputRedirected() const
+   --------------------------------------------------
+      Returns whether the command will have its output
+      redirected to a file instead of std out.
+      
+      POST: Returns true if the output is redirected.
+            Returns false if it is not.
+     
+      
+   bool isBackgroundJob() const
+   --------------------------------------------------
+      Returns whether the command will execute as a
+      background job.
+   
+      POST: Returns true if the command is a background
+            job. Returns false if it is not.
+     
+      
+   bool isPipedJob() const
+   --------------------------------------------------
+      Returns whether the command is part of a larger
+      PipedCommand object.
+   
+      POST: Returns true if the command will be piped.
+            Returns false if it won't be.
+   
+   
+   bool isFileStage() const
+   --------------------------------------------------
+      Returns whether this is a fan-out branch that only
+      writes to a file, parsed by parseFileStage().
+      
+      POST: Returns true if there is no command, only an
+            output file. The argument array is NULL.
+   
+   
+   bool parseCommandText()
+   --------------------------------------------------
+      Takes the command line text of this object and
+      parses it into an executable word, arguments,
+      and redirects based on separator chars. Single
+      quotes, double quotes and backslash escapes work
+      like they do in sh and are taken out of the words.
+   
+      PRE:  The command line text of this object has
+            been set.
+   
+      POST: A boolean is returned based on whether the
+            command was parsed correctly or not. If false
+            is returned, the reason is stored by this
+            object. If the command was parsed correctly
+            and true is returned, all of the data
+            will be set correctly and available using
+            the public "get" commands. Lone commands
+            can't contain '|', ';', '&&' or '||' outside
+            of quotes, and '&' has to be at the end.
+   
+   
+   bool parsePipeStage(const string &line, const CharMap &map, int &currentPos)
+   --------------------------------------------------
+      Parses the part of a piped command line that
+      starts at currentPos and ends at the next '|',
+      ';', '&&' or '||' outside of quotes, just after a
+      '&', or at the end of the line.
+      
+      PRE:  map has been classified from line.
+            currentPos is the first char of the stage
+            in line.
+      
+      POST: Returns the same as parseCommandText(). The
+            text of the stage becomes the command text of
+            this object. currentPos is left on the operator
+            that ended the stage, just after the '&', or at
+            the end of line.
+   
+   
+   bool parseFileStage(const string &line, const CharMap &map, int &currentPos)
+   --------------------------------------------------
+      Parses a fan-out branch that is just "> file",
+      the same way parsePipeStage() parses a command.
+      
+      PRE:  map has been classified from line. The next
+            thing at currentPos is a '>' char.
+      
+      POST: Returns false and stores the reason if there
+            isn't a file name, or there is more after it.
+            Otherwise the file is the output file name.
+   
+   
+   bool makePipedJob()
+   --------------------------------------------------
+      Marks a command that has already been parsed as
+      part of a larger PipedCommand object.
+      
+      POST: Returns true if the command can be piped.
+            Returns false and stores the reason if it
+            uses redirection or is a background job.
+    
+      
+   bool dropCommandName()
+   --------------------------------------------------
+      Takes the command name off of a parsed command,
+      so the first argument becomes the name. Used for
+      words like PIPESIZE= that go in front of the real
+      command.
+      
+      POST: Returns false and stores the reason if there
+            is no argument to take the name's place.
+   
+   
+   void resetCommand()
+   --------------------------------------------------
+      Resets the entire object to its original state,
+      as if it had just been constructed using the
+      basic constructor.
+   
+      POST: This object is reset.
+      
+*/
+
+#ifndef CMD_HEADER
+#define CMD_HEADER
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstring>
+#include "Lexer.h"
+
+using namespace std;
+
+class Command {
+   
+    public:
+    
+         // constructors
+         Command();
+         Command(string pipe_me);
+         Command(const Command &other);
+         Command & operator=(const Command &other);
+         Command(Command &&other) = default;
+         Command & operator=(Command &&other) = default;
+         
+         // set functions
+         void setCommandText(const string &new_cmd_text);
+         
+         // get functions
+         const string & getCommandText() const;
+         const string & getErrorReason() const;
+         const string & getUnsupportedFeature() const;
+         string getCommandName() const;
+         bool hasCommandName(const char *name) const;
+         string getInputFileName() const;
+         string getOutputFileName() const;
+         const char * getInputFilePath() const;
+         const char * getOutputFilePath() const;
+         const vector<WordSpan> & getArgs() const;
+         int getArgCount() const;
+         string getArg(int arg_index) const;
+         char * const * getArgsArray() const;
+         
+         // bool functions that return special command options
+         bool isInputRedirected() const;
+         bool isOutputRedirected() const;
+         bool isBackgroundJob() const;
+         bool isPipedJob() const;
+         bool isFileStage() const;
+         
+         // other functions
+         bool parseCommandText();
+         bool parsePipeStage(const string &line, const CharMap &map, int &currentPos);
+         bool parseFileStage(const string &line, const CharMap &map, int &currentPos);
+         bool makePipedJob();
+         bool dropCommandName();
+         void resetCommand();
+         
+    
+    private:
+    
+         // span conversion
+         string spanToString(const WordSpan &word) const;
+         
+         // argument arena
+         void buildArgsArray();
+         void moveArgPointers(const Command &other);
+         
+         // word parsing functions
+         bool parseWords(const string &text, const CharMap &map, int &currentPos);
+         bool parseRedirect(Lexer &lexer, bool &redirect, WordSpan &file_name, const char *which);
+         bool endsCommand(TokenType token);
+         int parseLeadingSpaces(const CharMap &map, int currentPos);
+    
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+         
+         // special command option flags (input/output redirect & pipes)
+         bool input_redirect;
+         bool output_redirect;
+         bool background_job;
+         bool piped_job;
+         
+         // text of entire cmd line
+         string command_text;
+         
+         // parsed command data
+         WordSpan cmd_name;
+         WordSpan input_file;
+         WordSpan output_file;
+         string error_reason;
+         string unsupported_feature;
+         
+         // space for arguments
+         vector<WordSpan> cmd_arguments;
+         
+         // word arena filled in by the lexer: word_chars holds
+         // every unquoted word as a null terminated string, all
+         // of the spans point into it, and arg_ptrs is the argv
+         // for exec
+         vector<char> word_chars;
+         vector<char *> arg_ptrs;
+         
+         // scratch space for parseCommandText(), kept so that
+         // parsing again doesn't allocate it again
+         CharMap char_map;
+};
+
+#endif
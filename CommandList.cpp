@@ -0,0 +1,340 @@
+/* file: CommandList.cpp
+
+   Command List Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class parses command lists into a tree and
+   compiles the tree into a flat program.
+
+*/
+
+#include "CommandList.h"
+
+using namespace std;
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: The strings are initialized to "none" and there
+         are no pipelines.
+*/
+CommandList::CommandList() {
+   command_text = "none";
+   error_reason = "none";
+   num_pipelines = 0;
+}
+
+/******************************************************
+   Sets the text of the command line.
+
+   POST: command_text has been set.
+*/
+void CommandList::setCommandText(const string &new_cmd_text) {
+   command_text = new_cmd_text;
+}
+
+/******************************************************
+   Returns the text of the command line.
+
+   POST: command_text has been returned.
+*/
+const string & CommandList::getCommandText() const {
+   return command_text;
+}
+
+/******************************************************
+   Returns the reason the line could not be parsed.
+
+   POST: error_reason has been returned.
+*/
+const string & CommandList::getErrorReason() const {
+   return error_reason;
+}
+
+/******************************************************
+   Returns one of the pipelines without copying it.
+
+   PRE:  0 <= pipeline_index < getNumPipelines()
+
+   POST: A reference to the pipeline is returned.
+*/
+const PipedCommand & CommandList::getPipeline(int pipeline_index) const {
+   return pipelines[pipeline_index];
+}
+
+/******************************************************
+   Returns the number of pipelines in the list.
+
+   POST: num_pipelines is returned.
+*/
+int CommandList::getNumPipelines() const {
+   return num_pipelines;
+}
+
+/******************************************************
+   Returns the compiled program.
+
+   POST: program is returned.
+*/
+const vector<Instruction> & CommandList::getProgram() const {
+   return program;
+}
+
+/******************************************************
+   Parses the command text into a tree of pipelines and
+   operators, then compiles the tree into the program.
+   The whole line is classified once and every pipeline
+   is parsed straight out of it.
+
+   The grammar is:
+
+      list    := and_or ((';' | '&') and_or)* [';' | '&']
+      and_or  := pipeline (('&&' | '||') pipeline)*
+
+   where the '&' is parsed by Command as part of the
+   pipeline before it. A '&' ends the and_or, so it
+   can't be followed by '&&' or '||'.
+
+   PRE:  command_text has been set.
+
+   POST: Returns true and fills in the program if the
+         line was parsed correctly. Otherwise sets
+         error_reason and returns false.
+*/
+bool CommandList::parseCommandList() {
+
+   int currentPos = 0;
+   int root = -1;
+
+   num_pipelines = 0;
+   error_reason = "none";
+
+   // these all keep their capacity for the next line
+   nodes.clear();
+   program.clear();
+   spine.clear();
+
+   // find all of the special chars in one go
+   char_map.classify(command_text);
+
+   while (true) {
+
+      currentPos = skipSpaces(currentPos);
+
+      // end of the line, a ';' or '&' at the very end is fine
+      if (currentPos == command_text.size())
+         break;
+
+      int item;
+      if (!parseAndOr(currentPos, item))
+         return false;
+
+      if (root == -1)
+         root = item;
+      else
+         root = addNode(NODE_SEQUENCE, root, item, -1);
+
+      // a ';' goes on to the next item, and so does the end of
+      // a pipeline that ended with '&', which was already read
+      currentPos = skipSpaces(currentPos);
+
+      if ((currentPos < command_text.size()) && (command_text[currentPos] == ';'))
+         currentPos++;
+   }
+
+   // nothing but spaces
+   if (root == -1) {
+      error_reason = "Empty command.";
+      return false;
+   }
+
+   lowerNode(root);
+
+   return true;
+}
+
+/******************************************************
+   Parses pipelines joined by '&&' and '||'. They are
+   left associative and have the same precedence, so
+   "a && b || c" is "(a && b) || c".
+
+   PRE:  currentPos is the first char of the first
+         pipeline.
+
+   POST: Returns true and sets node to the root of the
+         new subtree if successful. Otherwise sets
+         error_reason and returns false. currentPos is
+         the first char after the subtree.
+*/
+bool CommandList::parseAndOr(int &currentPos, int &node) {
+
+   if (!parsePipelineNode(currentPos, node))
+      return false;
+
+   while (true) {
+
+      currentPos = skipSpaces(currentPos);
+
+      NodeType type;
+
+      if (command_text.compare(currentPos, 2, "&&") == 0)
+         type = NODE_AND;
+      else if (command_text.compare(currentPos, 2, "||") == 0)
+         type = NODE_OR;
+      else
+         return true;
+
+      // "a & && b", the '&' already ended the list item
+      const PipedCommand &left = pipelines[num_pipelines - 1];
+
+      if (!left.isPiped() && left.getCommand(0).isBackgroundJob()) {
+         error_reason = "A background job can't be followed by '&&' or '||'.";
+         return false;
+      }
+
+      // skip past the operator
+      currentPos += 2;
+
+      int right;
+      if (!parsePipelineNode(currentPos, right))
+         return false;
+
+      node = addNode(type, node, right, -1);
+   }
+}
+
+/******************************************************
+   Parses one pipeline and adds a leaf node for it.
+
+   POST: Returns true and sets node if successful.
+         Otherwise sets error_reason and returns false.
+         currentPos is the first char after the pipeline.
+*/
+bool CommandList::parsePipelineNode(int &currentPos, int &node) {
+
+   // reuse a PipedCommand left over from an earlier parse if
+   // there is one, so its buffers don't have to be allocated again
+   if (num_pipelines == pipelines.size())
+      pipelines.push_back(PipedCommand());
+
+   PipedCommand &pipeline = pipelines[num_pipelines];
+
+   if (!pipeline.parsePipeline(command_text, char_map, currentPos)) {
+
+      error_reason = pipeline.getErrorReason();
+
+      // something like "ls &&" or "; ls"
+      if (error_reason == "Empty command.")
+         error_reason = "Missing a command.";
+
+      return false;
+   }
+
+   node = addNode(NODE_PIPELINE, -1, -1, num_pipelines);
+   num_pipelines++;
+
+   return true;
+}
+
+/******************************************************
+   Adds a node to the parse tree.
+
+   POST: Returns the index of the new node.
+*/
+int CommandList::addNode(NodeType type, int left, int right, int pipeline) {
+
+   ListNode node = { type, left, right, pipeline };
+   nodes.push_back(node);
+
+   return nodes.size() - 1;
+}
+
+/******************************************************
+   Skips the spaces starting at currentPos, using the
+   same test for a space as the rest of the parser.
+
+   POST: Returns the first position that isn't a space,
+         or the length of the text.
+*/
+int CommandList::skipSpaces(int currentPos) {
+   return char_map.skipSpaces(currentPos);
+}
+
+/******************************************************
+   Compiles a subtree into instructions at the end of
+   the program. The tree leans to the left: a ';' has
+   an '&&'/'||' subtree or a pipeline on its right, and
+   an '&&' or '||' has a pipeline. So the left side is
+   walked with a loop and only the right side recurses,
+   which keeps the recursion three calls deep however
+   long the line is.
+
+      a ; b     ->   a  b
+      a && b    ->   a  JUMP_IF_FAILED end  b  end:
+      a || b    ->   a  JUMP_IF_OK end  b  end:
+
+   POST: The instructions for node have been added.
+*/
+void CommandList::lowerNode(int node) {
+
+   int base = spine.size();
+
+   // the left-most pipeline runs first
+   while (nodes[node].type != NODE_PIPELINE) {
+      spine.push_back(node);
+      node = nodes[node].left;
+   }
+
+   emitRun(nodes[node].pipeline);
+
+   // then work back up, each operator adds its right side
+   while (spine.size() > base) {
+
+      ListNode op = nodes[spine.back()];
+      spine.pop_back();
+
+      if (op.type == NODE_SEQUENCE) {
+         lowerNode(op.right);
+         continue;
+      }
+
+      // skip the right side depending on how the left side went
+      Instruction jump;
+      jump.op = (op.type == NODE_AND) ? OP_JUMP_IF_FAILED : OP_JUMP_IF_OK;
+      jump.arg = 0;
+
+      int jump_index = program.size();
+      program.push_back(jump);
+
+      lowerNode(op.right);
+
+      // now we know where the right side ends
+      program[jump_index].arg = program.size();
+   }
+}
+
+/******************************************************
+   Adds the instruction that runs a pipeline. Lone
+   commands and background jobs get their own opcodes,
+   so the shell doesn't have to work it out every time
+   the program runs.
+
+   PRE:  pipeline has been parsed.
+
+   POST: One instruction has been added to the program.
+*/
+void CommandList::emitRun(int pipeline) {
+
+   Instruction run;
+   run.arg = pipeline;
+
+   if (pipelines[pipeline].isPiped())
+      run.op = OP_RUN_PIPELINE;
+   else if (pipelines[pipeline].getCommand(0).isBackgroundJob())
+      run.op = OP_RUN_BACKGROUND;
+   else
+      run.op = OP_RUN_COMMAND;
+
+   program.push_back(run);
+}
@@ -0,0 +1,192 @@
+/* file: CommandList.h
+
+   Command List Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class is based around the data and functions
+   needed for parsing command lists: pipelines joined
+   by ';', '&', '&&' and '||', like
+
+      make && ./wsh || echo failed ; ls
+
+   The line is parsed into a small tree first, with one
+   node per pipeline and one per operator. The tree is
+   then lowered into a flat program of instructions
+   that the shell runs in a loop: run a pipeline, and
+   jump over the next part of the program if the last
+   pipeline failed ('&&') or worked ('||'). Once a line
+   is compiled it can be run any number of times without
+   being parsed again.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   CommandList()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: The object has been initialized. It has an
+            empty program.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   void setCommandText(const string &new_cmd_text)
+   --------------------------------------------------
+      Sets the text of the command line.
+
+      POST: new_cmd_text is now the value of this object's
+            command text.
+
+
+   const string & getCommandText() const
+   --------------------------------------------------
+      Returns the command text of this object.
+
+
+   const string & getErrorReason() const
+   --------------------------------------------------
+      Returns the reason the line couldn't be parsed.
+
+      POST: Returns the reason, or "none" if the line was
+            parsed successfully or hasn't been parsed.
+            A line with nothing but spaces gives
+            "Empty command.".
+
+
+   const PipedCommand & getPipeline(int pipeline_index) const
+   int getNumPipelines() const
+   --------------------------------------------------
+      Return one of the pipelines of the list without
+      copying it, and the number of pipelines.
+
+      PRE:  0 <= pipeline_index < getNumPipelines()
+
+      POST: The reference stays good until this object is
+            parsed again or destroyed.
+
+
+   const vector<Instruction> & getProgram() const
+   --------------------------------------------------
+      Returns the compiled program of the line. The
+      instructions are run in order starting with the
+      first one. The arg of the run instructions is a
+      pipeline index, the arg of the jumps is the index
+      of the instruction to go to next, which can be the
+      size of the program to stop.
+
+      PRE:  parseCommandList() returned true.
+
+
+   bool parseCommandList()
+   --------------------------------------------------
+      Parses the command text into pipelines and compiles
+      it into a program.
+
+      PRE:  The command text of this object has been set.
+
+      POST: Returns true if the line was parsed correctly.
+            Otherwise the reason is stored by this object
+            and false is returned.
+
+*/
+
+#ifndef CMDLIST_HEADER
+#define CMDLIST_HEADER
+
+#include <string>
+#include <vector>
+#include "PipedCommand.h"
+
+using namespace std;
+
+// instructions of a compiled command list
+enum OpCode {
+   OP_RUN_COMMAND,      // run a lone command in the foreground
+   OP_RUN_BACKGROUND,   // start a lone command in the background
+   OP_RUN_PIPELINE,     // run a piped command in the foreground
+   OP_JUMP_IF_FAILED,   // jump if the last exit status wasn't 0
+   OP_JUMP_IF_OK        // jump if the last exit status was 0
+};
+
+struct Instruction {
+   OpCode op;
+   int arg;   // pipeline index or jump target
+};
+
+class CommandList {
+
+    public:
+
+         // constructor
+         CommandList();
+
+         // set functions
+         void setCommandText(const string &new_cmd_text);
+
+         // get functions
+         const string & getCommandText() const;
+         const string & getErrorReason() const;
+         const PipedCommand & getPipeline(int pipeline_index) const;
+         int getNumPipelines() const;
+         const vector<Instruction> & getProgram() const;
+
+         // other functions
+         bool parseCommandList();
+
+    private:
+
+         // kinds of nodes in the parse tree
+         enum NodeType {
+            NODE_PIPELINE,   // leaf, runs pipelines[pipeline]
+            NODE_SEQUENCE,   // left then right
+            NODE_AND,        // left, then right if left worked
+            NODE_OR          // left, then right if left failed
+         };
+
+         struct ListNode {
+            NodeType type;
+            int left;       // index into nodes, -1 for leaves
+            int right;
+            int pipeline;   // index into pipelines, -1 for operators
+         };
+
+         // parsing into the tree
+         bool parseAndOr(int &currentPos, int &node);
+         bool parsePipelineNode(int &currentPos, int &node);
+         int addNode(NodeType type, int left, int right, int pipeline);
+         int skipSpaces(int currentPos);
+
+         // compiling the tree into the program
+         void lowerNode(int node);
+         void emitRun(int pipeline);
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         string command_text;
+         string error_reason;
+
+         // special chars of command_text
+         CharMap char_map;
+
+         // parsed pipelines, only the first num_pipelines are in
+         // use, the rest are kept around to be reused
+         vector<PipedCommand> pipelines;
+         int num_pipelines;
+
+         // parse tree and the program compiled from it
+         vector<ListNode> nodes;
+         vector<Instruction> program;
+
+         // operators lowerNode() still has to finish
+         vector<int> spine;
+};
+
+#endif
@@ -1,78 +1,128 @@
-/* file: ForeJob.h
-   
-   Foreground Job Class Header File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the code needed to redirect,
-   execute, and wait for a foreground job.
-   
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on constructors:                   !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   ForeJob(Command new_command)
-   --------------------------------------------------
-      This is the basic constructor for the class.
-   
-      PRE:  new_command must a parsed Command object.
-   
-      POST: new_command is now the value of this
-            oject's command.
-      
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on public methods:                 !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   bool execute()
-   --------------------------------------------------
-      Tries to execute the job and then wait for it
-      to finish running.
-      
-      POST: Returns true if the job was successfully
-            started and finished. Returns false if
-            there was an error.
-   
-*/
-
-#ifndef FORE_HEADER
-#define FORE_HEADER
-
-#include <string>
-#include <vector>
-#include <iostream>
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <fcntl.h>
-#include <errno.h>
-#include "Command.h"
-
-using namespace std;
-
-class ForeJob {
-   
-    public:
-    
-         // constructor
-         ForeJob(Command new_command);
-         
-         // execute the job
-         bool execute();
-    
-    private:
-    
-         // redirection commands
-         void redirectOutput();
-         void redirectInput();
-         
-         //------------------------------------------------------------
-         // Data
-         //------------------------------------------------------------
-         Command my_command;
-};
-
-#endif
+/* file: ForeJob.h
+   
+   Foreground Job Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the code needed to redirect,
+   execute, and wait for a foreground job.
+   
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   ForeJob(const Command &new_command, Spawner &new_spawner, JobManager &new_job_manager)
+   --------------------------------------------------
+      This is the basic constructor for the class.
+   
+      PRE:  new_command must a parsed Command object.
+            It must not be changed or destroyed while
+            this object is in use. The same goes for
+            new_spawner, which starts the process, and
+            new_job_manager, which waits for it and
+            reaps background jobs in the meantime.
+   
+      POST: new_command is now this oject's command.
+            It is not copied.
+      
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   bool execute()
+   --------------------------------------------------
+      Tries to execute the job and then wait for it
+      to finish running.
+      
+      POST: Returns true if the job was successfully
+            started and finished. Returns false if
+            there was an error.
+   
+   
+   void replaceShell(int first_word)
+   --------------------------------------------------
+      Execs the job in place of the shell, with its
+      redirections done to the shell itself, for when
+      nothing could run after it. No process is
+      started or waited for.
+      
+      PRE:  0 <= first_word <= the number of arguments.
+            The words before first_word (like "exec")
+            aren't part of the job.
+      
+      POST: Only returns if the job couldn't be run. The
+            error has been printed, getExitStatus() says
+            why, and the shell's own files are the way
+            they were.
+   
+   
+   bool redirectShell()
+   --------------------------------------------------
+      Does the redirections of the job to the shell
+      itself, for good, without running anything.
+      
+      POST: Returns false and prints the error if a
+            file couldn't be opened.
+   
+   
+   int getExitStatus() const
+   --------------------------------------------------
+      Returns the exit status of the job, the way sh
+      reports it: the status the job passed to exit(),
+      or 128 plus the signal number if a signal killed
+      it.
+      
+      POST: Returns the exit status. Returns 127 if the
+            command wasn't found, 126 if it couldn't be
+            run, and 1 if the job hasn't been run or
+            couldn't be started.
+   
+*/
+
+#ifndef FORE_HEADER
+#define FORE_HEADER
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "Command.h"
+#include "Spawner.h"
+#include "JobManager.h"
+
+using namespace std;
+
+class ForeJob {
+   
+    public:
+    
+         // constructor
+         ForeJob(const Command &new_command, Spawner &new_spawner, JobManager &new_job_manager);
+         
+         // execute the job
+         bool execute();
+         void replaceShell(int first_word);
+         bool redirectShell();
+         int getExitStatus() const;
+    
+    private:
+    
+         void addRedirects();
+    
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+         const Command &my_command;
+         Spawner &spawner;
+         JobManager &job_manager;
+         int exit_status;
+};
+
+#endif
@@ -0,0 +1,80 @@
+/* file: JobHistory.cpp
+
+   Job History Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class keeps the records of the last background
+   jobs that finished in a ring of a fixed size.
+
+*/
+
+#include "JobHistory.h"
+
+using namespace std;
+
+/******************************************************
+   This is the basic constructor for the class. The
+   ring isn't allocated until records are added, and
+   then only grows up to new_capacity.
+
+   PRE:  new_capacity > 0
+
+   POST: The history is empty.
+*/
+JobHistory::JobHistory(int new_capacity) {
+   capacity = new_capacity;
+   next = 0;
+}
+
+/******************************************************
+   Makes room for a new record. Until the ring is full
+   it grows, after that the oldest record is reused,
+   keeping the space of its command text.
+
+   POST: Returns the new record, to be filled in.
+*/
+JobRecord & JobHistory::add() {
+
+   if (records.size() < capacity) {
+      records.push_back(JobRecord());
+      next = records.size() % capacity;
+      return records.back();
+   }
+
+   JobRecord &record = records[next];
+   next = (next + 1) % capacity;
+
+   return record;
+}
+
+/******************************************************
+   Returns a record by how long ago it was added.
+
+   PRE:  0 <= age < getNumRecords()
+
+   POST: age 0 is the newest record.
+*/
+const JobRecord & JobHistory::getRecord(int age) const {
+
+   int index = next - 1 - age;
+
+   if (index < 0)
+      index += records.size();
+
+   return records[index];
+}
+
+/******************************************************
+   Returns the number of records kept.
+*/
+int JobHistory::getNumRecords() const {
+   return records.size();
+}
+
+/******************************************************
+   Returns the most records that are kept.
+*/
+int JobHistory::getCapacity() const {
+   return capacity;
+}
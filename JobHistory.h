@@ -0,0 +1,114 @@
+/* file: JobHistory.h
+
+   Job History Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class keeps a record of the last background
+   jobs that finished, in a ring of a fixed size. Once
+   it is full each new record takes the place of the
+   oldest one, so it never grows however long the shell
+   runs.
+
+   The records are copies of what is worth knowing about
+   a job once it is gone: its number, pid and command
+   line, how it exited, how long it ran, the CPU time
+   it used and its peak memory. The job itself can be
+   taken out of the JobTable as soon as it has been
+   reported.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   JobHistory(int new_capacity)
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      PRE:  new_capacity > 0
+
+      POST: The history is empty, and will hold the
+            last new_capacity records.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   JobRecord & add()
+   --------------------------------------------------
+      Makes room for a new record, dropping the oldest
+      one if the history is full.
+
+      POST: Returns the new record to be filled in. It
+            stays good until the next add().
+
+
+   const JobRecord & getRecord(int age) const
+   --------------------------------------------------
+      Returns a record by how long ago it was added,
+      0 being the newest.
+
+      PRE:  0 <= age < getNumRecords()
+
+
+   int getNumRecords() const
+   int getCapacity() const
+   --------------------------------------------------
+      Return the number of records kept and the most
+      there can be.
+
+*/
+
+#ifndef JOBHISTORY_HEADER
+#define JOBHISTORY_HEADER
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+using namespace std;
+
+// how many finished jobs are remembered
+const int JOB_HISTORY_SIZE = 100;
+
+// what is kept about a finished background job
+struct JobRecord {
+   int job_num;
+   pid_t pid;
+   string command_text;
+   int wait_status;      // for the W macros, -1 if not known
+   double run_time;      // wall clock seconds
+   double user_time;     // CPU seconds, 0 if not known
+   double system_time;
+   long max_rss_kb;
+};
+
+class JobHistory {
+
+    public:
+
+         // constructor
+         JobHistory(int new_capacity);
+
+         JobRecord & add();
+         const JobRecord & getRecord(int age) const;
+         int getNumRecords() const;
+         int getCapacity() const;
+
+    private:
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         // the ring, filled once and then written over in order
+         vector<JobRecord> records;
+         int capacity;
+
+         // where the next record goes
+         int next;
+};
+
+#endif
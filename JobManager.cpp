@@ -9,11 +9,43 @@
    jobs that are being run. It is in charge of starting,
    managing the status of, and waiting for all of the
    background jobs spawned by the shell. Each background
-   job is represented by an instance of the BackJob class.
-   
-*/
-
-#include "JobManager.h"
+   job is represented by an instance of the BackJob class.
+   
+   Running jobs are watched through their pidfds in an
+   epoll set, which the shell waits on with its input,
+   a foreground command or a job it was told to wait
+   for.
+   The jobs themselves are kept in a JobTable, so a job
+   is found by its number, JobId or pid without looking
+   through the others. Once a finished job has been
+   reported it is taken out of the table, and only its
+   record in the JobHistory is kept.
+   
+   Every reap is a wait4(), which hands back the exit
+   status and resource usage of the process along with
+   it, so keeping them costs no extra system calls.
+   
+   With a limit on the number of running jobs, a new
+   job past the limit is queued instead of started.
+   The queue is a heap by priority, then by the order
+   the jobs came in, and each reap starts the next
+   queued job in the slot it freed.
+   
+*/
+
+#include "JobManager.h"
+#include <cstdio>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+
+// epoll data for the fd waited on with the jobs, JobIds are
+// never this big
+const uint64_t WAIT_EVENT = ~0ULL;
+
+// most events taken from epoll_wait() at once
+const int MAX_JOB_EVENTS = 64;
 
 /******************************************************
    This is the basic constructor for the class.
@@ -21,32 +53,96 @@
    POST: No jobs have been created yet. Job counters
          set to zero.
 */
-JobManager::JobManager() {
+JobManager::JobManager() : history(JOB_HISTORY_SIZE) {
    // no jobs yet
    num_running = 0;
    num_finished = 0;
+   
+   // no limit until one is set
+   max_running = 0;
+   next_queue_order = 0;
+   
+   // without it jobs are only seen by updateJobStatus()
+   epoll_fd = epoll_create1(EPOLL_CLOEXEC);
 }
 
-
-/******************************************************
-   Creates and tries to execute as a background job
-   the command the user passes.
-   
-   PRE:  new_command must be a parsed Command object.
+/******************************************************
+   This is the destructor for the class.
    
-   POST: If the job starts successfully, it is added to
-         the jobs vector as a running job and the running
-         jobs counter is increased by one. Otherwise, it
-         is recorded as failed in the jobs vector.
+   POST: The epoll set is closed.
 */
-void JobManager::createBackgroundJob(Command new_command) {
-   
-   // create new background job
-   jobs.push_back(BackJob(new_command));
+JobManager::~JobManager() {
    
-   // try to run job, if successful
-   if (jobs[jobs.size()-1].execute())
-      num_running++;
+   if (epoll_fd != -1)
+      close(epoll_fd);
+}
+
+
+/******************************************************
+   Creates and tries to execute as a background job
+   the command the user passes. If as many jobs as the
+   limit are running, it is queued with priority.
+   
+   PRE:  new_command must be a parsed Command object.
+   
+   POST: The job has a number in the job table, and is
+         either queued or started, unless it couldn't
+         be started.
+*/
+void JobManager::createBackgroundJob(const Command &new_command, int priority) {
+   
+   // create new background job
+   JobId id = jobs.add(BackJob(new_command));
+   
+   if ((max_running > 0) && (num_running >= max_running)) {
+      
+      QueuedJob waiting;
+      waiting.priority = priority;
+      waiting.order = next_queue_order++;
+      waiting.id = id;
+      
+      queue.push(waiting);
+      jobs.find(id)->setQueued(true);
+      return;
+   }
+   
+   startJob(id);
+}
+
+/******************************************************
+   Tries to execute a job that is in the job table.
+   
+   PRE:  id finds a job that hasn't been executed.
+   
+   POST: If the job starts successfully, the running
+         jobs counter is increased by one and its pid
+         and pidfd are watched. Otherwise, it is taken
+         back out of the table.
+*/
+void JobManager::startJob(JobId id) {
+   
+   BackJob *job = jobs.find(id);
+   
+   // try to run job, the spawn already said why if it failed
+   if (!job->execute()) {
+      jobs.remove(id);
+      return;
+   }
+   
+   num_running++;
+   jobs.indexPid(id, job->getPid());
+   
+   int pid_fd = job->getPidFd();
+   
+   if ((epoll_fd != -1) && (pid_fd != -1)) {
+      
+      // the JobId finds nothing if the slot has moved on by the time it fires
+      struct epoll_event job_event;
+      job_event.events = EPOLLIN;
+      job_event.data.u64 = id;
+      
+      epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pid_fd, &job_event);
+   }
 }
 
 /******************************************************
@@ -64,26 +160,28 @@ void JobManager::createBackgroundJob(Command new_command) {
 */
 bool JobManager::waitForJob(int job_num) {
    
-   int job_index = noToVec(job_num);
+   JobId id = jobs.findNumber(job_num);
+   BackJob *job = jobs.find(id);
    
-   // assume job number given is not running
-   bool valid_job = false;
+   // a queued job has to be started by other jobs finishing first
+   while ((job != NULL) && job->isQueued() && reapAnyJob())
+      job = jobs.find(id);
    
-   // validate job number
-   if (!(job_index >= jobs.size())) {
-      if (jobs[job_index].isRunning()) {
-         valid_job = true;
-      }
-   }
-   
-   // wait for job
-   if (valid_job) {
-      bool success = jobs[job_index].waitForMe();
+   // wait for job, if the number is a running one
+   if ((job != NULL) && job->isRunning()) {
       
-      if (success) {
-         num_running--;
-         num_finished++;   
-      }
+      // reaped from the epoll set if it's in it, along with any
+      // jobs that finish first, so they get their finish times too
+      while ((job->getPidFd() != -1) && job->isRunning() && waitForFd(-1, true))
+         job = jobs.find(id);
+      
+      if (!job->isRunning())
+         return true;
+      
+      bool success = job->waitForMe();
+      
+      if (success)
+         finishJob(id);
       
       return success;
    }
@@ -96,30 +194,382 @@ bool JobManager::waitForJob(int job_num) {
 }
 
 /******************************************************
-   Checks for all background jobs that have finished
+   Waits until there is something to read on input_fd.
+   
+   PRE:  input_fd is open for reading.
+   
+   POST: Returns true as soon as a job has been reaped.
+         Returns false once input_fd is ready, or if it
+         can't be waited on.
+*/
+bool JobManager::waitForInput(int input_fd) {
+   return waitForFd(input_fd, true);
+}
+
+/******************************************************
+   Waits for a foreground child through a pidfd in the
+   epoll set, so the jobs are reaped while it runs. If
+   there are no pidfds, it is waited for by itself.
+   
+   PRE:  pid is a child that isn't a background job.
+   
+   POST: Returns true once the child has been reaped,
+         with its wait status in status. Returns false
+         if waitpid() failed.
+*/
+bool JobManager::waitForChild(pid_t pid, int &status) {
+   
+   int pid_fd = -1;
+   
+#ifdef SYS_pidfd_open
+   if (epoll_fd != -1)
+      pid_fd = syscall(SYS_pidfd_open, pid, 0);
+#endif
+   
+   // the child has exited by the time its pidfd is ready
+   if (pid_fd != -1) {
+      waitForFd(pid_fd, false);
+      close(pid_fd);
+   }
+   
+   return waitpid(pid, &status, 0) != -1;
+}
+
+/******************************************************
+   Returns the epoll set, for another poll() loop to
+   wait on. It is readable when a job's pidfd is.
+   
+   POST: Returns -1 if there is no epoll set.
+*/
+int JobManager::getWaitFd() const {
+   return epoll_fd;
+}
+
+/******************************************************
+   Reaps the jobs whose pidfds are ready, without
+   waiting for any.
+   
+   POST: Every job that had finished is set to
+         finished.
+*/
+void JobManager::reapReady() {
+   
+   if (epoll_fd == -1)
+      return;
+   
+   struct epoll_event events[MAX_JOB_EVENTS];
+   int num_events;
+   
+   do {
+      num_events = epoll_wait(epoll_fd, events, MAX_JOB_EVENTS, 0);
+      
+      for (int eventCtr = 0; eventCtr < num_events; eventCtr++)
+         reapJob(events[eventCtr].data.u64);
+      
+   } while (num_events == MAX_JOB_EVENTS);
+}
+
+/******************************************************
+   Waits on the epoll set until wait_fd is ready,
+   reaping jobs as they finish. wait_fd is added to the
+   set only for the wait, since what the fd number
+   refers to can change between lines (exec < file).
+   With wait_fd -1 only the jobs are waited on. Closing
+   a job's pidfd takes it out of the set.
+   
+   PRE:  wait_fd is -1 only if return_on_job is set and
+         there are jobs in the set.
+   
+   POST: Returns whether a job has been reaped. With
+         return_on_job set that is as soon as one has,
+         otherwise only once wait_fd is ready. Returns
+         right away if wait_fd can't be waited on.
+*/
+bool JobManager::waitForFd(int wait_fd, bool return_on_job) {
+   
+   if (epoll_fd == -1)
+      return false;
+   
+   if (wait_fd != -1) {
+      
+      struct epoll_event wait_event;
+      wait_event.events = EPOLLIN;
+      wait_event.data.u64 = WAIT_EVENT;
+      
+      // regular files can't go in an epoll set, but they never block
+      if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wait_fd, &wait_event) == -1)
+         return false;
+   }
+   
+   struct epoll_event events[MAX_JOB_EVENTS];
+   bool fd_ready = false;
+   bool job_finished = false;
+   
+   while (!fd_ready && !(return_on_job && job_finished)) {
+      
+      int num_events = epoll_wait(epoll_fd, events, MAX_JOB_EVENTS, -1);
+      
+      if (num_events == -1) {
+         
+         if (errno == EINTR)
+            continue;
+         
+         cout << "Background process update error:" << endl;
+         cout << "  " << strerror(errno) << "." << endl;
+         break;
+      }
+      
+      for (int eventCtr = 0; eventCtr < num_events; eventCtr++) {
+         
+         if (events[eventCtr].data.u64 == WAIT_EVENT) {
+            fd_ready = true;
+         } else {
+            reapJob(events[eventCtr].data.u64);
+            job_finished = true;
+         }
+      }
+   }
+   
+   if (wait_fd != -1)
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, wait_fd, NULL);
+   
+   return job_finished;
+}
+
+/******************************************************
+   Reaps a job whose pidfd became readable. The process
+   has exited, so waitpid() doesn't block.
+   
+   PRE:  id came from the epoll set.
+   
+   POST: The job is set to finished, with its finish
+         time and pidfd closed. Nothing happens if the
+         job is gone.
+*/
+void JobManager::reapJob(JobId id) {
+   
+   BackJob *job = jobs.find(id);
+   
+   if ((job == NULL) || !job->isRunning())
+      return;
+   
+   int status;
+   struct rusage usage;
+   
+   int finished_pid = wait4(job->getPid(), &status, WNOHANG, &usage);
+   
+   // 0 means it hasn't really exited, ECHILD that it was reaped already
+   if ((finished_pid == 0) || ((finished_pid == -1) && (errno != ECHILD)))
+      return;
+   
+   if (finished_pid > 0)
+      job->setResult(status, usage);
+   
+   finishJob(id);
+}
+
+/******************************************************
+   Records that a job's process has been reaped. Its
+   pid is dropped from the table, since the kernel can
+   give it to a new process now. The job stays in the
+   table, keeping its number, until it is reported.
+   
+   PRE:  id finds a job that was running. Its result
+         has been set if it is known.
+   
+   POST: The job is set to finished, it has a record in
+         the history and the counters are updated.
+*/
+void JobManager::finishJob(JobId id) {
+   
+   BackJob *job = jobs.find(id);
+   
+   jobs.unindexPid(job->getPid());
+   job->setFinished(true);
+   num_running--;
+   num_finished++;
+   finished_ids.push_back(id);
+   
+   JobRecord &record = history.add();
+   record.job_num = JobTable::getNumber(id);
+   record.pid = job->getPid();
+   record.command_text = job->getCommand().getCommandText();
+   record.run_time = job->getRunTime();
+   record.wait_status = -1;
+   record.user_time = 0;
+   record.system_time = 0;
+   record.max_rss_kb = 0;
+   
+   if (job->hasResult()) {
+      
+      const struct rusage &usage = job->getUsage();
+      
+      record.wait_status = job->getWaitStatus();
+      record.user_time = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+      record.system_time = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+      record.max_rss_kb = usage.ru_maxrss;
+   }
+   
+   // the slot it ran in is free for the next queued job
+   startQueued();
+}
+
+/******************************************************
+   Waits for any background job to finish, for when
+   there is nothing to do until one does.
+   
+   POST: Returns false if there was nothing to wait for
+         or an error. Otherwise a child has been reaped,
+         and if it was a job it is finished.
+*/
+bool JobManager::reapAnyJob() {
+   
+   int status;
+   struct rusage usage;
+   int finished_pid;
+   
+   do {
+      finished_pid = wait4(-1, &status, 0, &usage);
+   } while ((finished_pid == -1) && (errno == EINTR));
+   
+   if (finished_pid == -1)
+      return false;
+   
+   JobId id = jobs.findPid(finished_pid);
+   
+   if (id != NO_JOB) {
+      jobs.find(id)->setResult(status, usage);
+      finishJob(id);
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Starts queued jobs, the highest priority first, for
+   as long as the limit leaves room for them.
+   
+   POST: Either the queue is empty or the limit has
+         been reached.
+*/
+void JobManager::startQueued() {
+   
+   while (!queue.empty() && ((max_running == 0) || (num_running < max_running))) {
+      
+      JobId id = queue.top().id;
+      queue.pop();
+      
+      startJob(id);
+   }
+}
+
+/******************************************************
+   Sets the most background jobs that run at once, 0
+   for no limit. Raising it starts queued jobs.
+   
+   PRE:  new_max >= 0
+   
+   POST: Jobs already running past a lowered limit go
+         on running, new ones are queued until they
+         finish.
+*/
+void JobManager::setMaxRunning(int new_max) {
+   
+   max_running = new_max;
+   startQueued();
+}
+
+/******************************************************
+   Returns the most background jobs that run at once.
+   
+   POST: Returns 0 if there is no limit.
+*/
+int JobManager::getMaxRunning() const {
+   return max_running;
+}
+
+/******************************************************
+   Returns the number of jobs waiting to be started.
+*/
+int JobManager::getNumQueued() const {
+   return queue.size();
+}
+
+/******************************************************
+   Puts the numbers of the running jobs in running_nums,
+   lowest first.
+   
+   POST: running_nums has num_running numbers in it.
+*/
+void JobManager::sortRunning() {
+   
+   running_nums.clear();
+   
+   for (int jobCtr = 0; jobCtr < jobs.getNumJobs(); jobCtr++) {
+      
+      JobId id = jobs.getJob(jobCtr);
+      
+      if (jobs.find(id)->isRunning())
+         running_nums.push_back(JobTable::getNumber(id));
+   }
+   
+   sort(running_nums.begin(), running_nums.end());
+}
+
+/******************************************************
+   Returns the number of background jobs that are still
+   running.
+*/
+int JobManager::getNumRunning() const {
+   return num_running;
+}
+
+/******************************************************
+   Returns the number of jobs still being kept track
+   of: running, queued, or finished but not reported.
+*/
+int JobManager::getNumJobs() const {
+   return jobs.getNumJobs();
+}
+
+/******************************************************
+   Returns how long a background job ran, or has been
+   running, in seconds.
+   
+   PRE:  job_num is the job number of a job that was
+         started and hasn't been cleared out.
+*/
+double JobManager::getRunTime(int job_num) {
+   return jobs.find(jobs.findNumber(job_num))->getRunTime();
+}
+
+/******************************************************
+   Checks for all background jobs that have finished
    executing and updates their status.
    
    POST: All finished jobs are set to finished.
 */
 void JobManager::updateJobStatus() {
    
+   int status;
+   struct rusage usage;
+   
    // linux system call to get a terminated child
-   int finished_pid = waitpid(-1, NULL, WNOHANG);
+   int finished_pid = wait4(-1, &status, WNOHANG, &usage);
    
    // update until no terminated children left
    while ((finished_pid != -1) && (finished_pid != 0)) {
       
-      // update job in vector to "finished" status
-      for (int updateCtr = 0; updateCtr < jobs.size(); updateCtr++) {
-         if (finished_pid == jobs[updateCtr].getPid()) {
-            jobs[updateCtr].setFinished(true);
-            num_running--;
-            num_finished++;
-         }
+      // update job to "finished" status, if it was one of ours
+      JobId id = jobs.findPid(finished_pid);
+      
+      if (id != NO_JOB) {
+         jobs.find(id)->setResult(status, usage);
+         finishJob(id);
       }
       
       // system call again
-      finished_pid = waitpid(-1, NULL, WNOHANG);
+      finished_pid = wait4(-1, &status, WNOHANG, &usage);
    }
    
    // check if something nasty happend
@@ -134,84 +584,133 @@ void JobManager::updateJobStatus() {
    Prints to standard out all of the running and
    recently finished jobs.
    
-   POST: All running and finished jobs are printed.
-*/
-void JobManager::printJobs() {
-   
-   // print all running jobs
-   if (num_running > 0) {
-      
-      cout << "    Running:" << endl;
-      
-      for (int runCtr = 0; runCtr < jobs.size(); runCtr++) {
-         if (jobs[runCtr].isRunning()) {
-            cout << "        [" << vecToNo(runCtr) << "] " << jobs[runCtr].getCommand().getCommandText() << endl;
-         }
-      }
-   }
-   
-   // print all finished jobs
-   if (num_finished > 0) {
-      
-      cout << "    Finished:" << endl;
-      
-      for (int finCtr = 0; finCtr < jobs.size(); finCtr++) {
-         if (jobs[finCtr].isFinished()) {
-            cout << "        [" << vecToNo(finCtr) << "] " << jobs[finCtr].getCommand().getCommandText() << endl;
-         }
-      }
-   }
-}
-
-/******************************************************
-   Clears out all recently finished background jobs.
-   If no jobs are running and there is nothing left
-   to display to the user, the job history is cleaned
-   out. (next new background job will have a job # of 1)
+   POST: All running and finished jobs are printed,
+         the finished ones with how long they ran. Only
+         the jobs in the table and the newest records of
+         the history are looked at.
+*/
+void JobManager::printJobs() {
    
-   POST: All finished jobs are set to terminated. If no
-         jobs are left running or set to be displayed,
-         the jobs vector is cleared.
-*/
-void JobManager::clearOldJobs() {
-   
-   // go through vector and set all "finshed" jobs to "terminated"
-   for (int termCtr = 0; termCtr < jobs.size(); termCtr++) {
-      
-      if(jobs[termCtr].isFinished()) {
-         jobs[termCtr].setTerminated(true);
-         num_finished--;
-      }
-   }
-   
-   // clear out vector if all info is old
-   if ((num_running == 0) && (num_finished == 0)) {
-      jobs.clear();
-   }
-   
+   // print all running jobs, by number
+   if (num_running > 0) {
+      
+      cout << "    Running:" << endl;
+      
+      sortRunning();
+      
+      for (int runCtr = 0; runCtr < running_nums.size(); runCtr++) {
+         
+         BackJob *job = jobs.find(jobs.findNumber(running_nums[runCtr]));
+         cout << "        [" << running_nums[runCtr] << "] " << job->getCommand().getCommandText() << endl;
+      }
+   }
+   
+   if (!queue.empty())
+      cout << "    Queued: " << queue.size() << endl;
+   
+   // print all finished jobs, the newest records of the history,
+   // unless more finished than the history holds
+   int num_shown = min(num_finished, history.getNumRecords());
+   
+   if (num_shown > 0) {
+      
+      cout << "    Finished:" << endl;
+      
+      for (int age = num_shown - 1; age >= 0; age--) {
+         
+         const JobRecord &record = history.getRecord(age);
+         
+         // to the millisecond, without touching cout's format
+         char run_time[32];
+         snprintf(run_time, sizeof(run_time), "%.3f", record.run_time);
+         
+         cout << "        [" << record.job_num << "] " << record.command_text
+              << "  (" << run_time << "s)" << endl;
+      }
+   }
 }
 
 /******************************************************
-   Converts a job number into a vector index.
+   Prints the running jobs and the whole history, each
+   job on one line. The long form adds the pid, and for
+   finished jobs how they exited and what they used,
+   all of it kept when they were reaped.
    
-   PRE:  job_num is an integer.
-   
-   POST: Returns the vector index of that job number.
-*/
-int JobManager::noToVec(int job_num) {
-   int vec_index = job_num - 1;
-   return vec_index;
-}
-         
+   POST: The jobs and history are printed.
+*/
+void JobManager::printHistory(bool long_form) {
+   
+   char line[128];
+   
+   if (num_running > 0) {
+      
+      cout << "    Running:" << endl;
+      
+      sortRunning();
+      
+      for (int runCtr = 0; runCtr < running_nums.size(); runCtr++) {
+         
+         BackJob *job = jobs.find(jobs.findNumber(running_nums[runCtr]));
+         
+         cout << "        [" << running_nums[runCtr] << "] ";
+         
+         if (long_form) {
+            snprintf(line, sizeof(line), "pid %-7d running      wall %8.3fs  ", job->getPid(), job->getRunTime());
+            cout << line;
+         }
+         
+         cout << job->getCommand().getCommandText() << endl;
+      }
+   }
+   
+   if (!queue.empty())
+      cout << "    Queued: " << queue.size() << endl;
+   
+   if (history.getNumRecords() == 0)
+      return;
+   
+   cout << "    History:" << endl;
+   
+   // oldest first
+   for (int age = history.getNumRecords() - 1; age >= 0; age--) {
+      
+      const JobRecord &record = history.getRecord(age);
+      
+      char status[32];
+      
+      if (record.wait_status == -1)
+         snprintf(status, sizeof(status), "unknown");
+      else if (WIFSIGNALED(record.wait_status))
+         snprintf(status, sizeof(status), "signal %d", WTERMSIG(record.wait_status));
+      else
+         snprintf(status, sizeof(status), "exit %d", WEXITSTATUS(record.wait_status));
+      
+      cout << "        [" << record.job_num << "] ";
+      
+      if (long_form) {
+         snprintf(line, sizeof(line), "pid %-7d %-12s wall %8.3fs  user %7.3fs  sys %7.3fs  rss %7ldK  ",
+                  (int) record.pid, status, record.run_time, record.user_time, record.system_time, record.max_rss_kb);
+      } else {
+         snprintf(line, sizeof(line), "%-12s ", status);
+      }
+      
+      cout << line << record.command_text << endl;
+   }
+}
+
 /******************************************************
-   Converts a vector index into a job number.
+   Clears out all recently finished background jobs.
+   Their numbers are free to be used again, the lowest
+   free one first. (with no jobs left the next one is # 1)
    
-   PRE:  vec_index is an integer.
-   
-   POST: Returns the job number corresponding to the
-         passed index.
-*/
-int JobManager::vecToNo(int vec_index) {
-   int job_num = vec_index + 1;
-   return job_num;
+   POST: All finished jobs are taken out of the job
+         table. Their records stay in the history.
+*/
+void JobManager::clearOldJobs() {
+   
+   for (int termCtr = 0; termCtr < finished_ids.size(); termCtr++)
+      jobs.remove(finished_ids[termCtr]);
+   
+   finished_ids.clear();
+   num_finished = 0;
 }
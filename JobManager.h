@@ -10,6 +10,28 @@
    managing the status of, and waiting for all of the
    background jobs spawned by the shell. Each background
    job is represented by an instance of the BackJob class.
+   
+   The pidfd of every running job is kept in an epoll
+   set. Whatever the shell waits on, its next line, a
+   foreground command or a job for "wait", it waits on
+   through that set, so a job is reaped and its finish
+   time is taken the moment it exits, not the next
+   time a line is typed.
+   
+   The jobs are kept in a JobTable. A job's number is
+   its slot in the table, which doesn't change while
+   the job is in it. A finished job stays in the table
+   until it has been reported, and then all that is
+   left of it is its record in a JobHistory of the
+   last JOB_HISTORY_SIZE jobs. So the table only ever
+   holds the jobs that are running or just finished.
+   
+   A limit can be put on how many jobs run at once, the
+   way "make -j" does. A job started past the limit is
+   given its number and put in a queue, highest
+   priority first and in the order they came for the
+   same priority. Each time a job is reaped, the next
+   one in the queue is started.
       
    
    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
@@ -23,21 +45,32 @@
       POST: The object has been initialized. There are
             no background jobs running.
             
+            
+   ~JobManager()
+   --------------------------------------------------
+      This is the destructor for the class.
+      
+      POST: The epoll set is closed.
+            
    
    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
    ! Information on public methods:                 !
    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
    
-   void createBackgroundJob(Command new_command)
+   void createBackgroundJob(const Command &new_command, int priority)
    --------------------------------------------------
-      Creates and tries to execute as a background job
-      the command the user passes.
+      Creates and tries to execute as a background job
+      the command the user passes. If the limit on
+      running jobs has been reached, the job is queued
+      with priority instead, to be started once others
+      finish.
+      
+      PRE:  new_command must be a parsed Command object.
       
-      PRE:  new_command must be a parsed Command object.
-      
-      POST: If the job starts successfully, it is added to
-            the jobs data structure as a running job.
-            Otherwise, it is recorded as failed.
+      POST: If the job starts successfully, or is
+            queued, it is added to the jobs data
+            structure. Otherwise, it is recorded as
+            failed.
       
       
    bool waitForJob(int job_num)
@@ -50,12 +83,91 @@
             number of a background job.
       
       POST: Returns true after the background process is
-            finished. Returns false if the job number
-            specified by the user doesn't correspond
-            to a running process or if an error was
-            encountered.
+            finished. Returns false if the job number
+            specified by the user doesn't correspond
+            to a running process or if an error was
+            encountered. A queued job is waited for
+            through the jobs ahead of it. Other jobs
+            that finish first are reaped on the way.
    
 
+   bool waitForInput(int input_fd)
+   --------------------------------------------------
+      Waits until there is something to read on
+      input_fd, reaping background jobs as they finish
+      in the meantime.
+      
+      PRE:  input_fd is open for reading.
+      
+      POST: Returns true as soon as one or more jobs
+            have been set to finished, which may be
+            before input_fd is ready. Returns false once
+            input_fd is ready, or right away if it can't
+            be waited on (a regular file is always
+            ready).
+      
+      
+   int getWaitFd() const
+   void reapReady()
+   --------------------------------------------------
+      For a class with a poll() loop of its own, like a
+      pipeline's: getWaitFd() returns an fd that is
+      readable when a background job has finished, or
+      -1 if there isn't one. reapReady() then reaps
+      every job that has finished, without blocking.
+      
+      
+   bool waitForChild(pid_t pid, int &status)
+   --------------------------------------------------
+      Waits for a foreground process of the shell to
+      exit, reaping background jobs as they finish in
+      the meantime.
+      
+      PRE:  pid is a child of the shell that isn't a
+            background job.
+      
+      POST: Returns true once the child has been
+            reaped, with its wait status in status.
+            Returns false if it couldn't be waited for,
+            with errno set.
+      
+      
+   int getNumRunning() const
+   --------------------------------------------------
+      Returns the number of background jobs that are
+      still running.
+      
+      
+   int getNumJobs() const
+   --------------------------------------------------
+      Returns the number of background jobs still kept
+      track of: running, queued, or finished but not
+      reported yet.
+      
+      
+   void setMaxRunning(int new_max)
+   int getMaxRunning() const
+   int getNumQueued() const
+   --------------------------------------------------
+      Set and return the most background jobs that run
+      at once, 0 for no limit, and return the number
+      of jobs queued until there is room.
+      
+      PRE:  new_max >= 0
+      
+      POST: Raising the limit starts queued jobs right
+            away. Lowering it doesn't stop any.
+      
+      
+   double getRunTime(int job_num)
+   --------------------------------------------------
+      Returns how long a background job ran, or has
+      been running, in seconds.
+      
+      PRE:  job_num is the job number of a job that
+            was started and hasn't been cleared out.
+      
+      
    void updateJobStatus()
    --------------------------------------------------
       Checks for all background jobs that have finished
@@ -70,20 +182,32 @@
       Prints to standard out all of the running and
       recently finished jobs.
       
-      POST: All running and finished jobs are printed.
+      POST: All running and finished jobs are printed,
+            the finished ones with how long they ran,
+            and how many jobs are queued. If more jobs
+            finished than the history holds, only the
+            newest are printed.
+      
+      
+   void printHistory(bool long_form)
+   --------------------------------------------------
+      Prints to standard out the running jobs and every
+      finished job in the history, for the "jobs"
+      builtin. The long form ("jobs -l") adds the pid,
+      the exit status or signal, the wall clock, user
+      and system time and the peak memory of each job.
+      
+      POST: The running jobs and the history are
+            printed, the oldest first.
       
       
    void clearOldJobs()
    --------------------------------------------------
-      Clears out all recently finished background jobs.
-      If no jobs are running and there is nothing left
-      to display to the user, the job history is cleaned
-      out. (next new background job will have a job # of 1)
+      Clears out all recently finished background jobs.
+      Their job numbers can be used again by new jobs.
       
-      POST: All finished jobs are set to terminated. If no
-            jobs are left running or set to be displayed,
-            the data structure that keeps track of jobs
-            is cleared out.
+      POST: All finished jobs are taken out of the job
+            table. Their records stay in the history.
       
 */
 
@@ -92,39 +216,90 @@
 
 #include "Command.h"
 #include "BackJob.h"
+#include "JobTable.h"
+#include "JobHistory.h"
 #include <vector>
+#include <queue>
 #include <iostream>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 
 class JobManager {
     
     public:
     
-         //constructor
+         //constructor and destructor
          JobManager();
+         ~JobManager();
          
          // job control methods
-         void createBackgroundJob(Command new_command);
+         void createBackgroundJob(const Command &new_command, int priority);
          bool waitForJob(int job_num);
          
          // methods related to job status updates
+         bool waitForInput(int input_fd);
+         bool waitForChild(pid_t pid, int &status);
+         int getWaitFd() const;
+         void reapReady();
+         int getNumRunning() const;
+         int getNumJobs() const;
+         void setMaxRunning(int new_max);
+         int getMaxRunning() const;
+         int getNumQueued() const;
+         double getRunTime(int job_num);
          void updateJobStatus();
          void printJobs();
+         void printHistory(bool long_form);
          void clearOldJobs();
     
     private:
     
-         // vector index conversion methods
-         int noToVec(int job_num);
-         int vecToNo(int vec_index);
+         // reap a job whose pidfd was ready
+         bool waitForFd(int wait_fd, bool return_on_job);
+         void reapJob(JobId id);
+         void finishJob(JobId id);
+         void sortRunning();
+         
+         // the jobs waiting for room under max_running
+         void startJob(JobId id);
+         void startQueued();
+         bool reapAnyJob();
+         
+         struct QueuedJob {
+            int priority;
+            uint64_t order;       // earlier jobs first for the same priority
+            JobId id;
+            
+            // the top of the heap is the greatest
+            bool operator<(const QueuedJob &other) const {
+               if (priority != other.priority)
+                  return priority < other.priority;
+               return order > other.order;
+            }
+         };
          
          //------------------------------------------------------------
          // Data
          //------------------------------------------------------------
-         vector<BackJob> jobs;
+         JobTable jobs;
+         JobHistory history;
+         
+         // finished jobs that haven't been reported yet
+         vector<JobId> finished_ids;
+         
+         // room for sorting the running job numbers
+         vector<int> running_nums;
          int num_running;
          int num_finished;
+         
+         // pidfds of the running jobs, by JobId
+         int epoll_fd;
+         
+         // 0 for no limit
+         int max_running;
+         priority_queue<QueuedJob> queue;
+         uint64_t next_queue_order;
     
 };
 
@@ -0,0 +1,202 @@
+/* file: JobTable.cpp
+
+   Job Table Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class keeps background jobs in a slot map with
+   generational ids, and their pids in a hash table.
+
+*/
+
+#include "JobTable.h"
+#include <algorithm>
+#include <functional>
+
+using namespace std;
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: The table is empty.
+*/
+JobTable::JobTable() {
+}
+
+/******************************************************
+   Puts a copy of new_job in the lowest free slot, or
+   in a new slot at the end.
+
+   POST: Returns the JobId of the job in the table.
+*/
+JobId JobTable::add(const BackJob &new_job) {
+
+   int slot;
+
+   if (free_slots.empty()) {
+
+      slot = jobs.size();
+      jobs.push_back(new_job);
+
+      SlotInfo info;
+      info.generation = 0;
+      info.pid = -1;
+      slots.push_back(info);
+
+   } else {
+
+      pop_heap(free_slots.begin(), free_slots.end(), greater<int>());
+      slot = free_slots.back();
+      free_slots.pop_back();
+      jobs[slot] = new_job;
+   }
+
+   slots[slot].used = true;
+   slots[slot].live_index = live_slots.size();
+   live_slots.push_back(slot);
+
+   return makeId(slot, slots[slot].generation);
+}
+
+/******************************************************
+   Takes a job out of the table. Moving the generation
+   on is what makes its old JobIds find nothing. The
+   last live slot is moved into the hole it leaves in
+   the live list.
+
+   POST: The slot is in the heap of free ones. Nothing
+         happens if id doesn't find a job.
+*/
+void JobTable::remove(JobId id) {
+
+   if (find(id) == NULL)
+      return;
+
+   int slot = id & 0xffffffff;
+
+   if (slots[slot].pid != -1)
+      unindexPid(slots[slot].pid);
+
+   slots[slot].used = false;
+   slots[slot].generation++;
+   free_slots.push_back(slot);
+   push_heap(free_slots.begin(), free_slots.end(), greater<int>());
+
+   int moved = live_slots.back();
+   live_slots[slots[slot].live_index] = moved;
+   slots[moved].live_index = slots[slot].live_index;
+   live_slots.pop_back();
+}
+
+/******************************************************
+   Finds a job by its JobId.
+
+   POST: Returns NULL if the slot is free or has moved
+         on to another job.
+*/
+BackJob * JobTable::find(JobId id) {
+
+   uint32_t slot = id & 0xffffffff;
+
+   if ((slot >= slots.size()) || !slots[slot].used || (slots[slot].generation != (id >> 32)))
+      return NULL;
+
+   return &jobs[slot];
+}
+
+/******************************************************
+   Finds the job with a job number, which is its slot
+   plus one.
+
+   POST: Returns NO_JOB if the slot doesn't have a job.
+*/
+JobId JobTable::findNumber(int job_num) const {
+
+   int slot = job_num - 1;
+
+   if ((slot < 0) || (slot >= slots.size()) || !slots[slot].used)
+      return NO_JOB;
+
+   return makeId(slot, slots[slot].generation);
+}
+
+/******************************************************
+   Adds the pid of a job to the hash table.
+
+   PRE:  id finds a job.
+*/
+void JobTable::indexPid(JobId id, pid_t pid) {
+
+   slots[id & 0xffffffff].pid = pid;
+   pids[pid] = id;
+}
+
+/******************************************************
+   Drops a pid from the hash table, once it has been
+   reaped and might be given to a new process.
+*/
+void JobTable::unindexPid(pid_t pid) {
+
+   unordered_map<pid_t, JobId>::iterator found = pids.find(pid);
+
+   if (found == pids.end())
+      return;
+
+   slots[found->second & 0xffffffff].pid = -1;
+   pids.erase(found);
+}
+
+/******************************************************
+   Finds the job a pid belongs to.
+
+   POST: Returns NO_JOB if the pid isn't in the table.
+*/
+JobId JobTable::findPid(pid_t pid) const {
+
+   unordered_map<pid_t, JobId>::const_iterator found = pids.find(pid);
+
+   if (found == pids.end())
+      return NO_JOB;
+
+   return found->second;
+}
+
+/******************************************************
+   Returns the number of jobs in the table.
+*/
+int JobTable::getNumJobs() const {
+   return live_slots.size();
+}
+
+/******************************************************
+   Returns one of the jobs in the table.
+
+   PRE:  0 <= index < getNumJobs()
+*/
+JobId JobTable::getJob(int index) const {
+
+   int slot = live_slots[index];
+
+   return makeId(slot, slots[slot].generation);
+}
+
+/******************************************************
+   Returns the number of slots, used or free.
+*/
+int JobTable::getNumSlots() const {
+   return slots.size();
+}
+
+/******************************************************
+   Returns the job number of a JobId, its slot plus one.
+*/
+int JobTable::getNumber(JobId id) {
+   return (id & 0xffffffff) + 1;
+}
+
+/******************************************************
+   Puts a slot and a generation together into a JobId.
+*/
+JobId JobTable::makeId(int slot, uint32_t generation) {
+   return ((JobId) generation << 32) | (uint32_t) slot;
+}
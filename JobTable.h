@@ -0,0 +1,186 @@
+/* file: JobTable.h
+
+   Job Table Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class holds the background jobs of the
+   JobManager in a slot map. Each job is kept in a slot
+   that doesn't move while the job is in the table, and
+   the lowest free slot is handed to the next job added,
+   so job numbers stay small. A job's number is its
+   slot plus one.
+
+   A job is found by a JobId, which is the slot and the
+   generation of the slot. The generation goes up each
+   time a job is removed, so a JobId kept after its job
+   is gone (in an epoll event, say) finds nothing
+   instead of whatever job took the slot.
+
+   The process ids of running jobs are kept in a hash
+   table, so the job a reaped pid belongs to is found
+   without looking through the others. Finding a job
+   takes the same time however many jobs there are,
+   and adding or removing one only has to keep the
+   heap of free slots in order.
+
+   The slots of the jobs in the table are also kept
+   packed together in a list of their own, so the jobs
+   can be gone through without looking at free slots.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   JobTable()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: The table is empty.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   JobId add(const BackJob &new_job)
+   --------------------------------------------------
+      Puts a copy of new_job in the lowest free slot,
+      or a new one if none are free.
+
+      POST: Returns the JobId of the job in the table.
+
+
+   void remove(JobId id)
+   --------------------------------------------------
+      Takes a job out of the table. Its pid is dropped
+      from the hash table if it was still there.
+
+      POST: The slot is free, and id and every other
+            JobId of the job find nothing from now on.
+            Nothing happens if id doesn't find a job.
+
+
+   BackJob * find(JobId id)
+   --------------------------------------------------
+      Finds a job by its JobId.
+
+      POST: Returns NULL if the job has been removed.
+            The pointer stays good until a job is added.
+
+
+   JobId findNumber(int job_num) const
+   --------------------------------------------------
+      Finds the job with a job number.
+
+      POST: Returns NO_JOB if no job has that number.
+
+
+   void indexPid(JobId id, pid_t pid)
+   void unindexPid(pid_t pid)
+   JobId findPid(pid_t pid) const
+   --------------------------------------------------
+      Add a pid for a job, drop it once it has been
+      reaped (the pid can be used again after that),
+      and find the job a pid belongs to.
+
+      PRE:  id finds a job.
+
+      POST: findPid() returns NO_JOB for a pid that
+            isn't in the table.
+
+
+   int getNumJobs() const
+   JobId getJob(int index) const
+   --------------------------------------------------
+      Return the number of jobs in the table and each
+      of them, in no particular order.
+
+      PRE:  0 <= index < getNumJobs()
+
+      POST: The order changes when a job is removed.
+
+
+   int getNumSlots() const
+   --------------------------------------------------
+      Returns the number of slots, which is the most
+      jobs that have been in the table at once.
+
+
+   static int getNumber(JobId id)
+   --------------------------------------------------
+      Returns the job number of a JobId.
+
+*/
+
+#ifndef JOBTABLE_HEADER
+#define JOBTABLE_HEADER
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+#include <sys/types.h>
+#include "BackJob.h"
+
+using namespace std;
+
+// a job's slot in the low 32 bits, the slot's generation in the high
+typedef uint64_t JobId;
+
+// found nothing
+const JobId NO_JOB = ~0ULL;
+
+class JobTable {
+
+    public:
+
+         // constructor
+         JobTable();
+
+         // adding and finding jobs
+         JobId add(const BackJob &new_job);
+         void remove(JobId id);
+         BackJob * find(JobId id);
+         JobId findNumber(int job_num) const;
+
+         // the pids of running jobs
+         void indexPid(JobId id, pid_t pid);
+         void unindexPid(pid_t pid);
+         JobId findPid(pid_t pid) const;
+
+         int getNumJobs() const;
+         JobId getJob(int index) const;
+         int getNumSlots() const;
+         static int getNumber(JobId id);
+
+    private:
+
+         // what a slot holds besides its job
+         struct SlotInfo {
+            uint32_t generation;
+            bool used;
+            pid_t pid;           // -1 once it isn't in pids
+            int live_index;      // where it is in live_slots
+         };
+
+         static JobId makeId(int slot, uint32_t generation);
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         // the job in a free slot is left over from the last one
+         vector<BackJob> jobs;
+         vector<SlotInfo> slots;
+
+         // a heap of the free slots, lowest on top
+         vector<int> free_slots;
+
+         // the used slots, packed together
+         vector<int> live_slots;
+
+         unordered_map<pid_t, JobId> pids;
+};
+
+#endif
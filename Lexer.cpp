@@ -0,0 +1,334 @@
+/* file: Lexer.cpp
+
+   Command Line Lexer Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class splits a command line into words and the
+   operator chars, taking care of quotes and escapes.
+
+*/
+
+#include "Lexer.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+// char classes, the columns of the transition table
+enum {
+   CLASS_PLAIN,       // anything else
+   CLASS_SPACE,       // ' ' or tab
+   CLASS_OPERATOR,    // '<', '>', '&', '|' or ';'
+   CLASS_SQUOTE,      // '
+   CLASS_DQUOTE,      // "
+   CLASS_BACKSLASH,   // '\'
+   CLASS_GLOB,        // '*', '?' or '~'
+   NUM_CLASSES
+};
+
+// lexer states, the rows of the transition table
+enum {
+   STATE_START,       // between tokens
+   STATE_WORD,        // inside of a word, outside of quotes
+   STATE_SQUOTE,      // inside of '...'
+   STATE_DQUOTE,      // inside of "..."
+   STATE_ESCAPE,      // just after a '\' outside of quotes
+   STATE_DQ_ESCAPE,   // just after a '\' inside of "..."
+   NUM_STATES
+};
+
+// things to do with the current char, more than one can be set
+const unsigned char ACT_START = 1;      // a new word starts here
+const unsigned char ACT_APPEND = 2;     // add the char to the word
+const unsigned char ACT_BACKSLASH = 4;  // add a '\' to the word first
+const unsigned char ACT_GLOB = 8;       // remember an unsupported feature
+const unsigned char ACT_FINISH = 16;    // the word ended before this char
+const unsigned char ACT_OPERATOR = 32;  // the char is an operator token
+
+// smallest buffer the lexer grows words to
+const int MIN_WORDS_SIZE = 64;
+
+struct Transition {
+   unsigned char next_state;
+   unsigned char actions;
+};
+
+// next state and actions for every state and char class
+static const Transition transitions[NUM_STATES][NUM_CLASSES] = {
+
+   // STATE_START
+   { { STATE_WORD, ACT_START | ACT_APPEND },              // plain
+     { STATE_START, 0 },                                  // space
+     { STATE_START, ACT_OPERATOR },                       // operator
+     { STATE_SQUOTE, ACT_START },                         // '
+     { STATE_DQUOTE, ACT_START },                         // "
+     { STATE_ESCAPE, ACT_START },                         // backslash
+     { STATE_WORD, ACT_START | ACT_APPEND | ACT_GLOB } },  // glob
+
+   // STATE_WORD
+   { { STATE_WORD, ACT_APPEND },
+     { STATE_START, ACT_FINISH },
+     { STATE_START, ACT_FINISH },
+     { STATE_SQUOTE, 0 },
+     { STATE_DQUOTE, 0 },
+     { STATE_ESCAPE, 0 },
+     { STATE_WORD, ACT_APPEND | ACT_GLOB } },
+
+   // STATE_SQUOTE, everything is plain until the closing quote
+   { { STATE_SQUOTE, ACT_APPEND },
+     { STATE_SQUOTE, ACT_APPEND },
+     { STATE_SQUOTE, ACT_APPEND },
+     { STATE_WORD, 0 },
+     { STATE_SQUOTE, ACT_APPEND },
+     { STATE_SQUOTE, ACT_APPEND },
+     { STATE_SQUOTE, ACT_APPEND } },
+
+   // STATE_DQUOTE, only the closing quote and backslash are special
+   { { STATE_DQUOTE, ACT_APPEND },
+     { STATE_DQUOTE, ACT_APPEND },
+     { STATE_DQUOTE, ACT_APPEND },
+     { STATE_DQUOTE, ACT_APPEND },
+     { STATE_WORD, 0 },
+     { STATE_DQ_ESCAPE, 0 },
+     { STATE_DQUOTE, ACT_APPEND } },
+
+   // STATE_ESCAPE, the next char is taken as is
+   { { STATE_WORD, ACT_APPEND },
+     { STATE_WORD, ACT_APPEND },
+     { STATE_WORD, ACT_APPEND },
+     { STATE_WORD, ACT_APPEND },
+     { STATE_WORD, ACT_APPEND },
+     { STATE_WORD, ACT_APPEND },
+     { STATE_WORD, ACT_APPEND } },
+
+   // STATE_DQ_ESCAPE, a backslash only escapes " and itself inside
+   // of double quotes, otherwise it stays in the word
+   { { STATE_DQUOTE, ACT_BACKSLASH | ACT_APPEND },
+     { STATE_DQUOTE, ACT_BACKSLASH | ACT_APPEND },
+     { STATE_DQUOTE, ACT_BACKSLASH | ACT_APPEND },
+     { STATE_DQUOTE, ACT_BACKSLASH | ACT_APPEND },
+     { STATE_DQUOTE, ACT_APPEND },
+     { STATE_DQUOTE, ACT_APPEND },
+     { STATE_DQUOTE, ACT_BACKSLASH | ACT_APPEND } }
+};
+
+// class of every char, has to agree with the chars CharMap
+// treats as special or the skipping in nextToken() breaks
+struct ClassTable {
+
+   unsigned char classes[256];
+
+   ClassTable() {
+      memset(classes, CLASS_PLAIN, sizeof(classes));
+
+      classes[(unsigned char) ' '] = CLASS_SPACE;
+      classes[(unsigned char) '\t'] = CLASS_SPACE;
+      classes[(unsigned char) '<'] = CLASS_OPERATOR;
+      classes[(unsigned char) '>'] = CLASS_OPERATOR;
+      classes[(unsigned char) '&'] = CLASS_OPERATOR;
+      classes[(unsigned char) '|'] = CLASS_OPERATOR;
+      classes[(unsigned char) ';'] = CLASS_OPERATOR;
+      classes[(unsigned char) '\''] = CLASS_SQUOTE;
+      classes[(unsigned char) '"'] = CLASS_DQUOTE;
+      classes[(unsigned char) '\\'] = CLASS_BACKSLASH;
+      classes[(unsigned char) '*'] = CLASS_GLOB;
+      classes[(unsigned char) '?'] = CLASS_GLOB;
+      classes[(unsigned char) '~'] = CLASS_GLOB;
+   }
+};
+
+static const ClassTable char_classes;
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   PRE:  map has been classified from text.
+
+   POST: The lexer is ready to read from startPos.
+*/
+Lexer::Lexer(const string &text, const CharMap &map, int startPos, vector<char> &words)
+   : text(text), map(map), words(words)
+{
+   currentPos = startPos;
+   words_used = words.size();
+   error_reason = "none";
+   unsupported_feature = "none";
+}
+
+/******************************************************
+   This is the destructor for the class.
+
+   POST: words has been cut down to the chars the lexer
+         really used. Its capacity is kept.
+*/
+Lexer::~Lexer() {
+   words.resize(words_used);
+}
+
+/******************************************************
+   Reads the next token by running the state machine
+   until a word ends or an operator is found.
+
+   POST: Returns the type of the token, word is set for
+         TOKEN_WORD. The unquoted word and a '\0' have
+         been added to the end of words.
+*/
+TokenType Lexer::nextToken(WordSpan &word) {
+
+   int state = STATE_START;
+   int text_size = text.size();
+
+   word.start = -1;
+   word.length = 0;
+
+   while (currentPos < text_size) {
+
+      char current = text[currentPos];
+      const Transition &move = transitions[state][char_classes.classes[(unsigned char) current]];
+
+      // the word is done, leave the char for the next call
+      if (move.actions & ACT_FINISH)
+         break;
+
+      if (move.actions & ACT_OPERATOR) {
+
+         bool doubled = (currentPos + 1 < text_size) && (text[currentPos + 1] == current);
+
+         // pipes and list operators end the command, so don't read past them
+         if (current == '|')
+            return doubled ? TOKEN_OR : TOKEN_PIPE;
+         if (current == ';')
+            return TOKEN_SEMICOLON;
+         if (current == '&' && doubled)
+            return TOKEN_AND;
+
+         currentPos++;
+
+         if (current == '<')
+            return TOKEN_INPUT;
+         if (current == '>')
+            return TOKEN_OUTPUT;
+         return TOKEN_BACKGROUND;
+      }
+
+      if (move.actions & ACT_START)
+         word.start = words_used;
+
+      if (move.actions & ACT_GLOB) {
+         if (current == '~')
+            unsupported_feature = "tilde for home directory";
+         else
+            unsupported_feature = "wildcard characters";
+      }
+
+      if (move.actions & ACT_BACKSLASH)
+         appendChars("\\", 1);
+
+      if (move.actions & ACT_APPEND)
+         appendChars(&current, 1);
+
+      currentPos++;
+      state = move.next_state;
+
+      // skip ahead over chars that wouldn't change the state
+      if (state == STATE_WORD)
+         appendRun(map.nextBreak(currentPos));
+      else if (state == STATE_SQUOTE || state == STATE_DQUOTE)
+         appendRun(map.nextQuote(currentPos));
+   }
+
+   if (state == STATE_START)
+      return TOKEN_END;
+
+   if (state == STATE_ESCAPE) {
+      error_reason = "Nothing to escape at the end of the line.";
+      return TOKEN_ERROR;
+   }
+
+   if (state != STATE_WORD) {
+      error_reason = "Missing closing quote.";
+      return TOKEN_ERROR;
+   }
+
+   word.length = words_used - word.start;
+
+   // exec would cut the word short at a '\0', so don't let one in
+   if ((word.length > 0) && (memchr(&words[word.start], '\0', word.length) != NULL)) {
+      error_reason = "Null character in a word.";
+      return TOKEN_ERROR;
+   }
+
+   appendChars("", 1);
+
+   return TOKEN_WORD;
+}
+
+/******************************************************
+   Returns the position of the next char to be read.
+*/
+int Lexer::getPosition() const {
+   return currentPos;
+}
+
+/******************************************************
+   Returns the reason for the last TOKEN_ERROR.
+
+   POST: Returns "none" if there wasn't an error.
+*/
+const char * Lexer::getErrorReason() const {
+   return error_reason;
+}
+
+/******************************************************
+   Returns the last unsupported feature found outside
+   of quotes.
+
+   POST: Returns "none" if there wasn't one.
+*/
+const char * Lexer::getUnsupportedFeature() const {
+   return unsupported_feature;
+}
+
+/******************************************************
+   Copies the chars from currentPos up to endPos onto
+   the end of words without looking at them one by one.
+
+   PRE:  None of the chars in the range would change
+         the state of the lexer.
+
+   POST: currentPos is endPos.
+*/
+void Lexer::appendRun(int endPos) {
+
+   if (endPos > currentPos) {
+      appendChars(text.data() + currentPos, endPos - currentPos);
+      currentPos = endPos;
+   }
+}
+
+/******************************************************
+   Copies num_chars chars onto the end of the words.
+   words is grown by doubling and only trimmed back in
+   the destructor, so most calls are just a memcpy().
+
+   POST: The chars are at the end of the used part of
+         words.
+*/
+void Lexer::appendChars(const char *chars, int num_chars) {
+
+   int needed = words_used + num_chars;
+
+   if (needed > words.size()) {
+
+      // use up the capacity there already is before growing it,
+      // and start big enough that short commands only grow once
+      if (needed <= words.capacity())
+         words.resize(min((int) words.capacity(), 2 * needed));
+      else
+         words.resize(max(2 * needed, MIN_WORDS_SIZE));
+   }
+
+   memcpy(&words[words_used], chars, num_chars);
+   words_used = needed;
+}
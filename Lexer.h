@@ -0,0 +1,155 @@
+/* file: Lexer.h
+
+   Command Line Lexer Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class splits a command line into words and the
+   operators '<', '>', '&', '|', ';', '&&' and '||'. It understands
+   single quotes, double quotes and backslash escapes
+   the same way sh does, so a word like "my file" or
+   it\'s comes out as one word with the quotes and
+   backslashes taken out.
+
+   The lexer is a state machine driven by two tables:
+   one that sorts chars into classes and one that gives
+   the next state and what to do with the char for each
+   state and class. It reads every char once, left to
+   right, and never backs up. Runs of plain chars are
+   copied in one go by asking the CharMap of the line
+   where the next special char is.
+
+   The words are written one after another into a char
+   buffer owned by the caller, each followed by '\0',
+   so the buffer can be used for exec arguments as is.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   Lexer(const string &text, const CharMap &map, int startPos, vector<char> &words)
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      PRE:  map has been classified from text and
+            0 <= startPos <= length of text. text, map
+            and words have to outlive the lexer.
+
+      POST: The lexer will start reading at startPos and
+            adds the words it finds to the end of words.
+
+
+   ~Lexer()
+   --------------------------------------------------
+      This is the destructor for the class.
+
+      POST: words holds exactly the words that were
+            found, each followed by '\0'.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   TokenType nextToken(WordSpan &word)
+   --------------------------------------------------
+      Reads the next token of the line.
+
+      POST: Returns the type of the token. For TOKEN_WORD
+            word is where the unquoted word was put in the
+            words buffer. Operators that end a command ('|',
+            ';', '&&' and '||') are not read past, so every
+            call after one of them returns the same token
+            again.
+            TOKEN_ERROR means a quote was never closed, the
+            line ended in a backslash or a word had a '\0'
+            in it.
+
+
+   int getPosition() const
+   --------------------------------------------------
+      Returns the position in the line of the next char
+      the lexer will read.
+
+
+   const char * getErrorReason() const
+   --------------------------------------------------
+      Returns the reason for the last TOKEN_ERROR, or
+      "none" if there wasn't one.
+
+
+   const char * getUnsupportedFeature() const
+   --------------------------------------------------
+      Returns the name of the last unsupported feature
+      (wildcards or tilde) found outside of quotes, or
+      "none" if there wasn't one.
+
+*/
+
+#ifndef LEXER_HEADER
+#define LEXER_HEADER
+
+#include <string>
+#include <vector>
+#include "CharMap.h"
+
+using namespace std;
+
+// location of a single word inside of a word buffer
+struct WordSpan {
+   int start;   // index of first char, -1 if not set
+   int length;  // number of chars in the word, not counting the '\0'
+};
+
+// kinds of tokens found by the lexer
+enum TokenType {
+   TOKEN_WORD,        // a word with its quotes and escapes taken out
+   TOKEN_INPUT,       // '<'
+   TOKEN_OUTPUT,      // '>'
+   TOKEN_BACKGROUND,  // '&'
+   TOKEN_PIPE,        // '|', which ends a command
+   TOKEN_SEMICOLON,   // ';', which ends a pipeline
+   TOKEN_AND,         // '&&', which ends a pipeline
+   TOKEN_OR,          // '||', which ends a pipeline
+   TOKEN_END,         // end of the line
+   TOKEN_ERROR        // unfinished quote or escape, or a '\0'
+};
+
+class Lexer {
+
+    public:
+
+         // constructor and destructor
+         Lexer(const string &text, const CharMap &map, int startPos, vector<char> &words);
+         ~Lexer();
+
+         // token reading
+         TokenType nextToken(WordSpan &word);
+
+         // get functions
+         int getPosition() const;
+         const char * getErrorReason() const;
+         const char * getUnsupportedFeature() const;
+
+    private:
+
+         // copy plain chars up to endPos straight into the words
+         void appendRun(int endPos);
+         void appendChars(const char *chars, int num_chars);
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         const string &text;
+         const CharMap &map;
+         vector<char> &words;
+
+         int currentPos;
+         int words_used;    // words can be bigger while lexing
+         const char *error_reason;
+         const char *unsupported_feature;
+};
+
+#endif
@@ -0,0 +1,366 @@
+/* file: LineReader.cpp
+
+   Line Reader Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class reads command lines from a file descriptor
+   with read() or mmap() and splits them with memchr().
+
+*/
+
+#include "LineReader.h"
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+using namespace std;
+
+// least number of chars asked for by each read()
+const int READ_CHUNK_SIZE = 65536;
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: There is no input, nextLine() returns false.
+*/
+LineReader::LineReader() {
+   fd = -1;
+   mode = READ_NONE;
+   input_shared = false;
+   mapped = NULL;
+   mapped_size = 0;
+   mapped_pos = 0;
+   buffer_start = 0;
+   buffer_end = 0;
+   at_eof = true;
+}
+
+/******************************************************
+   This is the destructor for the class.
+
+   POST: A mapped file has been unmapped.
+*/
+LineReader::~LineReader() {
+
+   if (mode == READ_MAPPED)
+      munmap(mapped, mapped_size);
+}
+
+/******************************************************
+   Starts reading lines from new_fd. A terminal is read
+   as it comes, a regular file is mapped if it can be,
+   and everything else is read in chunks.
+
+   PRE:  new_fd is open for reading.
+
+   POST: The next line read is the one at the current
+         offset of new_fd.
+*/
+void LineReader::openInput(int new_fd) {
+
+   if (mode == READ_MAPPED)
+      munmap(mapped, mapped_size);
+
+   mapped = NULL;
+
+   fd = new_fd;
+   input_shared = false;
+   buffer_start = 0;
+   buffer_end = 0;
+   at_eof = false;
+
+   if (isatty(fd)) {
+      mode = READ_TERMINAL;
+      return;
+   }
+
+   struct stat file_info;
+
+   if ((fstat(fd, &file_info) == 0) && S_ISREG(file_info.st_mode)
+       && (file_info.st_size > 0) && mapFile(file_info.st_size)) {
+      mode = READ_MAPPED;
+      return;
+   }
+
+   mode = READ_CHUNKS;
+}
+
+/******************************************************
+   Returns true if the input is a terminal.
+*/
+bool LineReader::isInteractive() const {
+   return mode == READ_TERMINAL;
+}
+
+/******************************************************
+   Returns the fd the next line has to be read from, if
+   there isn't a whole one in the buffer yet. Mapped
+   files and strings never wait.
+
+   POST: Returns fd, or -1 if nextLine() won't read().
+*/
+int LineReader::getWaitFd() const {
+
+   if (((mode != READ_TERMINAL) && (mode != READ_CHUNKS)) || at_eof)
+      return -1;
+
+   if ((buffer_end > buffer_start)
+       && (memchr(buffer.data() + buffer_start, '\n', buffer_end - buffer_start) != NULL))
+      return -1;
+
+   return fd;
+}
+
+/******************************************************
+   Starts reading lines out of a string. It is walked
+   the same way a mapped file is, but nothing else can
+   read it so it is never shared.
+
+   PRE:  text stays good while lines are read.
+
+   POST: The next line is the start of text.
+*/
+void LineReader::openString(const char *text, long length) {
+
+   if (mode == READ_MAPPED)
+      munmap(mapped, mapped_size);
+
+   fd = -1;
+   mode = READ_STRING;
+   input_shared = false;
+   mapped = (char *) text;
+   mapped_size = length;
+   mapped_pos = 0;
+   at_eof = true;
+}
+
+/******************************************************
+   Gets the input ready to be shared with a command.
+   Only a mapped file has to do anything: its offset is
+   moved just past the lines read so far.
+
+   POST: The offset of fd is where a command reading it
+         should start.
+*/
+void LineReader::shareInput() {
+
+   if ((mode != READ_MAPPED) || input_shared)
+      return;
+
+   lseek(fd, mapped_pos, SEEK_SET);
+   input_shared = true;
+}
+
+/******************************************************
+   Reads the next line. Mapped files are split in place.
+   Otherwise the buffer is searched for a '\n' and more
+   is read in until there is one; the part that was
+   already searched isn't searched again, so a long line
+   is still read in linear time.
+
+   POST: Returns false at the end of the input, otherwise
+         line is set and stays good until the next call.
+*/
+bool LineReader::nextLine(LineView &line) {
+
+   if (mode == READ_NONE)
+      return false;
+
+   if ((mode == READ_MAPPED) || (mode == READ_STRING)) {
+
+      // pick up where a command that read standard input left off
+      if (input_shared) {
+
+         off_t offset = lseek(fd, 0, SEEK_CUR);
+         if (offset >= 0)
+            mapped_pos = offset;
+
+         input_shared = false;
+      }
+
+      if (mapped_pos >= mapped_size)
+         return false;
+
+      const char *start = mapped + mapped_pos;
+      const char *newline = (const char *) memchr(start, '\n', mapped_size - mapped_pos);
+
+      line.chars = start;
+
+      if (newline == NULL) {
+         line.length = mapped_size - mapped_pos;
+         mapped_pos = mapped_size;
+      } else {
+         line.length = newline - start;
+         mapped_pos += line.length + 1;
+      }
+
+      return true;
+   }
+
+   int searched = 0;
+
+   while (true) {
+
+      char *start = buffer.data() + buffer_start;
+      char *newline = NULL;
+
+      if (buffer_end - buffer_start > searched)
+         newline = (char *) memchr(start + searched, '\n', buffer_end - buffer_start - searched);
+
+      if (newline != NULL) {
+         line.chars = start;
+         line.length = newline - start;
+         buffer_start += line.length + 1;
+         return true;
+      }
+
+      searched = buffer_end - buffer_start;
+
+      if (at_eof || !fillBuffer()) {
+
+         // a last line without a '\n'
+         if (buffer_end > buffer_start) {
+            line.chars = buffer.data() + buffer_start;
+            line.length = buffer_end - buffer_start;
+            buffer_start = buffer_end;
+            return true;
+         }
+
+         return false;
+      }
+   }
+}
+
+/******************************************************
+   Checks if only blank space is left after the line
+   just read. For a pipe, whatever is already waiting
+   in it is read in, but poll() makes sure read() is
+   never called when it would block.
+
+   POST: Returns true if the input has nothing but
+         spaces, tabs and newlines left.
+*/
+bool LineReader::atEnd() {
+
+   if ((mode == READ_MAPPED) || (mode == READ_STRING)) {
+
+      long pos = mapped_pos;
+
+      // a command may have read further than the shell has
+      if (input_shared) {
+         off_t offset = lseek(fd, 0, SEEK_CUR);
+         if (offset >= 0)
+            pos = offset;
+      }
+
+      return (pos >= mapped_size) || onlyBlanks(mapped + pos, mapped_size - pos);
+   }
+
+   if (mode != READ_CHUNKS)
+      return false;
+
+   while (onlyBlanks(buffer.data() + buffer_start, buffer_end - buffer_start)) {
+
+      if (at_eof)
+         return true;
+
+      struct pollfd waiting = { fd, POLLIN, 0 };
+
+      if (poll(&waiting, 1, 0) != 1)
+         return false;
+
+      fillBuffer();
+   }
+
+   return false;
+}
+
+/******************************************************
+   Checks a run of chars for anything but blank space.
+
+   POST: Returns true if they are all spaces, tabs or
+         newlines.
+*/
+bool LineReader::onlyBlanks(const char *chars, long length) {
+
+   for (long charCtr = 0; charCtr < length; charCtr++) {
+
+      char current = chars[charCtr];
+
+      if ((current != ' ') && (current != '\t') && (current != '\n') && (current != '\r'))
+         return false;
+   }
+
+   return true;
+}
+
+/******************************************************
+   Maps the input file from its start, and starts at
+   the current offset like read() would.
+
+   PRE:  fd is a regular file of file_size chars.
+
+   POST: Returns true if the file was mapped.
+*/
+bool LineReader::mapFile(long file_size) {
+
+   off_t offset = lseek(fd, 0, SEEK_CUR);
+   if (offset < 0)
+      return false;
+
+   void *file_chars = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   if (file_chars == MAP_FAILED)
+      return false;
+
+   // the lines are only ever read once, front to back
+   madvise(file_chars, file_size, MADV_SEQUENTIAL);
+
+   mapped = (char *) file_chars;
+   mapped_size = file_size;
+   mapped_pos = offset;
+
+   return true;
+}
+
+/******************************************************
+   Reads more of the input into the buffer. The chars
+   that haven't been handed out are moved to the front
+   first, and the buffer is doubled if they fill it.
+
+   POST: Returns true if something was read. Otherwise
+         at_eof is set.
+*/
+bool LineReader::fillBuffer() {
+
+   int leftover = buffer_end - buffer_start;
+
+   if (buffer_start > 0) {
+      memmove(buffer.data(), buffer.data() + buffer_start, leftover);
+      buffer_start = 0;
+      buffer_end = leftover;
+   }
+
+   if (buffer.size() - buffer_end < READ_CHUNK_SIZE)
+      buffer.resize(max(2 * buffer.size(), (size_t) (buffer_end + READ_CHUNK_SIZE)));
+
+   ssize_t num_read;
+
+   do {
+      num_read = read(fd, buffer.data() + buffer_end, buffer.size() - buffer_end);
+   } while ((num_read < 0) && (errno == EINTR));
+
+   if (num_read <= 0) {
+      at_eof = true;
+      return false;
+   }
+
+   buffer_end += num_read;
+
+   return true;
+}
@@ -0,0 +1,200 @@
+/* file: LineReader.h
+
+   Line Reader Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class reads the command lines the shell runs
+   straight from a file descriptor, without iostreams.
+   How it reads depends on what the descriptor is:
+
+      terminal       read() one line at a time, the way
+                     the terminal hands them over, and
+                     the shell prints a prompt
+      regular file   mmap() the whole file and walk it
+      anything else  read() in big chunks, for pipes
+
+   The lines can also come from a string in memory, for
+   "wsh -c".
+
+   Lines are split with memchr() and handed out as views
+   into the buffer or the mapped file, so nothing is
+   copied on the way to the parser.
+
+   NOTE: Commands that read standard input themselves
+         share the descriptor with the shell. For a
+         regular file shareInput() moves the offset to
+         the end of the lines read so far before a
+         command starts, and the next line is read from
+         wherever the command left the offset, so they
+         share the file the same way they would in sh.
+         For a pipe the shell may have read ahead of
+         them, which can't be undone.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   LineReader()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: The reader isn't reading from anything,
+            nextLine() returns false until openInput()
+            is called.
+
+
+   ~LineReader()
+   --------------------------------------------------
+      This is the destructor for the class.
+
+      POST: A mapped file has been unmapped. The file
+            descriptor is left open.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   void openInput(int new_fd)
+   --------------------------------------------------
+      Starts reading lines from new_fd, picking the
+      way to read it as described above.
+
+      PRE:  new_fd is open for reading.
+
+      POST: The next line read is the one at the current
+            offset of new_fd.
+
+
+   void openString(const char *text, long length)
+   --------------------------------------------------
+      Starts reading lines out of text instead of a
+      file descriptor.
+
+      PRE:  text stays good while lines are read.
+
+      POST: The next line read is the start of text.
+
+
+   bool isInteractive() const
+   --------------------------------------------------
+      Returns true if the input is a terminal, in which
+      case the shell should prompt for each line.
+
+
+   int getWaitFd() const
+   --------------------------------------------------
+      Returns the file descriptor nextLine() would have
+      to wait on for the next line, so the shell can
+      wait on it along with other things.
+
+      POST: Returns -1 if the next line is already in
+            memory or nothing is left to read.
+
+
+   void shareInput()
+   --------------------------------------------------
+      Gets the input ready for a command that might read
+      from it. Should be called before each command is
+      started; it costs one lseek() per line at most.
+
+      POST: The offset of the file descriptor is just
+            past the last line handed out.
+
+
+   bool nextLine(LineView &line)
+   --------------------------------------------------
+      Reads the next line, without the '\n' at the end.
+      A last line without a '\n' is still returned.
+
+      POST: Returns false at the end of the input or on
+            a read error, otherwise line is set. The view
+            stays good until the next call.
+
+
+   bool atEnd()
+   --------------------------------------------------
+      Checks if the line just read was the last one, so
+      the shell can exec its last command in place. It
+      never waits: a pipe is only read if there is
+      something waiting in it.
+
+      POST: Returns true if nothing but blank space is
+            left in the input. Returns false if there is
+            more, or if it can't tell yet (a terminal, or
+            a pipe the writer hasn't closed). The view
+            from nextLine() may not be good any more.
+
+*/
+
+#ifndef READER_HEADER
+#define READER_HEADER
+
+#include <vector>
+
+using namespace std;
+
+// a line of input that isn't copied out of the reader
+struct LineView {
+   const char *chars;   // first char, not '\0' terminated
+   int length;          // number of chars, not counting the '\n'
+};
+
+class LineReader {
+
+    public:
+
+         // constructor and destructor
+         LineReader();
+         ~LineReader();
+
+         // input setup
+         void openInput(int new_fd);
+         void openString(const char *text, long length);
+         bool isInteractive() const;
+         int getWaitFd() const;
+         void shareInput();
+
+         // reading
+         bool nextLine(LineView &line);
+         bool atEnd();
+
+    private:
+
+         // ways of reading the input
+         enum ReadMode {
+            READ_NONE,       // no input yet
+            READ_TERMINAL,   // read() whatever the terminal gives
+            READ_MAPPED,     // walk a mmap()ed regular file
+            READ_CHUNKS,     // read() big chunks
+            READ_STRING      // walk a string, like a mapped file
+         };
+
+         bool mapFile(long file_size);
+         bool fillBuffer();
+         static bool onlyBlanks(const char *chars, long length);
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         int fd;
+         ReadMode mode;
+         bool input_shared;   // a command may have moved the offset
+
+         // the mapped file, for READ_MAPPED and READ_STRING
+         char *mapped;
+         long mapped_size;
+         long mapped_pos;     // start of the next line
+
+         // read() buffer, chars from buffer_start up to buffer_end
+         // haven't been handed out yet
+         vector<char> buffer;
+         int buffer_start;
+         int buffer_end;
+         bool at_eof;
+};
+
+#endif
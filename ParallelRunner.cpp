@@ -0,0 +1,516 @@
+/* file: ParallelRunner.cpp
+
+   Parallel Runner Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class runs the "parallel" builtin, starting a
+   job for each line of its input from a command
+   template and reaping them as they finish.
+
+*/
+
+#include "ParallelRunner.h"
+#include "JobManager.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <csignal>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+// how much of a job's output is read at a time
+const int RUNNER_READ_BYTES = 64 * 1024;
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: The object is ready to run jobs.
+*/
+ParallelRunner::ParallelRunner() {
+   command = NULL;
+   ordered = false;
+   out_fd = -1;
+   status = 0;
+   num_running = 0;
+   num_started = 0;
+   input_done = false;
+   input_ready = false;
+   job_manager = NULL;
+}
+
+/******************************************************
+   Runs the command template for every line of in_fd.
+   Each time around, as many jobs are started as there
+   is room for, whatever output can go is written, and
+   then the shell waits for a job to finish or write
+   something, or for the next line.
+
+   PRE:  command has at least one word. max_jobs > 0.
+         in_fd and out_fd are blocking.
+
+   POST: Every job has finished. Returns the status of
+         the run.
+*/
+int ParallelRunner::run(const vector<string> &new_command, int max_jobs, bool new_ordered, int in_fd, int new_out_fd) {
+
+   command = &new_command;
+   ordered = new_ordered;
+   out_fd = new_out_fd;
+   status = 0;
+   num_running = 0;
+   num_started = 0;
+   input_done = false;
+   input_ready = false;
+   jobs.clear();
+
+   lines.openInput(in_fd);
+
+   // a reader that quits early shouldn't take the shell with it
+   memset(&ignore_pipe, 0, sizeof(ignore_pipe));
+   ignore_pipe.sa_handler = SIG_IGN;
+   sigemptyset(&ignore_pipe.sa_mask);
+   sigaction(SIGPIPE, &ignore_pipe, &old_pipe_action);
+
+   while (true) {
+
+      while (!input_done && (num_running < max_jobs)) {
+
+         // a line that hasn't come yet mustn't hold up the jobs
+         if ((num_running > 0) && !input_ready && (lines.getWaitFd() != -1))
+            break;
+
+         input_ready = false;
+
+         LineView line;
+
+         if (!lines.nextLine(line)) {
+            input_done = true;
+            break;
+         }
+
+         if (line.length == 0)
+            continue;
+
+         fillArgs(line);
+
+         if (!startJob())
+            input_done = true;
+      }
+
+      // nobody is reading the output any more
+      if (!writeOutput())
+         break;
+
+      if (input_done && jobs.empty())
+         break;
+
+      polls.clear();
+
+      int wait_fd = -1;
+
+      if (!input_done && (num_running < max_jobs))
+         wait_fd = lines.getWaitFd();
+
+      if (wait_fd != -1) {
+         struct pollfd input = { wait_fd, POLLIN, 0 };
+         polls.push_back(input);
+      }
+
+      for (int jobCtr = 0; jobCtr < jobs.size(); jobCtr++) {
+
+         if (jobs[jobCtr].from_fd != -1) {
+            struct pollfd job_output = { jobs[jobCtr].from_fd, POLLIN, 0 };
+            polls.push_back(job_output);
+         } else if (!jobs[jobCtr].reaped && (jobs[jobCtr].pid_fd != -1)) {
+            struct pollfd job_exit = { jobs[jobCtr].pid_fd, POLLIN, 0 };
+            polls.push_back(job_exit);
+         }
+      }
+
+      // only jobs without pidfds left, so wait for the oldest
+      if (polls.empty()) {
+
+         for (int jobCtr = 0; jobCtr < jobs.size(); jobCtr++) {
+            if (!jobs[jobCtr].reaped) {
+               reapJob(jobs[jobCtr], true);
+               break;
+            }
+         }
+
+         removeReaped();
+         continue;
+      }
+
+      // the shell's background jobs that finish meanwhile are reaped
+      int num_fds = polls.size();
+      int job_fd = (job_manager != NULL) ? job_manager->getWaitFd() : -1;
+
+      if (job_fd != -1) {
+         struct pollfd background = { job_fd, POLLIN, 0 };
+         polls.push_back(background);
+      }
+
+      if (poll(polls.data(), polls.size(), -1) == -1) {
+
+         if (errno == EINTR)
+            continue;
+
+         break;
+      }
+
+      if ((job_fd != -1) && polls[num_fds].revents)
+         job_manager->reapReady();
+
+      // the fds are in the same order they were added, the
+      // next line is read the next time around
+      int pollCtr = 0;
+
+      if (wait_fd != -1)
+         input_ready = polls[pollCtr++].revents;
+
+      for (int jobCtr = 0; jobCtr < jobs.size(); jobCtr++) {
+
+         ArgJob &job = jobs[jobCtr];
+
+         if (job.from_fd != -1) {
+            if (polls[pollCtr++].revents)
+               drainJob(job);
+         } else if (!job.reaped && (job.pid_fd != -1)) {
+            if (polls[pollCtr++].revents)
+               reapJob(job, false);
+         }
+      }
+
+      removeReaped();
+   }
+
+   stopAll();
+
+   sigaction(SIGPIPE, &old_pipe_action, NULL);
+
+   // whatever wasn't run isn't going to be, and a script
+   // that is also the shell's input goes on after it
+   lseek(in_fd, 0, SEEK_END);
+
+   return status;
+}
+
+/******************************************************
+   Returns how many jobs the last run() started.
+*/
+int ParallelRunner::getNumStarted() const {
+   return num_started;
+}
+
+/******************************************************
+   Sets the JobManager that waits for the jobs, or NULL
+   to wait for them with waitpid() alone.
+
+   PRE:  new_job_manager outlives this object.
+*/
+void ParallelRunner::setJobManager(JobManager *new_job_manager) {
+   job_manager = new_job_manager;
+}
+
+/******************************************************
+   Puts a line into the command template, building the
+   argument array of the next job in args and argv.
+
+   POST: Every "{}" in a word is replaced by the line,
+         or the line is the last argument if there were
+         none.
+*/
+void ParallelRunner::fillArgs(const LineView &line) {
+
+   bool substituted = false;
+
+   args.resize(command->size());
+
+   for (int wordCtr = 0; wordCtr < command->size(); wordCtr++) {
+
+      const string &word = (*command)[wordCtr];
+      string &arg = args[wordCtr];
+      size_t start = 0;
+      size_t found;
+
+      arg.clear();
+
+      while ((found = word.find("{}", start)) != string::npos) {
+         arg.append(word, start, found - start);
+         arg.append(line.chars, line.length);
+         start = found + 2;
+         substituted = true;
+      }
+
+      arg.append(word, start, string::npos);
+   }
+
+   if (!substituted) {
+      args.resize(command->size() + 1);
+      args.back().assign(line.chars, line.length);
+   }
+
+   argv.clear();
+
+   for (int argCtr = 0; argCtr < args.size(); argCtr++)
+      argv.push_back(&args[argCtr][0]);
+
+   argv.push_back(NULL);
+}
+
+/******************************************************
+   Starts a job with the arguments in argv. In ordered
+   mode its output goes to a new pipe, otherwise it is
+   given out_fd, and a pidfd to know when it exits.
+
+   POST: Returns false with the error printed if the
+         job couldn't be started.
+*/
+bool ParallelRunner::startJob() {
+
+   int from_pipe[2];
+
+   if (ordered && (pipe2(from_pipe, O_CLOEXEC) == -1)) {
+      cout << "Could not create pipe:" << endl;
+      cout << "  " << strerror(errno) << "." << endl;
+      status = 1;
+      return false;
+   }
+
+   spawner.reset();
+   spawner.addOpen(0, "/dev/null", O_RDONLY, 0);
+
+   if (ordered)
+      spawner.addDup2(from_pipe[1], 1);
+   else if (out_fd != 1)
+      spawner.addDup2(out_fd, 1);
+
+   // an ignored signal stays ignored across exec, and the
+   // jobs should die of SIGPIPE like any other
+   sigaction(SIGPIPE, &old_pipe_action, NULL);
+   pid_t pid = spawner.spawn(argv.data());
+   sigaction(SIGPIPE, &ignore_pipe, NULL);
+
+   // the job has its own end now
+   if (ordered)
+      close(from_pipe[1]);
+
+   if (pid == -1) {
+      spawner.printFailure();
+
+      if (ordered)
+         close(from_pipe[0]);
+
+      if (status == 0)
+         status = spawner.getFailureStatus();
+      return false;
+   }
+
+   jobs.push_back(ArgJob());
+
+   ArgJob &job = jobs.back();
+   job.pid = pid;
+   job.pid_fd = -1;
+   job.from_fd = -1;
+   job.reaped = false;
+   job.output_sent = 0;
+
+   if (ordered) {
+
+      // only the shell has this end, so the job isn't affected
+      fcntl(from_pipe[0], F_SETFL, O_NONBLOCK);
+      job.from_fd = from_pipe[0];
+
+   } else {
+
+#ifdef SYS_pidfd_open
+      job.pid_fd = syscall(SYS_pidfd_open, pid, 0);
+#endif
+   }
+
+   num_running++;
+   num_started++;
+
+   return true;
+}
+
+/******************************************************
+   Reads what a job has written onto the end of its
+   output. After a short read the pipe is read once
+   more: a short job has usually exited by then, so its
+   end is seen without waiting on the pipe again. A job
+   that fills the pipe goes back to waiting, so it
+   can't keep the others from being seen to.
+
+   POST: The job is reaped if its output ended.
+*/
+void ParallelRunner::drainJob(ArgJob &job) {
+
+   int num_read;
+
+   do {
+      int old_size = job.output.size();
+      job.output.resize(old_size + RUNNER_READ_BYTES);
+
+      num_read = read(job.from_fd, job.output.data() + old_size, RUNNER_READ_BYTES);
+
+      job.output.resize(old_size + max(num_read, 0));
+   } while ((num_read > 0) && (num_read < RUNNER_READ_BYTES));
+
+   if (num_read > 0)
+      return;
+
+   if ((num_read == -1) && ((errno == EAGAIN) || (errno == EINTR)))
+      return;
+
+   close(job.from_fd);
+   job.from_fd = -1;
+   reapJob(job, true);
+}
+
+/******************************************************
+   Waits for a job. Without block set it is only reaped
+   if it has already exited. With it, the JobManager
+   waits if there is one, reaping background jobs that
+   finish in the meantime.
+
+   POST: If the job was reaped, its pidfd is closed, it
+         no longer counts as running, and status is set
+         if this is the first job that failed.
+*/
+void ParallelRunner::reapJob(ArgJob &job, bool block) {
+
+   int job_status;
+   pid_t reaped_pid;
+
+   if (block && (job_manager != NULL)) {
+      reaped_pid = job_manager->waitForChild(job.pid, job_status) ? job.pid : -1;
+   } else {
+      do {
+         reaped_pid = waitpid(job.pid, &job_status, block ? 0 : WNOHANG);
+      } while ((reaped_pid == -1) && (errno == EINTR));
+   }
+
+   if (reaped_pid == 0)
+      return;
+
+   job.reaped = true;
+   num_running--;
+
+   if (job.pid_fd != -1) {
+      close(job.pid_fd);
+      job.pid_fd = -1;
+   }
+
+   if ((reaped_pid == -1) || (status != 0))
+      return;
+
+   if (WIFEXITED(job_status))
+      status = WEXITSTATUS(job_status);
+   else if (WIFSIGNALED(job_status))
+      status = 128 + WTERMSIG(job_status);
+}
+
+/******************************************************
+   Forgets the jobs that have been reaped, in streaming
+   mode. Ordered jobs are forgotten once their output
+   has been written.
+*/
+void ParallelRunner::removeReaped() {
+
+   if (ordered)
+      return;
+
+   for (int jobCtr = jobs.size() - 1; jobCtr >= 0; jobCtr--) {
+      if (jobs[jobCtr].reaped)
+         jobs.erase(jobs.begin() + jobCtr);
+   }
+}
+
+/******************************************************
+   Writes whatever ordered output can go now: the
+   oldest job's, and the ones after it if it is
+   finished.
+
+   POST: Finished jobs with all of their output written
+         are gone. Returns false if out_fd couldn't be
+         written.
+*/
+bool ParallelRunner::writeOutput() {
+
+   if (!ordered)
+      return true;
+
+   while (!jobs.empty()) {
+
+      ArgJob &oldest = jobs.front();
+
+      if (!writeJobOutput(oldest))
+         return false;
+
+      if (!oldest.reaped)
+         break;
+
+      jobs.pop_front();
+   }
+
+   return true;
+}
+
+/******************************************************
+   Writes what is left of a job's output to out_fd.
+
+   POST: Returns false if out_fd couldn't be written.
+         The output is thrown out once it is written.
+*/
+bool ParallelRunner::writeJobOutput(ArgJob &job) {
+
+   while (job.output_sent < job.output.size()) {
+
+      int num_written = write(out_fd, job.output.data() + job.output_sent, job.output.size() - job.output_sent);
+
+      if ((num_written == -1) && (errno == EINTR))
+         continue;
+
+      if (num_written <= 0)
+         return false;
+
+      job.output_sent += num_written;
+   }
+
+   job.output.clear();
+   job.output_sent = 0;
+
+   return true;
+}
+
+/******************************************************
+   Lets go of every job that is left, when the run is
+   done or nobody wants its output.
+
+   POST: Every job has been waited for and jobs is
+         empty.
+*/
+void ParallelRunner::stopAll() {
+
+   for (int jobCtr = 0; jobCtr < jobs.size(); jobCtr++) {
+
+      ArgJob &job = jobs[jobCtr];
+
+      if (job.from_fd != -1) {
+         close(job.from_fd);
+         job.from_fd = -1;
+      }
+
+      if (!job.reaped)
+         reapJob(job, true);
+   }
+
+   jobs.clear();
+}
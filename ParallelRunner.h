@@ -0,0 +1,181 @@
+/* file: ParallelRunner.h
+
+   Parallel Runner Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class runs the "parallel" builtin, which works
+   like "xargs -P". Each line of its input is put into
+   a command template and run as a job, with no more
+   than the number of jobs asked for running at once.
+   A "{}" in a word of the template is replaced by the
+   line. If no word has one the line is added as the
+   last argument, so
+
+      parallel -j 4 gzip -9 < files.txt
+      parallel -j 8 -k convert {} {}.png < images.txt
+
+   both work. Blank lines are skipped. The jobs are
+   started with a Spawner, the same as any other, with
+   /dev/null on their standard input.
+
+   The lines are read with a LineReader of their own,
+   so a file of them is mapped and a pipe is read in
+   big chunks, and a line that hasn't come yet doesn't
+   hold up jobs that are finishing.
+
+   In streaming mode the jobs write straight to the
+   output, so nothing is copied, but the lines of jobs
+   running at the same time can be mixed together. A
+   job is reaped when its pidfd is ready.
+
+   In ordered mode ("-k") each job's output goes to a
+   pipe the shell reads. The output of the oldest job
+   is passed on as it comes, the others are kept until
+   it is their turn, so the output is in the order of
+   the input lines. A job is reaped once its output
+   has ended.
+
+   Standard error isn't touched in either mode.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   ParallelRunner()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: The object is ready to run jobs.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   int run(const vector<string> &command, int max_jobs, bool ordered, int in_fd, int out_fd)
+   --------------------------------------------------
+      Runs the command template once for every line
+      that can be read from in_fd, max_jobs at a time,
+      with the output going to out_fd.
+
+      PRE:  command has at least one word. max_jobs > 0.
+            in_fd and out_fd are blocking.
+
+      POST: Returns once in_fd is at its end and every
+            job has finished, or the output can't be
+            written any more. The offset of in_fd is
+            left at its end, so a shell script on it
+            doesn't run the lines as commands. Returns
+            0 if every job exited with 0, otherwise the
+            status of the first one that didn't, or of
+            the spawn that failed (no more jobs are
+            started after that).
+
+
+   int getNumStarted() const
+   --------------------------------------------------
+      Returns how many jobs the last run() started.
+
+
+   void setJobManager(JobManager *new_job_manager)
+   --------------------------------------------------
+      Sets the JobManager that waits for the jobs, so
+      the shell's background jobs are reaped while
+      run() goes on, or NULL to wait for them alone.
+
+      PRE:  new_job_manager outlives this object.
+
+*/
+
+#ifndef PARALLELRUNNER_HEADER
+#define PARALLELRUNNER_HEADER
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <csignal>
+#include <sys/types.h>
+#include "LineReader.h"
+#include "Spawner.h"
+
+using namespace std;
+
+class JobManager;
+
+class ParallelRunner {
+
+    public:
+
+         // constructor
+         ParallelRunner();
+
+         int run(const vector<string> &command, int max_jobs, bool ordered, int in_fd, int out_fd);
+         int getNumStarted() const;
+         void setJobManager(JobManager *new_job_manager);
+
+    private:
+
+         // one line of the input and the job running it
+         struct ArgJob {
+            pid_t pid;
+            int pid_fd;             // streaming mode, -1 if there are no pidfds
+            int from_fd;            // ordered mode, -1 at the end of the output
+            bool reaped;
+            vector<char> output;
+            int output_sent;
+         };
+
+         // starting jobs
+         void fillArgs(const LineView &line);
+         bool startJob();
+
+         // the jobs
+         void drainJob(ArgJob &job);
+         void reapJob(ArgJob &job, bool block);
+         void removeReaped();
+
+         // passing the output on
+         bool writeOutput();
+         bool writeJobOutput(ArgJob &job);
+         void stopAll();
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+         const vector<string> *command;
+         bool ordered;
+         int out_fd;
+         int status;
+         int num_running;
+         int num_started;
+
+         // the input lines
+         LineReader lines;
+         bool input_done;
+         bool input_ready;    // the next line can be read without waiting
+
+         // in the order of the input
+         deque<ArgJob> jobs;
+
+         // the args of the next job, kept so their space is reused
+         vector<string> args;
+         vector<char *> argv;
+
+         // room to poll every fd, kept between loops
+         vector<struct pollfd> polls;
+
+         // SIGPIPE is ignored while ordered output is written
+         struct sigaction ignore_pipe;
+         struct sigaction old_pipe_action;
+
+         // starts the jobs
+         Spawner spawner;
+
+         // waits for them, if there is one
+         JobManager *job_manager;
+};
+
+#endif
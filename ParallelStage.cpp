@@ -0,0 +1,504 @@
+/* file: ParallelStage.cpp
+
+   Parallel Stage Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class runs the PARALLEL= stage of a pipeline,
+   dealing chunks of its input to copies of the command
+   and putting their output back together.
+
+*/
+
+#include "ParallelStage.h"
+#include "JobManager.h"
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// how much is read from a pipe at a time
+const int PARALLEL_READ_BYTES = 64 * 1024;
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: The object is ready to run a stage.
+*/
+ParallelStage::ParallelStage() {
+   in_fd = -1;
+   out_fd = -1;
+   status = 0;
+   input_done = false;
+   job_manager = NULL;
+}
+
+/******************************************************
+   Runs copies of command on the input until it ends.
+   Each time around, as many chunks are started as
+   there is room for, whatever output can go is written,
+   and then the shell waits for any of the fds to be
+   ready.
+
+   PRE:  in_fd and out_fd are blocking.
+
+   POST: Every copy has finished. Returns the status
+         of the stage.
+*/
+int ParallelStage::run(const Command &command, const ParallelSpec &new_spec, int new_in_fd, int new_out_fd) {
+
+   spec = new_spec;
+   in_fd = new_in_fd;
+   out_fd = new_out_fd;
+   status = 0;
+   input_done = false;
+   pending.clear();
+   chunks.clear();
+
+   // a copy that quits early shouldn't take the shell with it
+   memset(&ignore_pipe, 0, sizeof(ignore_pipe));
+   ignore_pipe.sa_handler = SIG_IGN;
+   sigemptyset(&ignore_pipe.sa_mask);
+   sigaction(SIGPIPE, &ignore_pipe, &old_pipe_action);
+
+   while (true) {
+
+      // keep every copy busy, with a few finished chunks
+      // allowed to wait for their turn to be written
+      while ((countRunning() < spec.copies) && (chunks.size() < 2 * spec.copies)) {
+
+         int length = findChunkEnd();
+
+         if (length == 0)
+            break;
+
+         if (!startChunk(command, length)) {
+            input_done = true;
+            pending.clear();
+         }
+      }
+
+      // nobody is reading the output any more
+      if (!writeOutput())
+         break;
+
+      if (input_done && pending.empty() && chunks.empty())
+         break;
+
+      polls.clear();
+
+      bool reading = wantsInput();
+
+      if (reading) {
+         struct pollfd input = { in_fd, POLLIN, 0 };
+         polls.push_back(input);
+      }
+
+      for (int chunkCtr = 0; chunkCtr < chunks.size(); chunkCtr++) {
+
+         if (chunks[chunkCtr].to_fd != -1) {
+            struct pollfd copy_input = { chunks[chunkCtr].to_fd, POLLOUT, 0 };
+            polls.push_back(copy_input);
+         }
+
+         if (chunks[chunkCtr].from_fd != -1) {
+            struct pollfd copy_output = { chunks[chunkCtr].from_fd, POLLIN, 0 };
+            polls.push_back(copy_output);
+         }
+      }
+
+      // every copy is done and its output written
+      if (polls.empty())
+         break;
+
+      // background jobs that finish meanwhile are reaped
+      int num_fds = polls.size();
+      int job_fd = (job_manager != NULL) ? job_manager->getWaitFd() : -1;
+
+      if (job_fd != -1) {
+         struct pollfd jobs = { job_fd, POLLIN, 0 };
+         polls.push_back(jobs);
+      }
+
+      if (poll(polls.data(), polls.size(), -1) == -1) {
+
+         if (errno == EINTR)
+            continue;
+
+         break;
+      }
+
+      if ((job_fd != -1) && polls[num_fds].revents)
+         job_manager->reapReady();
+
+      // the fds are in the same order they were added
+      int pollCtr = 0;
+
+      if (reading && polls[pollCtr++].revents)
+         readInput();
+
+      for (int chunkCtr = 0; chunkCtr < chunks.size(); chunkCtr++) {
+
+         Chunk &chunk = chunks[chunkCtr];
+
+         if ((chunk.to_fd != -1) && polls[pollCtr++].revents)
+            feedCopy(chunk);
+
+         if ((chunk.from_fd != -1) && polls[pollCtr++].revents)
+            drainCopy(chunk);
+      }
+   }
+
+   stopAll();
+
+   sigaction(SIGPIPE, &old_pipe_action, NULL);
+
+   return status;
+}
+
+/******************************************************
+   Works out where the next chunk of pending ends: at
+   the last line end before chunk_bytes, or the first
+   one after it if a line is longer than that.
+
+   POST: Returns the length of the chunk, or 0 if more
+         input is needed to tell.
+*/
+int ParallelStage::findChunkEnd() const {
+
+   if (pending.empty())
+      return 0;
+
+   if (pending.size() < spec.chunk_bytes)
+      return input_done ? pending.size() : 0;
+
+   const char *line_end = (const char *) memrchr(pending.data(), '\n', spec.chunk_bytes);
+
+   if (line_end == NULL)
+      line_end = (const char *) memchr(pending.data() + spec.chunk_bytes, '\n', pending.size() - spec.chunk_bytes);
+
+   if (line_end != NULL)
+      return line_end - pending.data() + 1;
+
+   // one long line, it all goes to one copy
+   return input_done ? pending.size() : 0;
+}
+
+/******************************************************
+   Returns whether more input should be read now: if a
+   chunk can't be cut yet, or to keep one chunk ready
+   ahead of the copies.
+*/
+bool ParallelStage::wantsInput() const {
+
+   if (input_done)
+      return false;
+
+   return (pending.size() < 2 * spec.chunk_bytes) || (findChunkEnd() == 0);
+}
+
+/******************************************************
+   Reads what is waiting on in_fd onto the end of
+   pending.
+
+   POST: input_done is set at the end of the input.
+*/
+void ParallelStage::readInput() {
+
+   int old_size = pending.size();
+   pending.resize(old_size + PARALLEL_READ_BYTES);
+
+   int num_read = read(in_fd, pending.data() + old_size, PARALLEL_READ_BYTES);
+
+   if ((num_read == -1) && (errno == EINTR))
+      num_read = 0;
+   else if (num_read <= 0)
+      input_done = true;
+
+   pending.resize(old_size + max(num_read, 0));
+}
+
+/******************************************************
+   Takes the first length bytes of pending as a new
+   chunk and starts a copy of the command for it.
+
+   POST: Returns false with the error printed if the
+         copy couldn't be started.
+*/
+bool ParallelStage::startChunk(const Command &command, int length) {
+
+   int to_pipe[2];
+   int from_pipe[2];
+
+   if (pipe2(to_pipe, O_CLOEXEC) == -1) {
+      cout << "Could not create pipe:" << endl;
+      cout << "  " << strerror(errno) << "." << endl;
+      status = 1;
+      return false;
+   }
+
+   if (pipe2(from_pipe, O_CLOEXEC) == -1) {
+      cout << "Could not create pipe:" << endl;
+      cout << "  " << strerror(errno) << "." << endl;
+      close(to_pipe[0]);
+      close(to_pipe[1]);
+      status = 1;
+      return false;
+   }
+
+   spawner.reset();
+   spawner.addDup2(to_pipe[0], 0);
+   spawner.addDup2(from_pipe[1], 1);
+
+   // an ignored signal stays ignored across exec, and the
+   // copies should die of SIGPIPE like any other job
+   sigaction(SIGPIPE, &old_pipe_action, NULL);
+   pid_t pid = spawner.spawn(command.getArgsArray());
+   sigaction(SIGPIPE, &ignore_pipe, NULL);
+
+   // the copy has its own ends now
+   close(to_pipe[0]);
+   close(from_pipe[1]);
+
+   if (pid == -1) {
+      spawner.printFailure();
+      close(to_pipe[1]);
+      close(from_pipe[0]);
+
+      if (status == 0)
+         status = spawner.getFailureStatus();
+      return false;
+   }
+
+   // only the shell has these, so the copies aren't affected
+   fcntl(to_pipe[1], F_SETFL, O_NONBLOCK);
+   fcntl(from_pipe[0], F_SETFL, O_NONBLOCK);
+
+   chunks.push_back(Chunk());
+
+   Chunk &chunk = chunks.back();
+   chunk.pid = pid;
+   chunk.to_fd = to_pipe[1];
+   chunk.from_fd = from_pipe[0];
+   chunk.input.assign(pending.begin(), pending.begin() + length);
+   chunk.input_sent = 0;
+   chunk.output_sent = 0;
+
+   pending.erase(pending.begin(), pending.begin() + length);
+
+   return true;
+}
+
+/******************************************************
+   Writes as much of a chunk to its copy as the pipe
+   takes.
+
+   POST: to_fd is closed once the copy has the whole
+         chunk, or doesn't want any more of it.
+*/
+void ParallelStage::feedCopy(Chunk &chunk) {
+
+   int num_written = write(chunk.to_fd, chunk.input.data() + chunk.input_sent,
+                           chunk.input.size() - chunk.input_sent);
+
+   if (num_written > 0)
+      chunk.input_sent += num_written;
+   else if ((errno == EAGAIN) || (errno == EINTR))
+      return;
+
+   if ((num_written <= 0) || (chunk.input_sent == chunk.input.size())) {
+      close(chunk.to_fd);
+      chunk.to_fd = -1;
+      vector<char>().swap(chunk.input);
+   }
+}
+
+/******************************************************
+   Reads what a copy has written onto the end of its
+   chunk's output.
+
+   POST: The copy is finished if its output ended.
+*/
+void ParallelStage::drainCopy(Chunk &chunk) {
+
+   int old_size = chunk.output.size();
+   chunk.output.resize(old_size + PARALLEL_READ_BYTES);
+
+   int num_read = read(chunk.from_fd, chunk.output.data() + old_size, PARALLEL_READ_BYTES);
+
+   chunk.output.resize(old_size + max(num_read, 0));
+
+   if ((num_read == -1) && ((errno == EAGAIN) || (errno == EINTR)))
+      return;
+
+   if (num_read <= 0)
+      finishCopy(chunk);
+}
+
+/******************************************************
+   Closes a copy's pipes and waits for it.
+
+   POST: from_fd and to_fd are -1, and status is set
+         if this is the first copy that failed.
+*/
+void ParallelStage::finishCopy(Chunk &chunk) {
+
+   if (chunk.to_fd != -1) {
+      close(chunk.to_fd);
+      chunk.to_fd = -1;
+   }
+
+   close(chunk.from_fd);
+   chunk.from_fd = -1;
+
+   int copy_status;
+
+   if (job_manager != NULL) {
+      if (!job_manager->waitForChild(chunk.pid, copy_status))
+         return;
+   } else if (waitpid(chunk.pid, &copy_status, 0) == -1) {
+      return;
+   }
+
+   if (status != 0)
+      return;
+
+   if (WIFEXITED(copy_status))
+      status = WEXITSTATUS(copy_status);
+   else if (WIFSIGNALED(copy_status))
+      status = 128 + WTERMSIG(copy_status);
+}
+
+/******************************************************
+   Returns how many copies are still running.
+*/
+int ParallelStage::countRunning() const {
+
+   int num_running = 0;
+
+   for (int chunkCtr = 0; chunkCtr < chunks.size(); chunkCtr++) {
+      if (chunks[chunkCtr].from_fd != -1)
+         num_running++;
+   }
+
+   return num_running;
+}
+
+/******************************************************
+   Writes whatever output can go now. In ordered mode
+   that's the oldest chunk's, and the ones after it if
+   it is finished. In ready mode it's every whole line
+   any copy has written so far.
+
+   POST: Finished chunks with all of their output
+         written are gone. Returns false if out_fd
+         couldn't be written.
+*/
+bool ParallelStage::writeOutput() {
+
+   if (spec.ordered) {
+
+      while (!chunks.empty()) {
+
+         Chunk &oldest = chunks.front();
+
+         if (!writeChunkOutput(oldest, oldest.output.size()))
+            return false;
+
+         if (oldest.from_fd != -1)
+            break;
+
+         chunks.pop_front();
+      }
+
+      return true;
+   }
+
+   for (int chunkCtr = chunks.size() - 1; chunkCtr >= 0; chunkCtr--) {
+
+      Chunk &chunk = chunks[chunkCtr];
+      int length = chunk.output.size();
+
+      // only whole lines, so no two copies write into one line
+      if (chunk.from_fd != -1) {
+
+         const char *unsent = chunk.output.data() + chunk.output_sent;
+         const char *line_end = (const char *) memrchr(unsent, '\n', length - chunk.output_sent);
+
+         length = (line_end == NULL) ? chunk.output_sent : line_end - chunk.output.data() + 1;
+      }
+
+      if (!writeChunkOutput(chunk, length))
+         return false;
+
+      if (chunk.from_fd == -1)
+         chunks.erase(chunks.begin() + chunkCtr);
+   }
+
+   return true;
+}
+
+/******************************************************
+   Writes a chunk's output up to length to out_fd.
+
+   POST: Returns false if out_fd couldn't be written.
+         The written part of the output is thrown out
+         once it is all written.
+*/
+bool ParallelStage::writeChunkOutput(Chunk &chunk, int length) {
+
+   while (chunk.output_sent < length) {
+
+      int num_written = write(out_fd, chunk.output.data() + chunk.output_sent, length - chunk.output_sent);
+
+      if ((num_written == -1) && (errno == EINTR))
+         continue;
+
+      if (num_written <= 0)
+         return false;
+
+      chunk.output_sent += num_written;
+   }
+
+   if (chunk.output_sent == chunk.output.size()) {
+      chunk.output.clear();
+      chunk.output_sent = 0;
+   } else if (chunk.output_sent >= PARALLEL_READ_BYTES) {
+      chunk.output.erase(chunk.output.begin(), chunk.output.begin() + chunk.output_sent);
+      chunk.output_sent = 0;
+   }
+
+   return true;
+}
+
+/******************************************************
+   Lets go of every copy that is left, when the stage
+   is done or nobody wants its output.
+
+   POST: Every copy has been waited for and chunks is
+         empty.
+*/
+void ParallelStage::stopAll() {
+
+   for (int chunkCtr = 0; chunkCtr < chunks.size(); chunkCtr++) {
+      if (chunks[chunkCtr].from_fd != -1)
+         finishCopy(chunks[chunkCtr]);
+   }
+
+   chunks.clear();
+   pending.clear();
+}
+
+/******************************************************
+   Sets the JobManager that waits for the copies, or
+   NULL to wait for them with waitpid() alone.
+
+   PRE:  new_job_manager outlives this object.
+*/
+void ParallelStage::setJobManager(JobManager *new_job_manager) {
+   job_manager = new_job_manager;
+}
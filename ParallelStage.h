@@ -0,0 +1,153 @@
+/* file: ParallelStage.h
+
+   Parallel Stage Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class runs the PARALLEL= stage of a pipeline.
+   The shell reads the stage's input itself, cuts it
+   into chunks of about chunk_bytes that end at a line
+   end, and starts a copy of the command for each chunk
+   with the chunk on its standard input. No more than
+   the number of copies asked for run at once.
+
+   Each copy gets exactly one chunk, so what it writes
+   is known to belong to that chunk. In ordered mode
+   the output of the oldest chunk is passed on as it
+   comes and the others are kept until it is their
+   turn. In ready mode any copy's output is passed on
+   a whole line at a time, as soon as it comes.
+
+   A filter that works a line at a time (grep, sed,
+   tr, a JSON filter) gives the same output it would
+   have run once. One that sums up its whole input
+   (wc, sort) gives one answer per chunk instead.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   ParallelStage()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: The object is ready to run a stage.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   int run(const Command &command, const ParallelSpec &spec, int in_fd, int out_fd)
+   --------------------------------------------------
+      Runs copies of command on everything that can be
+      read from in_fd and writes their output to out_fd.
+
+      PRE:  in_fd and out_fd are blocking, and out_fd is
+            the only one the output goes to.
+
+      POST: Returns once in_fd is at its end and every
+            copy has finished, or the output can't be
+            written any more. Returns 0 if every copy
+            exited with 0, otherwise the status of the
+            first one that didn't, or of the spawn that
+            failed.
+
+
+   void setJobManager(JobManager *new_job_manager)
+   --------------------------------------------------
+      Sets the JobManager that waits for the copies, so
+      background jobs are reaped while the stage runs,
+      or NULL to wait for them alone.
+
+      PRE:  new_job_manager outlives this object.
+
+*/
+
+#ifndef PARALLELSTAGE_HEADER
+#define PARALLELSTAGE_HEADER
+
+#include <deque>
+#include <vector>
+#include <poll.h>
+#include <csignal>
+#include <sys/types.h>
+#include "Command.h"
+#include "PipedCommand.h"
+#include "Spawner.h"
+
+using namespace std;
+
+class JobManager;
+
+class ParallelStage {
+
+    public:
+
+         // constructor
+         ParallelStage();
+
+         int run(const Command &command, const ParallelSpec &spec, int in_fd, int out_fd);
+         void setJobManager(JobManager *new_job_manager);
+
+    private:
+
+         // one chunk of the input and the copy running it
+         struct Chunk {
+            pid_t pid;
+            int to_fd;              // the copy's input, -1 once it has it all
+            int from_fd;            // the copy's output, -1 at its end
+            vector<char> input;
+            int input_sent;
+            vector<char> output;
+            int output_sent;
+         };
+
+         // dealing out the input
+         int findChunkEnd() const;
+         bool wantsInput() const;
+         void readInput();
+         bool startChunk(const Command &command, int length);
+
+         // the copies
+         void feedCopy(Chunk &chunk);
+         void drainCopy(Chunk &chunk);
+         void finishCopy(Chunk &chunk);
+         int countRunning() const;
+
+         // passing the output on
+         bool writeOutput();
+         bool writeChunkOutput(Chunk &chunk, int length);
+         void stopAll();
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+         ParallelSpec spec;
+         int in_fd;
+         int out_fd;
+         int status;
+
+         // input read but not dealt out yet
+         vector<char> pending;
+         bool input_done;
+
+         // in the order of the input
+         deque<Chunk> chunks;
+
+         // room to poll every fd, kept between loops
+         vector<struct pollfd> polls;
+
+         // SIGPIPE is ignored while the stage runs
+         struct sigaction ignore_pipe;
+         struct sigaction old_pipe_action;
+
+         // starts the copies
+         Spawner spawner;
+
+         // waits for them, if there is one
+         JobManager *job_manager;
+};
+
+#endif
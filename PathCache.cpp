@@ -0,0 +1,246 @@
+/* file: PathCache.cpp
+
+   Command Path Cache Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class remembers where on the PATH each command
+   was found, and which commands weren't found at all.
+
+*/
+
+#include "PathCache.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// what execvp() searches when there is no PATH at all
+const char * const DEFAULT_PATH = "/bin:/usr/bin";
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: The table is empty and the PATH hasn't been
+         read yet.
+*/
+PathCache::PathCache() {
+   have_path = false;
+   dirs_checked = false;
+}
+
+/******************************************************
+   Finds the full path of a command, searching the PATH
+   the first time the name is seen.
+
+   POST: Returns the full path, or NULL if name isn't on
+         the PATH.
+*/
+const char * PathCache::lookup(const char *name) {
+
+   // already a path, nothing to look up
+   if (strchr(name, '/') != NULL)
+      return name;
+
+   checkPath();
+
+   unordered_map<string, PathEntry>::iterator found = table.find(name);
+
+   // first time, search the PATH and remember what turned up,
+   // even if it was nothing
+   if (found == table.end()) {
+
+      PathEntry entry;
+      entry.found = searchPath(name, entry.path);
+
+      found = table.insert(make_pair(string(name), entry)).first;
+   }
+
+   if (!found->second.found)
+      return NULL;
+
+   return found->second.path.c_str();
+}
+
+/******************************************************
+   Drops the entry for one command.
+
+   POST: The next lookup() of name searches the PATH.
+*/
+void PathCache::forget(const char *name) {
+   table.erase(name);
+}
+
+/******************************************************
+   Makes the next lookup() check the PATH directories.
+
+   POST: dirs_checked is false.
+*/
+void PathCache::recheckDirs() {
+   dirs_checked = false;
+}
+
+/******************************************************
+   Throws out the whole table.
+
+   POST: The table is empty.
+*/
+void PathCache::clear() {
+   table.clear();
+}
+
+/******************************************************
+   Prints every entry of the table to standard out.
+
+   POST: The table has been printed.
+*/
+void PathCache::printTable() const {
+
+   cout << "Command hash table:" << endl;
+
+   if (table.empty()) {
+      cout << "  empty" << endl;
+      return;
+   }
+
+   unordered_map<string, PathEntry>::const_iterator entry;
+
+   for (entry = table.begin(); entry != table.end(); entry++) {
+
+      if (entry->second.found)
+         cout << "  " << entry->first << "  " << entry->second.path << endl;
+      else
+         cout << "  " << entry->first << "  not found" << endl;
+   }
+}
+
+/******************************************************
+   Makes sure the table still matches the PATH. A new
+   PATH starts a new table, and so does a change to one
+   of its directories, but those are only looked at
+   once after each call to recheckDirs().
+
+   POST: Every entry of the table is still right, as far
+         as can be told.
+*/
+void PathCache::checkPath() {
+
+   const char *current = getenv("PATH");
+
+   if (current == NULL)
+      current = DEFAULT_PATH;
+
+   if (!have_path || (path_var != current)) {
+      table.clear();
+      readPath(current);
+      dirs_checked = true;
+      return;
+   }
+
+   if (!dirs_checked) {
+
+      if (dirsChanged())
+         table.clear();
+
+      dirs_checked = true;
+   }
+}
+
+/******************************************************
+   Splits a PATH into its directories and remembers
+   when each of them last changed. An empty directory
+   means the current one, like it does for execvp().
+
+   POST: path_var and dirs are set from new_path_var.
+*/
+void PathCache::readPath(const char *new_path_var) {
+
+   path_var = new_path_var;
+   have_path = true;
+   dirs.clear();
+
+   int start = 0;
+
+   while (start <= path_var.size()) {
+
+      int end = path_var.find(':', start);
+      if (end == string::npos)
+         end = path_var.size();
+
+      PathDir path_dir;
+      path_dir.dir = path_var.substr(start, end - start);
+
+      if (path_dir.dir.empty())
+         path_dir.dir = ".";
+
+      struct stat dir_info;
+
+      if (stat(path_dir.dir.c_str(), &dir_info) == 0)
+         path_dir.mtime = dir_info.st_mtim;
+      else
+         path_dir.mtime.tv_sec = path_dir.mtime.tv_nsec = 0;
+
+      dirs.push_back(path_dir);
+
+      start = end + 1;
+   }
+}
+
+/******************************************************
+   Checks if any PATH directory changed since it was
+   last looked at. A directory that appeared or went
+   away counts as a change.
+
+   POST: Returns true if one changed. The new times
+         have been saved.
+*/
+bool PathCache::dirsChanged() {
+
+   bool changed = false;
+
+   for (int dirCtr = 0; dirCtr < dirs.size(); dirCtr++) {
+
+      struct stat dir_info;
+      struct timespec mtime = { 0, 0 };
+
+      if (stat(dirs[dirCtr].dir.c_str(), &dir_info) == 0)
+         mtime = dir_info.st_mtim;
+
+      if ((mtime.tv_sec != dirs[dirCtr].mtime.tv_sec) || (mtime.tv_nsec != dirs[dirCtr].mtime.tv_nsec)) {
+         dirs[dirCtr].mtime = mtime;
+         changed = true;
+      }
+   }
+
+   return changed;
+}
+
+/******************************************************
+   Searches the PATH directories in order for a regular
+   file called name that can be executed.
+
+   POST: Returns true and sets found_path if one was
+         found, otherwise returns false.
+*/
+bool PathCache::searchPath(const char *name, string &found_path) const {
+
+   for (int dirCtr = 0; dirCtr < dirs.size(); dirCtr++) {
+
+      found_path = dirs[dirCtr].dir;
+      found_path += '/';
+      found_path += name;
+
+      struct stat file_info;
+
+      if ((stat(found_path.c_str(), &file_info) == 0) && S_ISREG(file_info.st_mode)
+          && (access(found_path.c_str(), X_OK) == 0))
+         return true;
+   }
+
+   found_path.clear();
+
+   return false;
+}
@@ -0,0 +1,130 @@
+/* file: PathCache.h
+
+   Command Path Cache Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class remembers where on the PATH each command
+   was found, so a command can be exec'd straight from
+   its full path instead of trying every directory of
+   the PATH in turn. Commands that aren't on the PATH
+   are remembered too, so a typo doesn't cost a walk of
+   the whole PATH every time.
+
+   The table is thrown out when the PATH variable
+   changes, or when one of its directories changes
+   (its mtime moves when a file is added, removed or
+   renamed in it). The directories are only looked at
+   once per command line, see recheckDirs().
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   PathCache()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: The table is empty.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   const char * lookup(const char *name)
+   --------------------------------------------------
+      Finds the full path of a command. Names with a
+      '/' in them are already paths and are returned
+      as they are.
+
+      POST: Returns the full path, or NULL if name isn't
+            on the PATH. The pointer stays good until
+            the table is changed.
+
+
+   void forget(const char *name)
+   --------------------------------------------------
+      Drops the entry for name, for when its path turned
+      out to be wrong.
+
+
+   void recheckDirs()
+   --------------------------------------------------
+      Makes the next lookup() look at the PATH
+      directories again to see if any of them changed.
+      The shell calls this once per command line.
+
+
+   void clear()
+   --------------------------------------------------
+      Throws out the whole table.
+
+
+   void printTable() const
+   --------------------------------------------------
+      Prints every entry to standard out.
+
+*/
+
+#ifndef PATHCACHE_HEADER
+#define PATHCACHE_HEADER
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <time.h>
+
+using namespace std;
+
+class PathCache {
+
+    public:
+
+         // constructor
+         PathCache();
+
+         // lookups
+         const char * lookup(const char *name);
+         void forget(const char *name);
+
+         // cache control
+         void recheckDirs();
+         void clear();
+         void printTable() const;
+
+    private:
+
+         // where a command was found, if it was
+         struct PathEntry {
+            string path;
+            bool found;
+         };
+
+         // a directory of the PATH and when it last changed
+         struct PathDir {
+            string dir;
+            struct timespec mtime;
+         };
+
+         void checkPath();
+         void readPath(const char *new_path_var);
+         bool dirsChanged();
+         bool searchPath(const char *name, string &found_path) const;
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         // command name to where it was found
+         unordered_map<string, PathEntry> table;
+
+         // the PATH the table was filled from
+         bool have_path;
+         string path_var;
+         vector<PathDir> dirs;
+         bool dirs_checked;
+};
+
+#endif
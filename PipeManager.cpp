@@ -1,424 +1,1065 @@
-/* file: PipeManager.cpp
-   
-   Pipe Manager Class Implementation File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the code needed to execute a
-   series of piped commands. It handles creation and
-   redirection to pipes of an instance of the PipedCommand
-   class.
-   
-*/
-
-#include "PipeManager.h"
-
-/******************************************************
-   This is the basic constructor for the class. It
-   must be passed a valid PipedCommand object.
-   
-   PRE:  new_command must be a parsed PipedCommand object.
-   
-   POST: The member variable my_command is initialized
-         to the piped command that the user passed.
-*/
-PipeManager::PipeManager(PipedCommand new_command) {
-   my_command = new_command;
-}
-
-/******************************************************
-   Tries to execute the job and then wait for it
-   to finish running.
-   
-   POST: Returns true if the job was successfully started
-         and finished running. Returns false if there
-         was an error.
-*/
-void PipeManager::execute() {
-
-   // create arrays to pass to pipe system call
-   createPipes();
-   
-   // create last child first
-   if (!createLastChild())
-      return;
-      
-   // create all middle children in reverse order
-   int num_middle_children = my_command.getCommands().size() - 2; // - 2 because we're doing first and last separately
-   for (int childCtr = num_middle_children; childCtr > 0; childCtr--) {
-      
-      if (!createMiddleChild(childCtr))
-         return;
-   }
-   
-   if (!createFirstChild())
-      return;
-   
-   // must be in parent now, close pipes and wait for children
-   closePipes();
-   waitForChildren();
-   deletePipes();
-
-   return;   
-}
-
-/******************************************************
-   Tries to redirect the output of the currently
-   running process to the passed file descriptor.
-   
-   PRE:  file_descriptor is a valid descriptor for
-         the write end of a pipe.
-   
-   POST: Returns after a successful redirect attempt.
-         Otherwise, an error message is printed and
-         the process terminates.
-*/
-void PipeManager::redirectOutput(int file_descriptor) {
-   
-   // linux system call to redirect output
-   int redirect_success = dup2(file_descriptor, 1);
-   
-   // check if something nasty happened
-   if (redirect_success == -1) {
-      cout << "Could not use pipeline:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }
-   
-   redirect_success = close(file_descriptor);
-   
-   // check if something nasty happened
-   if (redirect_success == -1) {
-      
-      cout << "Input file error:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }
-}
-
-/******************************************************
-   Tries to redirect the input of the currently
-   running process to the passed file descriptor.
-   
-   PRE:  file_descriptor is a valid descriptor for
-         the read end of a pipe.
-   
-   POST: Returns after a successful redirect attempt.
-         Otherwise, an error message is printed and
-         the process terminates.
-*/
-void PipeManager::redirectInput(int file_descriptor) {
-   
-   // linux system call to redirect input
-   int redirect_success = dup2(file_descriptor, 0);
-   
-   // check if something nasty happened
-   if (redirect_success == -1) {
-      cout << "Could not use pipeline:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }
-   
-   redirect_success = close(file_descriptor);
-   
-   // check if something nasty happened
-   if (redirect_success == -1) {
-      
-      cout << "Input file error:" << endl;
-      cout << "  " << strerror(errno) << "." << endl;
-      exit(-1);
-   }
-}
-
-/******************************************************
-   Tries to replace the currently running process with
-   the another job that needs to be run in the pipeline.
-   
-   PRE:  command_index is an integer that refers to a
-         job in the PipedCommand object my_command.
-   
-   POST: Does not return if successful. If an error was
-         encountered, an error message is printed and
-         the process terminates.
-*/
-void PipeManager::callExec(int command_index) {
-      
-      // do a quick reality check
-      if (command_index >= my_command.getCommands().size()) {
-         cout << "Could not use pipeline:" << endl;
-         cout << "  Invalid command index." << endl;
-         exit(-1);
-      }
-      
-      // linux system call to replace process with another process
-      execvp(my_command.getCommands()[command_index].getCommandName().c_str(), my_command.getCommands()[command_index].getArgsArray());
-      
-      // still here, must be an error
-      cout << "Could not use pipeline:" << endl;
-      
-      if (errno == 2)
-         cout << "  Command not found." << endl;
-      else
-         cout << "  " << strerror(errno) << "." << endl;
-      
-      exit(-1);
-}
-
-/******************************************************
-   Creates the appropriate number of pipes needed to
-   run the entired piped command.
-   
-   POST: Returns true if all of the pipes were successfully
-         created and their file descriptor array pointers
-         pushed onto the vector pipe_fds. Returns false
-         if an error was encountered.
-*/
-bool PipeManager::createPipes() {
-   
-   // we need 1 less pipe than the number of commands
-   int num_pipes_needed = my_command.getCommands().size() - 1;
-   
-   // create pipes and push arrays onto vector
-   for (int pipePtr = 0; pipePtr < num_pipes_needed; pipePtr++) {
-      int* pipefd = new int[2];
-      pipe_fds.push_back(pipefd);
-     
-      // linux system call to create a pipe
-      if (pipe(pipe_fds[pipe_fds.size() - 1]) == -1) {
-         cout << "Could not create pipe:" << endl;
-         cout << "  " << strerror(errno) << "." << endl;
-         return false;
-      }
-   }
-}
-
-/******************************************************
-   Tries to redirect the output of the currently
-   running process to the passed file descriptor.
-   
-   PRE:  Usually this method is run only after pipes
-         have been created.
-   
-   POST: Returns after all of the pipes that are stored
-         in pipe_fds have had their file descriptors closed.
-*/
-void PipeManager::closePipes() {
-   
-   // close read/write ends of all pipes in parent
-   for (int closePtr = 0; closePtr < pipe_fds.size(); closePtr++) {
-      
-      //linux system calls
-      close(pipe_fds[closePtr][0]);
-      close(pipe_fds[closePtr][1]);
-   }
-}
-
-/******************************************************
-   Deallocates all of the space that was allocated
-   to store pipe file descriptors, then clears
-   out the pointers to those arrays.
-   
-   PRE:  file_descriptor is a valid descriptor for
-         the write end of a pipe.
-   
-   POST: Returns after a successful redirect attempt.
-         Otherwise, an error message is printed and
-         the process terminates.
-*/
-void PipeManager::deletePipes() {
-   
-   // deallocate memory used in pipe file descriptor arrays
-   for (int dePtr = 0; dePtr < pipe_fds.size(); dePtr++) {
-      delete [] pipe_fds[dePtr];
-   }
-   
-   pipe_fds.clear();
-}
-
-/******************************************************
-   Tries to redirect, fork, and execute the last job in
-   the piped command.
-   
-   PRE:  The necessary pipes have already been created
-         and file descriptor array pointers are stored
-         in the vector pipe_fds.
-   
-   POST: Returns true in the parent if successful. Nothing
-         is returned on success in the child. Returns false
-         if an error was encountered.
-*/
-bool PipeManager::createLastChild() {
-   
-   // linux system call
-   int pid = fork();
-   
-   // error checking
-   if (pid == -1) {
-      cout << "Execution error: " << endl;
-      cout << "  Could not create process." << endl;
-      return false;
-   }
-      
-   // child code
-   if (pid == 0) {
-      
-      // figure out which pipe we're using
-      int my_pipe = pipe_fds.size() - 1;
-      
-      close(pipe_fds[my_pipe][1]);         // we don't want to write to pipe
-      redirectInput(pipe_fds[my_pipe][0]); // read end of the pipe
-      
-      // close all other pipes
-      for (int closePtr = 0; closePtr < pipe_fds.size(); closePtr++) {
-      
-         if (closePtr != my_pipe) {
-            //linux system calls
-            close(pipe_fds[closePtr][0]);
-            close(pipe_fds[closePtr][1]);
-         }
-      }
-      
-      // replace process code with last job
-      callExec(my_command.getCommands().size() - 1);
-   }
-   
-   // still here, must be in parent
-   pids.push_back(pid);
-   return true;
-}
-
-/******************************************************
-   Tries to redirect, fork, and execute the job passed
-   to the method. This method is designed to work with
-   two pipes, so it should not be used for the first
-   and last jobs in the pipeline.
-   
-   PRE:  The necessary pipes have already been created
-         and file descriptor array pointers are stored
-         in the vector pipe_fds.
-   
-   POST: Returns true in the parent if successful. Nothing
-         is returned on success in the child. Returns false
-         if an error was encountered.
-*/
-bool PipeManager::createMiddleChild(int command_index) {
-   
-   // linux system call
-   int pid = fork();
-   
-   // error checking
-   if (pid == -1) {
-      cout << "Execution error: " << endl;
-      cout << "  Could not create process." << endl;
-      return false;
-   }
-      
-   // child code
-   if (pid == 0) {
-   
-      // figure out which pipes we're using
-      int out_pipe = command_index;
-      int in_pipe = command_index - 1;
-      
-      redirectInput(pipe_fds[in_pipe][0]);   // read end of the pipe
-      close(pipe_fds[in_pipe][1]);
-      
-      redirectOutput(pipe_fds[out_pipe][1]); // write end of pipe
-      close(pipe_fds[out_pipe][0]);
-      
-      // close all other pipes
-      for (int closePtr = 0; closePtr < pipe_fds.size(); closePtr++) {
-      
-         if ((closePtr != in_pipe) && (closePtr != out_pipe)) {
-            //linux system calls
-            close(pipe_fds[closePtr][0]);
-            close(pipe_fds[closePtr][1]);
-         }
-      }
-      
-      // replace process code with the given job
-      callExec(command_index);
-   }
-   
-   // still here, must be in parent
-   pids.push_back(pid);
-   return true;
-}
-
-/******************************************************
-   Tries to redirect, fork, and execute the first job in
-   the piped command.
-   
-   PRE:  The necessary pipes have already been created
-         and file descriptor array pointers are stored
-         in the vector pipe_fds.
-   
-   POST: Returns true in the parent if successful. Nothing
-         is returned on success in the child. Returns false
-         if an error was encountered.
-*/
-bool PipeManager::createFirstChild() {
-   
-   // linux system call
-   int pid = fork();
-   
-   // error checking
-   if (pid == -1) {
-      cout << "Execution error: " << endl;
-      cout << "  Could not create process." << endl;
-      return false;
-   }
-      
-   // child code
-   if (pid == 0) {
-      
-      // first job, so we're using the first pipe
-      int my_pipe = 0;
-      
-      close(pipe_fds[my_pipe][0]);          // we don't want to read from pipe
-      redirectOutput(pipe_fds[my_pipe][1]); // write end of pipe
-      
-      // close all other pipes
-      for (int closePtr = 0; closePtr < pipe_fds.size(); closePtr++) {
-      
-         if (closePtr != my_pipe) {
-            //linux system calls
-            close(pipe_fds[closePtr][0]);
-            close(pipe_fds[closePtr][1]);
-         }
-      }
-      
-      // replace process code with first job
-      callExec(0);
-   }
-   
-   // still here, must be in parent
-   pids.push_back(pid);
-   return true;
-}
-
-/******************************************************
-   Tries to suspend the parent process until all of
-   the children that were created have finished executing.
-   After the process resumes, the pids of the children
-   are cleared out.
-   
-   PRE:  Usually, this method will not be called until
-         all of the children necessary for the pipe
-         have been forked.
-   
-   POST: Returns when all of the children have finished
-         executing. The vector pids has been cleared.
-*/
-void PipeManager::waitForChildren() {
-   
-   // go through pids vector in reverse order and wait for children
-   for (int pidCtr = (pids.size() - 1); pidCtr > -1; pidCtr--) {
-      
-      // linux system call
-      waitpid(pids[pidCtr], NULL, 0);
-   }
-   
-   pids.clear();
-}
+/* file: PipeManager.cpp
+   
+   Pipe Manager Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the code needed to execute a
+   series of piped commands. It handles creation and
+   redirection to pipes of an instance of the PipedCommand
+   class.
+   
+*/
+
+#include "PipeManager.h"
+#include "JobManager.h"
+#include <cstdio>
+#include <csignal>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+// how often the pipes are looked at in adaptive mode
+const int ADAPTIVE_CHECK_MS = 2;
+
+// the kernel's pipes, until "pipesize" says otherwise
+PipeSize PipeManager::pipe_size = { PIPE_SIZE_DEFAULT, 0 };
+
+/******************************************************
+   This is the basic constructor for the class.
+   
+   POST: The object is initialized and has no piped
+         command to run yet.
+*/
+PipeManager::PipeManager() : my_command(NULL), job_manager(NULL) {
+   exit_status = 1;
+   last_pid = -1;
+   last_index = -1;
+   null_fd = -1;
+}
+
+/******************************************************
+   This is the destructor for the class.
+   
+   POST: /dev/null is closed if it was opened.
+*/
+PipeManager::~PipeManager() {
+   
+   if (null_fd != -1)
+      close(null_fd);
+}
+
+/******************************************************
+   Tries to execute the job and then wait for it
+   to finish running. The jobs are started from the
+   last one back, and each pipe is made just before the
+   job that reads it, so the shell never has more than
+   two pipes open however long the pipeline is. Every
+   pipe is close-on-exec: a job only keeps the ends
+   that were copied onto its standard input and output.
+   
+   PRE:  new_command must be a parsed PipedCommand object.
+   
+   POST: Returns true if the job was successfully started
+         and finished running. Returns false if there
+         was an error.
+*/
+void PipeManager::execute(const PipedCommand &new_command) {
+   
+   my_command = &new_command;
+   exit_status = 1;
+   last_pid = -1;
+   
+   int num_commands = my_command->getNumCommands();
+   int num_branches = my_command->getNumBranches();
+   
+   // the pipeline's own size comes first
+   const PipeSize &size = (my_command->getPipeSize().mode == PIPE_SIZE_UNSET)
+                          ? pipe_size : my_command->getPipeSize();
+   
+   // the status of the last job that isn't a file is the pipeline's
+   last_index = num_commands - 1;
+   while ((last_index > 0) && my_command->getCommand(last_index).isFileStage())
+      last_index--;
+   
+   if (my_command->getParallelIndex() != -1) {
+      
+      runParallel(my_command->getParallelIndex(), size);
+      
+   } else if (num_branches == 0) {
+      
+      startStages(0, num_commands, -1, size, false);
+      
+   } else {
+      
+      // the branches are started first, from the last one back,
+      // each leaves the shell the pipe end it writes to
+      for (int branchCtr = num_branches - 1; branchCtr >= 0; branchCtr--) {
+         
+         int first_index = my_command->getBranchStart(branchCtr);
+         int end_index = (branchCtr + 1 < num_branches) ? my_command->getBranchStart(branchCtr + 1)
+                                                        : num_commands;
+         
+         if (my_command->getCommand(first_index).isFileStage())
+            addFileTarget(first_index);
+         else
+            addPipeTarget(startStages(first_index, end_index, -1, size, true));
+      }
+      
+      // then the stages before the fan-out, writing to the shell
+      int pipe_ends[2];
+      
+      if (pipe2(pipe_ends, O_CLOEXEC) == -1) {
+         cout << "Could not create pipe:" << endl;
+         cout << "  " << strerror(errno) << "." << endl;
+         closeTargets();
+      } else {
+         
+         // the shell reads this one itself, so it's never watched
+         if (size.mode == PIPE_SIZE_FIXED)
+            sizePipe(pipe_ends, size, -1);
+         
+         startStages(0, my_command->getBranchStart(0), pipe_ends[1], size, false);
+         
+         fanOut(pipe_ends[0]);
+         close(pipe_ends[0]);
+      }
+   }
+   
+   if (watched_pipes.empty())
+      waitForChildren();
+   else
+      waitAndGrowPipes();
+}
+
+/******************************************************
+   Starts the jobs from first_index up to end_index,
+   from the last one back, each one writing into a pipe
+   to the one after it.
+   
+   PRE:  out_fd is the pipe end the last job writes to,
+         or -1 for the shell's standard output.
+   
+   POST: If fed_by_shell, the first job reads from a new
+         pipe too and the write end of it is returned.
+         Otherwise -1 is returned. out_fd is closed.
+*/
+int PipeManager::startStages(int first_index, int end_index, int out_fd, const PipeSize &size, bool fed_by_shell) {
+   
+   for (int cmdCtr = end_index - 1; cmdCtr >= first_index; cmdCtr--) {
+      
+      int in_fd = -1;
+      int next_out_fd = -1;
+      
+      // every job but the first reads from a pipe
+      if ((cmdCtr > first_index) || fed_by_shell) {
+         
+         int pipe_ends[2];
+         
+         // linux system call to create a pipe
+         if (pipe2(pipe_ends, O_CLOEXEC) == -1) {
+            cout << "Could not create pipe:" << endl;
+            cout << "  " << strerror(errno) << "." << endl;
+            
+            // the jobs already started see the end of their input
+            if (out_fd != -1)
+               close(out_fd);
+            return -1;
+         }
+         
+         in_fd = pipe_ends[0];
+         next_out_fd = pipe_ends[1];
+      }
+      
+      int pid = createChild(cmdCtr, in_fd, out_fd);
+      
+      if ((in_fd != -1) && (pid != -1)) {
+         int pipe_ends[2] = { in_fd, next_out_fd };
+         sizePipe(pipe_ends, size, pid);
+      }
+      
+      // the status of the last job is the pipeline's
+      if (cmdCtr == last_index) {
+         last_pid = pid;
+         
+         if (pid == -1)
+            exit_status = spawner.getFailureStatus();
+      }
+      
+      // the job has its own copies of these now
+      if (in_fd != -1)
+         close(in_fd);
+      
+      if (out_fd != -1)
+         close(out_fd);
+      
+      out_fd = next_out_fd;
+   }
+   
+   return out_fd;
+}
+
+/******************************************************
+   Starts the stages before and after the PARALLEL=
+   stage and runs it in between. A stage at the start
+   reads the shell's own standard input, and one at the
+   end writes the shell's standard output.
+   
+   The shell is busy moving the stage's data the whole
+   time, so it can't look after adaptive pipes, and
+   they are left the kernel's size.
+   
+   POST: The stage has finished, the jobs around it are
+         still to be waited for.
+*/
+void PipeManager::runParallel(int parallel_index, const PipeSize &size) {
+   
+   int num_commands = my_command->getNumCommands();
+   
+   PipeSize stage_size = size;
+   
+   if (stage_size.mode == PIPE_SIZE_ADAPTIVE)
+      stage_size.mode = PIPE_SIZE_DEFAULT;
+   
+   int out_fd = 1;
+   int in_fd = 0;
+   
+   if (parallel_index < num_commands - 1)
+      out_fd = startStages(parallel_index + 1, num_commands, -1, stage_size, true);
+   
+   if ((parallel_index > 0) && (out_fd != -1)) {
+      
+      int pipe_ends[2];
+      
+      if (pipe2(pipe_ends, O_CLOEXEC) == -1) {
+         cout << "Could not create pipe:" << endl;
+         cout << "  " << strerror(errno) << "." << endl;
+         in_fd = -1;
+      } else {
+         sizePipe(pipe_ends, stage_size, -1);
+         startStages(0, parallel_index, pipe_ends[1], stage_size, false);
+         in_fd = pipe_ends[0];
+      }
+   }
+   
+   if ((in_fd != -1) && (out_fd != -1)) {
+      
+      // the copies' output goes around cout
+      cout.flush();
+      
+      int status = parallel_stage.run(my_command->getCommand(parallel_index),
+                                      my_command->getParallelSpec(), in_fd, out_fd);
+      
+      if (parallel_index == last_index)
+         exit_status = status;
+   }
+   
+   // the jobs on either side see the end of the stage
+   if (in_fd > 0)
+      close(in_fd);
+   
+   if (out_fd > 1)
+      close(out_fd);
+}
+
+/******************************************************
+   Tries to start one job of the pipeline with its
+   standard input and output on the given pipe ends.
+   
+   PRE:  in_fd and out_fd are pipe ends, or -1 to leave
+         standard input or output alone.
+   
+   POST: Returns the process id of the job, or -1 with
+         the error printed if it couldn't be started.
+*/
+int PipeManager::createChild(int command_index, int in_fd, int out_fd) {
+   
+   spawner.reset();
+   
+   if (in_fd != -1)
+      spawner.addDup2(in_fd, 0);    // read end of the pipe
+   
+   if (out_fd != -1)
+      spawner.addDup2(out_fd, 1);   // write end of the pipe
+   
+   return spawnChild(command_index);
+}
+
+/******************************************************
+   Starts one job of the pipeline with the file actions
+   that have been added to spawner. The argument array
+   was laid out by the parser, no copying needed.
+   
+   PRE:  command_index refers to a job in my_command.
+   
+   POST: Returns the process id of the job, which has
+         been added to pids. Returns -1 and prints the
+         error if it couldn't be started.
+*/
+int PipeManager::spawnChild(int command_index) {
+   
+   int pid = spawner.spawn(my_command->getCommand(command_index).getArgsArray());
+   
+   if (pid == -1) {
+      spawner.printFailure();
+      return -1;
+   }
+   
+   pids.push_back(pid);
+   return pid;
+}
+
+/******************************************************
+   Tries to suspend the parent process until all of
+   the children that were created have finished executing.
+   After the process resumes, the pids of the children
+   are cleared out.
+   
+   PRE:  Usually, this method will not be called until
+         all of the children necessary for the pipe
+         have been forked.
+   
+   POST: Returns when all of the children have finished
+         executing. The vector pids has been cleared and
+         exit_status holds the status of the last command.
+*/
+void PipeManager::waitForChildren() {
+   
+   // go through pids vector in reverse order and wait for children
+   for (int pidCtr = (pids.size() - 1); pidCtr > -1; pidCtr--) {
+      
+      // already reaped while the pipes were watched
+      if (pids[pidCtr] == -1)
+         continue;
+      
+      // background jobs that finish meanwhile are reaped too
+      int status;
+      if (job_manager != NULL) {
+         if (!job_manager->waitForChild(pids[pidCtr], status))
+            continue;
+      } else if (waitpid(pids[pidCtr], &status, 0) == -1) {
+         continue;
+      }
+      
+      keepStatus(pids[pidCtr], status);
+   }
+   
+   pids.clear();
+}
+
+/******************************************************
+   Keeps the status of a child that finished if it was
+   the last one of the pipeline.
+   
+   POST: exit_status is set if pid is last_pid.
+*/
+void PipeManager::keepStatus(pid_t pid, int status) {
+   
+   // the status of the last child is the pipeline's
+   if (pid != last_pid)
+      return;
+   
+   if (WIFEXITED(status))
+      exit_status = WEXITSTATUS(status);
+   else if (WIFSIGNALED(status))
+      exit_status = 128 + WTERMSIG(status);
+}
+
+/******************************************************
+   Sizes a pipe that was just made. A fixed size is set
+   right away. In adaptive mode the shell keeps a copy
+   of the read end to look at how full the pipe is.
+   
+   PRE:  reader_pid is the job reading from the pipe.
+   
+   POST: The pipe has its size, or is in watched_pipes.
+*/
+void PipeManager::sizePipe(int pipe_ends[2], const PipeSize &size, pid_t reader_pid) {
+   
+   if (size.mode == PIPE_SIZE_FIXED) {
+      
+      // it's still a pipe if this fails, just not as big
+      fcntl(pipe_ends[1], F_SETPIPE_SZ, min(size.bytes, getMaxPipeSize()));
+      
+   } else if (size.mode == PIPE_SIZE_ADAPTIVE) {
+      
+      WatchedPipe watched;
+      watched.fd = fcntl(pipe_ends[0], F_DUPFD_CLOEXEC, 3);
+      watched.reader_pid = reader_pid;
+      
+      if (watched.fd != -1)
+         watched_pipes.push_back(watched);
+   }
+}
+
+/******************************************************
+   Waits for the children like waitForChildren(), but
+   looks at the watched pipes every few milliseconds
+   while they run. A pipe stops being watched once its
+   reader is gone, so a writer still gets SIGPIPE, or
+   once it is as big as it gets. When none are left the
+   rest of the children are waited for without waking
+   up.
+   
+   POST: Every child has finished, pids and
+         watched_pipes are empty.
+*/
+void PipeManager::waitAndGrowPipes() {
+   
+   while (isWatchingPipes() && (reapFinished() > 0)) {
+      growFullPipes();
+      pollWithJobs(wait_polls, 0, ADAPTIVE_CHECK_MS);
+   }
+   
+   waitForChildren();
+   watched_pipes.clear();
+}
+
+/******************************************************
+   Waits for any children that have already finished,
+   without blocking, and stops watching the pipes they
+   read from.
+   
+   POST: The finished children are -1 in pids. Returns
+         how many are still running.
+*/
+int PipeManager::reapFinished() {
+   
+   int num_left = 0;
+   
+   for (int pidCtr = 0; pidCtr < pids.size(); pidCtr++) {
+      
+      if (pids[pidCtr] == -1)
+         continue;
+      
+      int status;
+      int finished_pid = waitpid(pids[pidCtr], &status, WNOHANG);
+      
+      if (finished_pid == 0) {
+         num_left++;
+         continue;
+      }
+      
+      if (finished_pid == pids[pidCtr])
+         keepStatus(finished_pid, status);
+      
+      // the pipe it read from has nobody left to fill up for
+      for (int watchCtr = 0; watchCtr < watched_pipes.size(); watchCtr++) {
+         
+         if (watched_pipes[watchCtr].reader_pid == pids[pidCtr])
+            stopWatching(watched_pipes[watchCtr]);
+      }
+      
+      pids[pidCtr] = -1;
+   }
+   
+   return num_left;
+}
+
+/******************************************************
+   Doubles the size of every watched pipe that is more
+   than half full. Small writes don't fill whole pages,
+   so a pipe can be full well before it holds its size
+   in bytes.
+   
+   POST: The full pipes are bigger, up to the largest
+         size allowed.
+*/
+void PipeManager::growFullPipes() {
+   
+   int max_size = getMaxPipeSize();
+   
+   for (int watchCtr = 0; watchCtr < watched_pipes.size(); watchCtr++) {
+      
+      WatchedPipe &watched = watched_pipes[watchCtr];
+      
+      if (watched.fd == -1)
+         continue;
+      
+      int num_waiting = 0;
+      int pipe_capacity = fcntl(watched.fd, F_GETPIPE_SZ);
+      
+      if ((pipe_capacity <= 0) || (ioctl(watched.fd, FIONREAD, &num_waiting) == -1))
+         continue;
+      
+      if (num_waiting * 2 < pipe_capacity)
+         continue;
+      
+      // over the user's limit on pipe memory, or as big as it gets,
+      // so there is nothing more to watch it for
+      if ((pipe_capacity >= max_size) || (fcntl(watched.fd, F_SETPIPE_SZ, min(2 * pipe_capacity, max_size)) == -1))
+         stopWatching(watched);
+   }
+}
+
+/******************************************************
+   Lets go of the shell's copy of a watched pipe, so
+   its writer gets SIGPIPE once the reader is gone.
+   
+   POST: The pipe's fd is closed and -1.
+*/
+void PipeManager::stopWatching(WatchedPipe &watched) {
+   
+   if (watched.fd == -1)
+      return;
+   
+   close(watched.fd);
+   watched.fd = -1;
+}
+
+/******************************************************
+   Returns whether any pipe is still being watched.
+*/
+bool PipeManager::isWatchingPipes() const {
+   
+   for (int watchCtr = 0; watchCtr < watched_pipes.size(); watchCtr++) {
+      if (watched_pipes[watchCtr].fd != -1)
+         return true;
+   }
+   
+   return false;
+}
+
+/******************************************************
+   Returns the largest size an unprivileged pipe can be
+   given, read once from /proc.
+*/
+int PipeManager::getMaxPipeSize() {
+   
+   static int max_size = 0;
+   
+   if (max_size == 0) {
+      
+      // the kernel's default limit, if /proc can't be read
+      max_size = 1024 * 1024;
+      
+      FILE *limit_file = fopen("/proc/sys/fs/pipe-max-size", "r");
+      
+      if (limit_file != NULL) {
+         if ((fscanf(limit_file, "%d", &max_size) != 1) || (max_size <= 0))
+            max_size = 1024 * 1024;
+         fclose(limit_file);
+      }
+   }
+   
+   return max_size;
+}
+
+/******************************************************
+   Adds the write end of the pipe to a branch's first
+   job to the fan-out. The shell is the only one with
+   this end, so it is made non-blocking.
+   
+   PRE:  write_fd is the end startStages() returned.
+   
+   POST: Nothing is added if write_fd is -1.
+*/
+void PipeManager::addPipeTarget(int write_fd) {
+   
+   if (write_fd == -1)
+      return;
+   
+   fcntl(write_fd, F_SETFL, O_NONBLOCK);
+   
+   FanOutTarget target = { write_fd, -1, -1, 0 };
+   targets.push_back(target);
+}
+
+/******************************************************
+   Opens the file of a "> file" branch and adds it to
+   the fan-out. tee() only goes from pipe to pipe, so
+   the file gets a pipe of its own that the shell
+   empties into it with splice(). It is made as big as
+   a pipe can be, so whatever is in the pipe being fanned
+   out always fits in it.
+   
+   PRE:  command_index is a file stage of my_command.
+   
+   POST: The file is added, or the error is printed.
+*/
+void PipeManager::addFileTarget(int command_index) {
+   
+   const char *file_path = my_command->getCommand(command_index).getOutputFilePath();
+   
+   int file_fd = open(file_path, O_CREAT|O_WRONLY|O_TRUNC|O_CLOEXEC, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+   
+   if (file_fd == -1) {
+      cout << "Output file error:" << endl;
+      cout << "  " << strerror(errno) << "." << endl;
+      return;
+   }
+   
+   int pipe_ends[2];
+   
+   if (pipe2(pipe_ends, O_CLOEXEC | O_NONBLOCK) == -1) {
+      cout << "Could not create pipe:" << endl;
+      cout << "  " << strerror(errno) << "." << endl;
+      close(file_fd);
+      return;
+   }
+   
+   fcntl(pipe_ends[1], F_SETPIPE_SZ, getMaxPipeSize());
+   
+   FanOutTarget target = { pipe_ends[1], pipe_ends[0], file_fd, 0 };
+   targets.push_back(target);
+}
+
+/******************************************************
+   Copies everything written into in_fd to every branch
+   of the fan-out until the stages before it are done.
+   The data is never read into the shell: tee() gives
+   each branch's pipe a reference to the same pages and
+   splice() then throws them out of in_fd.
+   
+   Each branch has its own pipe, so a slow one only
+   holds the others back once its pipe is full, and the
+   producer only once every branch is that far behind
+   or in_fd fills up too. A branch whose jobs have all
+   quit is dropped, and the rest carry on without it.
+   
+   PRE:  in_fd is the read end of the pipe from the last
+         stage before the fan-out.
+   
+   POST: Every target has been closed, so the branches
+         see the end of their input.
+*/
+void PipeManager::fanOut(int in_fd) {
+   
+   // a branch that quits shouldn't take the shell with it
+   struct sigaction ignore_pipe, old_action;
+   memset(&ignore_pipe, 0, sizeof(ignore_pipe));
+   ignore_pipe.sa_handler = SIG_IGN;
+   sigemptyset(&ignore_pipe.sa_mask);
+   sigaction(SIGPIPE, &ignore_pipe, &old_action);
+   
+   while (!targets.empty()) {
+      
+      struct pollfd input = { in_fd, POLLIN, 0 };
+      wait_polls.assign(1, input);
+      
+      int num_ready = pollWithJobs(wait_polls, 1, getPollTimeout());
+      
+      checkWatchedPipes();
+      
+      if (num_ready <= 0)
+         continue;
+      
+      int num_waiting = 0;
+      
+      if (ioctl(in_fd, FIONREAD, &num_waiting) == -1)
+         break;
+      
+      // the stages before the fan-out are done
+      if (num_waiting == 0) {
+         
+         if (wait_polls[0].revents & (POLLHUP | POLLERR))
+            break;
+         
+         continue;
+      }
+      
+      if (!waitForRoom())
+         break;
+      
+      sendChunk(in_fd, getChunkSize(num_waiting));
+   }
+   
+   closeTargets();
+   
+   sigaction(SIGPIPE, &old_action, NULL);
+}
+
+/******************************************************
+   Waits until the pipe of every target has room for
+   more. Targets whose readers are gone are dropped.
+   
+   POST: Returns false if there are no targets left.
+*/
+bool PipeManager::waitForRoom() {
+   
+   while (!targets.empty()) {
+      
+      target_polls.resize(targets.size());
+      
+      for (int targetCtr = 0; targetCtr < targets.size(); targetCtr++) {
+         target_polls[targetCtr].fd = targets[targetCtr].pipe_fd;
+         target_polls[targetCtr].events = POLLOUT;
+         target_polls[targetCtr].revents = 0;
+      }
+      
+      poll(target_polls.data(), target_polls.size(), 0);
+      
+      // POLLERR means nobody is reading the pipe any more
+      int num_full = 0;
+      
+      for (int targetCtr = targets.size() - 1; targetCtr >= 0; targetCtr--) {
+         
+         if (target_polls[targetCtr].revents & POLLERR)
+            dropTarget(targetCtr);
+         else if (!(target_polls[targetCtr].revents & POLLOUT))
+            target_polls[num_full++] = target_polls[targetCtr];
+      }
+      
+      if (num_full == 0)
+         return !targets.empty();
+      
+      // only the full ones need waiting for
+      pollWithJobs(target_polls, num_full, getPollTimeout());
+      
+      checkWatchedPipes();
+   }
+   
+   return false;
+}
+
+/******************************************************
+   Works out how much of in_fd to send this time: no
+   more than the branch with the least room can take,
+   so tee() doesn't often have to stop partway through.
+   
+   PRE:  Every target has room, so the result is at
+         least 1.
+*/
+int PipeManager::getChunkSize(int num_waiting) {
+   
+   int chunk = num_waiting;
+   
+   for (int targetCtr = 0; targetCtr < targets.size(); targetCtr++) {
+      
+      // the pipes of files are always empty by now
+      if (targets[targetCtr].file_fd != -1)
+         continue;
+      
+      int num_queued = 0;
+      int pipe_capacity = fcntl(targets[targetCtr].pipe_fd, F_GETPIPE_SZ);
+      
+      if ((pipe_capacity > 0) && (ioctl(targets[targetCtr].pipe_fd, FIONREAD, &num_queued) != -1))
+         chunk = min(chunk, pipe_capacity - num_queued);
+   }
+   
+   return max(chunk, 1);
+}
+
+/******************************************************
+   Sends the first chunk bytes of in_fd to every target
+   and takes them out of in_fd.
+   
+   tee() always starts from the front of in_fd, so a
+   target it could only give part of the chunk to can't
+   be sent the rest the same way. When that happens the
+   chunk is read into the shell instead of thrown out,
+   and the missing part is written to those targets.
+   
+   PRE:  in_fd has at least chunk bytes in it.
+   
+   POST: Every target still open has the whole chunk.
+*/
+void PipeManager::sendChunk(int in_fd, int chunk) {
+   
+   bool partial = false;
+   
+   for (int targetCtr = targets.size() - 1; targetCtr >= 0; targetCtr--) {
+      
+      FanOutTarget &target = targets[targetCtr];
+      
+      int num_sent = tee(in_fd, target.pipe_fd, chunk, SPLICE_F_NONBLOCK);
+      
+      if ((num_sent == -1) && (errno == EAGAIN))
+         num_sent = 0;
+      
+      // EPIPE, the branch is gone
+      if (num_sent == -1) {
+         dropTarget(targetCtr);
+         continue;
+      }
+      
+      target.sent = num_sent;
+      
+      if (num_sent < chunk)
+         partial = true;
+      
+      if ((target.file_fd != -1) && !emptyIntoFile(target)) {
+         dropTarget(targetCtr);
+         continue;
+      }
+   }
+   
+   if (!partial) {
+      discardInput(in_fd, chunk);
+      return;
+   }
+   
+   copy_buffer.resize(max((int) copy_buffer.size(), chunk));
+   
+   if (!readAll(in_fd, copy_buffer.data(), chunk)) {
+      closeTargets();
+      return;
+   }
+   
+   for (int targetCtr = targets.size() - 1; targetCtr >= 0; targetCtr--) {
+      
+      FanOutTarget &target = targets[targetCtr];
+      
+      if (target.sent == chunk)
+         continue;
+      
+      int out_fd = (target.file_fd != -1) ? target.file_fd : target.pipe_fd;
+      
+      if (!writeAll(out_fd, copy_buffer.data() + target.sent, chunk - target.sent))
+         dropTarget(targetCtr);
+   }
+}
+
+/******************************************************
+   Moves everything in a file target's pipe into the
+   file with splice().
+   
+   POST: Returns false if the file couldn't be written.
+*/
+bool PipeManager::emptyIntoFile(FanOutTarget &target) {
+   
+   int num_left = target.sent;
+   
+   while (num_left > 0) {
+      
+      int num_moved = splice(target.read_fd, NULL, target.file_fd, NULL, num_left, SPLICE_F_MOVE);
+      
+      if ((num_moved == -1) && (errno == EINTR))
+         continue;
+      
+      if (num_moved <= 0) {
+         cout << "Output file error:" << endl;
+         cout << "  " << strerror((num_moved == 0) ? EIO : errno) << "." << endl;
+         return false;
+      }
+      
+      num_left -= num_moved;
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Takes chunk bytes out of in_fd that every target
+   already has, by splicing them into /dev/null.
+   
+   PRE:  in_fd has at least chunk bytes in it.
+*/
+void PipeManager::discardInput(int in_fd, int chunk) {
+   
+   if (null_fd == -1)
+      null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+   
+   while (chunk > 0) {
+      
+      int num_moved = -1;
+      
+      if (null_fd != -1)
+         num_moved = splice(in_fd, NULL, null_fd, NULL, chunk, 0);
+      
+      // no /dev/null, it has to be read
+      if (num_moved <= 0) {
+         copy_buffer.resize(max((int) copy_buffer.size(), chunk));
+         readAll(in_fd, copy_buffer.data(), chunk);
+         return;
+      }
+      
+      chunk -= num_moved;
+   }
+}
+
+/******************************************************
+   Reads exactly length bytes.
+   
+   POST: Returns false if they couldn't be read.
+*/
+bool PipeManager::readAll(int fd, char *data, int length) {
+   
+   while (length > 0) {
+      
+      int num_read = read(fd, data, length);
+      
+      if ((num_read == -1) && (errno == EINTR))
+         continue;
+      
+      if (num_read <= 0)
+         return false;
+      
+      data += num_read;
+      length -= num_read;
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Writes all of data to a target, waiting for room in
+   its pipe if it is full.
+   
+   POST: Returns false if its reader is gone or it
+         couldn't be written.
+*/
+bool PipeManager::writeAll(int fd, const char *data, int length) {
+   
+   while (length > 0) {
+      
+      int num_written = write(fd, data, length);
+      
+      if (num_written > 0) {
+         data += num_written;
+         length -= num_written;
+         continue;
+      }
+      
+      if ((num_written == -1) && (errno == EINTR))
+         continue;
+      
+      if ((num_written == 0) || (errno != EAGAIN))
+         return false;
+      
+      struct pollfd output = { fd, POLLOUT, 0 };
+      wait_polls.assign(1, output);
+      
+      pollWithJobs(wait_polls, 1, getPollTimeout());
+      
+      checkWatchedPipes();
+      
+      if (wait_polls[0].revents & POLLERR)
+         return false;
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Closes one target of the fan-out and takes it off
+   the list.
+   
+   POST: The branch sees the end of its input.
+*/
+void PipeManager::dropTarget(int target_index) {
+   
+   FanOutTarget &target = targets[target_index];
+   
+   close(target.pipe_fd);
+   
+   if (target.read_fd != -1)
+      close(target.read_fd);
+   
+   if (target.file_fd != -1)
+      close(target.file_fd);
+   
+   targets.erase(targets.begin() + target_index);
+}
+
+/******************************************************
+   Closes every target of the fan-out.
+   
+   POST: targets is empty.
+*/
+void PipeManager::closeTargets() {
+   
+   while (!targets.empty())
+      dropTarget(targets.size() - 1);
+}
+
+/******************************************************
+   Returns how long the fan-out can wait in poll(). In
+   adaptive mode it has to keep waking up to look after
+   the watched pipes, until none are left.
+*/
+int PipeManager::getPollTimeout() const {
+   return isWatchingPipes() ? ADAPTIVE_CHECK_MS : -1;
+}
+
+/******************************************************
+   Does what waitAndGrowPipes() does on each tick, for
+   the fan-out's loops. Once a branch's reader quits
+   its pipe has to be let go, or the shell would never
+   see that nobody is reading it.
+*/
+void PipeManager::checkWatchedPipes() {
+   
+   if (!isWatchingPipes())
+      return;
+   
+   reapFinished();
+   growFullPipes();
+}
+
+/******************************************************
+   Polls the first num_fds of polls, and the JobManager's
+   fd along with them, so background jobs are reaped
+   while the pipeline runs.
+   
+   POST: The revents of the first num_fds are set.
+         Returns how many of them are ready, or -1 if
+         poll() failed.
+*/
+int PipeManager::pollWithJobs(vector<struct pollfd> &polls, int num_fds, int timeout) {
+   
+   int job_fd = (job_manager != NULL) ? job_manager->getWaitFd() : -1;
+   int num_polled = num_fds;
+   
+   if (job_fd != -1) {
+      
+      if (polls.size() <= num_fds)
+         polls.resize(num_fds + 1);
+      
+      struct pollfd jobs = { job_fd, POLLIN, 0 };
+      polls[num_fds] = jobs;
+      num_polled++;
+   }
+   
+   int num_ready = poll(polls.data(), num_polled, timeout);
+   
+   if ((job_fd != -1) && (num_ready > 0) && polls[num_fds].revents) {
+      job_manager->reapReady();
+      num_ready--;
+   }
+   
+   return num_ready;
+}
+
+/******************************************************
+   Sets the pipe size for pipelines that don't have a
+   PIPESIZE= word.
+   
+   PRE:  new_size isn't PIPE_SIZE_UNSET.
+*/
+void PipeManager::setPipeSize(const PipeSize &new_size) {
+   pipe_size = new_size;
+}
+
+/******************************************************
+   Returns the pipe size for pipelines that don't have
+   a PIPESIZE= word.
+*/
+const PipeSize & PipeManager::getPipeSize() {
+   return pipe_size;
+}
+
+/******************************************************
+   Returns the exit status of the last command of the
+   pipeline that was executed.
+   
+   POST: Returns the status from exit(), 128 plus the
+         signal number if it was killed, or 1 if the
+         pipeline couldn't be started.
+*/
+int PipeManager::getExitStatus() const {
+   return exit_status;
+}
+
+/******************************************************
+   Sets the JobManager that waits for the children,
+   the PARALLEL= stage's copies too, or NULL to wait
+   for them with waitpid() alone.
+   
+   PRE:  new_job_manager outlives this object.
+*/
+void PipeManager::setJobManager(JobManager *new_job_manager) {
+   job_manager = new_job_manager;
+   parallel_stage.setJobManager(new_job_manager);
+}
@@ -1,96 +1,226 @@
-/* file: PipeManager.h
-   
-   Pipe Manager Class Header File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the code needed to execute a
-   series of piped commands. It handles creation and
-   redirection to pipes of an instance of the PipedCommand
-   class.
-   
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on constructors:                   !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   PipeManager(PipedCommand new_command)
-   --------------------------------------------------
-      This is the basic constructor for the class. It
-      must be passed a valid PipedCommand object.
-      
-      PRE:  new_command must be a parsed PipedCommand
-            object.
-      
-      POST: The object has been initialized. This object's
-            piped command is set to be the same as
-            new_command.
-      
-      
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on public methods:                 !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   void execute()
-   --------------------------------------------------
-      Tries to execute the job and then wait for it
-      to finish running.
-      
-      POST: Returns true if the job was successfully
-            started and finished. Returns false if
-            there was an error.
-   
-*/
-
-#ifndef PIPE_HEADER
-#define PIPE_HEADER
-
-#include <string>
-#include <vector>
-#include <iostream>
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <fcntl.h>
-#include <errno.h>
-#include "PipedCommand.h"
-
-using namespace std;
-
-class PipeManager {
-   
-    public:
-    
-         // constructor
-         PipeManager(PipedCommand new_command);
-         
-         void execute();
-    
-    private:
-    
-         // methods dealing with pipes
-         bool createPipes();
-         void closePipes();
-         void deletePipes();
-         
-         // methods dealing with children
-         bool createLastChild();
-         bool createMiddleChild(int command_index);
-         bool createFirstChild();
-         void waitForChildren();
-         
-         // redirection and execution commands
-         void redirectOutput(int file_descriptor);
-         void redirectInput(int file_descriptor);
-         void callExec(int command_index);
-         
-         //------------------------------------------------------------
-         // Data
-         //------------------------------------------------------------
-         PipedCommand my_command;
-         vector<int*> pipe_fds;
-         vector<int> pids;
-};
-
-#endif
+/* file: PipeManager.h
+   
+   Pipe Manager Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the code needed to execute a
+   series of piped commands. It handles creation and
+   redirection to pipes of an instance of the PipedCommand
+   class.
+   
+   A pipeline with "|+" branches has its fan-out run
+   by the shell: everything the stages before the first
+   "|+" write comes to the shell, which copies it to each
+   branch with tee() and splice(), so the data is never
+   read into user space. Each branch has its own pipe,
+   and a branch that quits early is just dropped.
+   
+   A PARALLEL= stage is run by the shell too, with the
+   ParallelStage class, between a pipe from the stages
+   before it and a pipe to the ones after it.
+   
+   The pipes are sized by the pipeline's PIPESIZE= word,
+   or the shell's "pipesize" setting if it doesn't have
+   one. Fixed sizes are set with F_SETPIPE_SZ when each
+   pipe is made. In adaptive mode the shell keeps an eye
+   on each pipe while it waits, and doubles any pipe
+   that is over half full. No pipe is made bigger than
+   /proc/sys/fs/pipe-max-size, and once a pipe is that
+   big it isn't watched any more. With nothing left to
+   watch, the shell stops waking up to look.
+   
+   While a pipeline runs, the shell's poll() calls and
+   waits include the JobManager's, so background jobs
+   that finish are still reaped right away.
+   
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   PipeManager()
+   --------------------------------------------------
+      This is the basic constructor for the class. One
+      object can run any number of piped commands, one
+      after another.
+      
+      POST: The object has been initialized.
+      
+      
+   ~PipeManager()
+   --------------------------------------------------
+      This is the destructor for the class.
+      
+      POST: The fds the object keeps are closed.
+      
+      
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   void execute(const PipedCommand &new_command)
+   --------------------------------------------------
+      Tries to execute the job and then wait for it
+      to finish running. new_command is not copied.
+      
+      PRE:  new_command must be a parsed PipedCommand
+            object.
+      
+      POST: Returns true if the job was successfully
+            started and finished. Returns false if
+            there was an error.
+   
+   
+   int getExitStatus() const
+   --------------------------------------------------
+      Returns the exit status of the last command of the
+      pipeline that was executed, the same way ForeJob
+      does.
+      
+      POST: Returns the exit status, or 1 if the pipeline
+            couldn't be started.
+   
+   
+   void setJobManager(JobManager *new_job_manager)
+   --------------------------------------------------
+      Sets the JobManager that waits for the children
+      of a pipeline, so background jobs are reaped
+      while it runs, or NULL to wait for them alone.
+      
+      PRE:  new_job_manager outlives this object.
+   
+   
+   static void setPipeSize(const PipeSize &new_size)
+   static const PipeSize & getPipeSize()
+   --------------------------------------------------
+      Set and get the pipe size used by pipelines that
+      don't have a PIPESIZE= word.
+      
+      PRE:  new_size isn't PIPE_SIZE_UNSET.
+   
+*/
+
+#ifndef PIPE_HEADER
+#define PIPE_HEADER
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include "PipedCommand.h"
+#include "Spawner.h"
+#include "ParallelStage.h"
+
+using namespace std;
+
+class JobManager;
+
+class PipeManager {
+   
+    public:
+    
+         // constructor
+         PipeManager();
+         ~PipeManager();
+         
+         void execute(const PipedCommand &new_command);
+         int getExitStatus() const;
+         void setJobManager(JobManager *new_job_manager);
+         
+         // the shell's pipe size
+         static void setPipeSize(const PipeSize &new_size);
+         static const PipeSize & getPipeSize();
+    
+    private:
+    
+         // methods dealing with children
+         int startStages(int first_index, int end_index, int out_fd, const PipeSize &size, bool fed_by_shell);
+         void runParallel(int parallel_index, const PipeSize &size);
+         int createChild(int command_index, int in_fd, int out_fd);
+         int spawnChild(int command_index);
+         void waitForChildren();
+         void keepStatus(pid_t pid, int status);
+         
+         // a pipe being watched in adaptive mode
+         struct WatchedPipe {
+            int fd;             // the shell's own copy of the read end, -1 once done
+            pid_t reader_pid;   // stops being watched when this exits
+         };
+         
+         // methods dealing with pipe sizes
+         void sizePipe(int pipe_ends[2], const PipeSize &size, pid_t reader_pid);
+         void waitAndGrowPipes();
+         int reapFinished();
+         void growFullPipes();
+         void stopWatching(WatchedPipe &watched);
+         bool isWatchingPipes() const;
+         static int getMaxPipeSize();
+         
+         // a branch of a fan-out, a pipe or a file
+         struct FanOutTarget {
+            int pipe_fd;        // what the shell tee()s into
+            int read_fd;        // for a file, the other end of pipe_fd
+            int file_fd;        // the file, or -1 for a branch's pipe
+            int sent;           // how much of the current chunk got there
+         };
+         
+         // methods dealing with the fan-out
+         void addPipeTarget(int write_fd);
+         void addFileTarget(int command_index);
+         void fanOut(int in_fd);
+         bool waitForRoom();
+         int getChunkSize(int num_waiting);
+         void sendChunk(int in_fd, int chunk);
+         bool emptyIntoFile(FanOutTarget &target);
+         void discardInput(int in_fd, int chunk);
+         bool readAll(int fd, char *data, int length);
+         bool writeAll(int fd, const char *data, int length);
+         void dropTarget(int target_index);
+         void closeTargets();
+         int getPollTimeout() const;
+         void checkWatchedPipes();
+         int pollWithJobs(vector<struct pollfd> &polls, int num_fds, int timeout);
+         
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+         
+         const PipedCommand *my_command;
+         JobManager *job_manager;
+         vector<int> pids;
+         vector<WatchedPipe> watched_pipes;
+         int last_pid;
+         int last_index;
+         int exit_status;
+         
+         // the branches of the fan-out, and room to poll them
+         vector<FanOutTarget> targets;
+         vector<struct pollfd> target_polls;
+         
+         // room to poll one fd and the JobManager's
+         vector<struct pollfd> wait_polls;
+         
+         // for the odd chunk that can't go by tee()
+         vector<char> copy_buffer;
+         
+         // where chunks every branch has go
+         int null_fd;
+         
+         // runs the PARALLEL= stage
+         ParallelStage parallel_stage;
+         
+         // starts the children, keeps its file actions' space
+         Spawner spawner;
+         
+         // for pipelines without a PIPESIZE= word
+         static PipeSize pipe_size;
+};
+
+#endif
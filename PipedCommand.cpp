@@ -1,183 +1,569 @@
-/* file: PipedCommand.cpp
-   
-   Piped Command Class Implementation File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the data and functions
-   needed for storing and parsing piped commands.
-   
-*/
-
-#include "PipedCommand.h"
-
-using namespace std;
-
-/******************************************************
-   This is the basic constructor for the class.
-   
-   POST: The member variable command_text is initialized
-         to "none".
-*/
-PipedCommand::PipedCommand() {
-   command_text = "none";
-}
-
-/******************************************************
-   Sets the text of the entire command to whatever
-   string the user specifies.
-   
-   PRE:  new_cmd_text is a string containing the text
-         of the command line the user input
-         
-   POST: command_text has been set
-*/
-void PipedCommand::setCommandText(string new_cmd_text) {
-   command_text = new_cmd_text;
-}
-
-/******************************************************
-   Returns the text of the command line.
-      
-   POST: command_text has been returned.
-*/         
-string PipedCommand::getCommandText() const {
-   return command_text;
-}
-
-/******************************************************
-   Returns the reason the command could not be parsed.
-      
-   POST: error_reason has been returned.
-*/
-string PipedCommand::getErrorReason() const {
-   return error_reason;
-}
-
-/******************************************************
-   Returns the vector of commands for the piped command.
-      
-   POST: The vector cmds has been returned.
-*/
-vector<Command> PipedCommand::getCommands() const {
-   return cmds;
-}
-
-/******************************************************
-   Checks to see if the command actually is a piped
-   command or if it is not. (looks for '|' chars)
-      
-   PRE:  command_text has been set.
-   
-   POST: Returns true if the command requires piping.
-         Returns false if it does not.
-*/         
-bool PipedCommand::checkForPiping() {
-   
-   int pipePosition = command_text.find('|');
-   
-   // no pipes in command
-   if (pipePosition == string::npos)
-      return false;
-      
-   return true;
-}
-
-
-/******************************************************
-   Tries to parse the piped command into separate jobs
-   and then parse those commands.
-      
-   PRE:  command_text has been set.
-   
-   POST: Returns true if successful. Also, the member
-         vector cmds will contain the nested jobs
-         in the command, and those will be parsed as
-         well. Returns false and sets error_reason
-         if unsuccessful.
-*/  
-bool PipedCommand::parsePipedCommand() {
-   
-   int currentPos = 0;
-   bool newWord = true;
-   int currentCommand;
-   
-   // check for '|' char in first position of string
-   // gives nasty error if we don't check
-   if (command_text[0] == '|') {
-      error_reason = "Missing a job.";
-      return false;
-   }
-   
-   // keep parsing until the end of the string, unless error
-   while (currentPos < command_text.size()) {  
-      
-      // check if current char is part of the command
-      if (command_text[currentPos] != '|') {
-         
-         if (newWord) {
-            
-            newWord = false;
-            
-            // push a new Command onto the vector
-            cmds.push_back(Command("pipe"));
-            
-            // get address of newest arg
-            currentCommand = cmds.size() - 1;
-            
-            cmds[currentCommand].setCommandText("");
-         }
-         
-         // append current char to end of sub command
-         cmds[currentCommand].setCommandText(cmds[currentCommand].getCommandText() + command_text[currentPos]);
-         
-         currentPos++;  
-         
-      // end of command
-      } else {
-         
-         // skip past '|' character
-         currentPos++;
-         
-         // try to parse the command
-         if (!cmds[currentCommand].parseCommandText()) {
-            error_reason = cmds[currentCommand].getErrorReason();
-            
-            if (error_reason == "Empty command.")
-               error_reason = "Missing a job.";
-            
-            return false;
-         }
-         
-         newWord = true;
-      }
-   }
-   
-   // parse the last command, since we didn't get to it in the while loop
-   if (!cmds[currentCommand].parseCommandText()) {
-      error_reason = cmds[currentCommand].getErrorReason();
-      
-      if (error_reason == "Empty command.")
-         error_reason = "Missing a job.";
-      
-      return false;
-   }
-   
-   // check to make sure there's at least two commands in vector
-   if (cmds.size() < 2) {
-      error_reason = "Missing a job.";
-      return false;
-   }
-   
-   // FOLLOWING FOR TESTING ONLY!!!!
-   /*
-   for (int i = 0; i < cmds.size(); i++) {
-      cout << "pipe command " << i << " : '" << cmds[i].getCommandText() << "'" << endl;
-   }
-   
-   cout << endl;
-   */
-   
-   return true;
-}
+/* file: PipedCommand.cpp
+   
+   Piped Command Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the data and functions
+   needed for storing and parsing piped commands.
+   
+*/
+
+#include "PipedCommand.h"
+#include <cstdlib>
+#include <errno.h>
+
+using namespace std;
+
+/******************************************************
+   This is the basic constructor for the class.
+   
+   POST: The member variables command_text and error_reason
+         are initialized to "none".
+*/
+PipedCommand::PipedCommand() {
+   command_text = "none";
+   error_reason = "none";
+   is_piped = false;
+   num_cmds = 0;
+   pipe_size.mode = PIPE_SIZE_UNSET;
+   pipe_size.bytes = 0;
+   has_priority = false;
+   priority = 0;
+   parallel_index = -1;
+}
+
+/******************************************************
+   Sets the text of the entire command to whatever
+   string the user specifies.
+   
+   PRE:  new_cmd_text is a string containing the text
+         of the command line the user input
+         
+   POST: command_text has been set
+*/
+void PipedCommand::setCommandText(const string &new_cmd_text) {
+   command_text = new_cmd_text;
+}
+
+/******************************************************
+   Returns the text of the command line.
+      
+   POST: command_text has been returned.
+*/         
+const string & PipedCommand::getCommandText() const {
+   return command_text;
+}
+
+/******************************************************
+   Returns the reason the command could not be parsed.
+      
+   POST: error_reason has been returned.
+*/
+const string & PipedCommand::getErrorReason() const {
+   return error_reason;
+}
+
+/******************************************************
+   Returns one of the commands of the piped command
+   without copying it.
+   
+   PRE:  0 <= command_index < getNumCommands()
+   
+   POST: A reference to the command is returned.
+*/
+const Command & PipedCommand::getCommand(int command_index) const {
+   return cmds[command_index];
+}
+
+/******************************************************
+   Returns the number of commands in the piped command.
+   
+   POST: num_cmds is returned.
+*/
+int PipedCommand::getNumCommands() const {
+   return num_cmds;
+}
+
+/******************************************************
+   Returns whether the last parse found any '|' chars,
+   meaning the command line really needs piping.
+   
+   POST: is_piped has been returned.
+*/
+bool PipedCommand::isPiped() const {
+   return is_piped;
+}
+
+/******************************************************
+   Tries to parse the piped command into separate jobs
+   and then parse those commands. This is done in a
+   single pass over the command text: each sub command
+   parses its own words straight out of command_text
+   and stops at the next '|' char.
+      
+   PRE:  command_text has been set.
+   
+   POST: Returns true if successful. Also, the member
+         vector cmds will contain the nested jobs
+         in the command, and those will be parsed as
+         well. Returns false and sets error_reason
+         if unsuccessful. If the command text has no
+         '|' chars, cmds holds a single command that
+         is not a piped job.
+*/  
+bool PipedCommand::parsePipedCommand() {
+   
+   int currentPos = 0;
+   
+   // find the separators and pipes of the whole line in one go
+   char_map.classify(command_text);
+   
+   // make room for every command up front, growing the vector
+   // later would move all of the commands parsed so far
+   cmds.reserve(char_map.countPipes() + 1);
+   
+   if (!parseStages(command_text, char_map, currentPos))
+      return false;
+   
+   // command lists are handled by CommandList
+   if (currentPos < command_text.size()) {
+      error_reason = "Unexpected command separator.";
+      return false;
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Parses one pipeline of a command list directly out
+   of the whole line.
+   
+   PRE:  map has been classified from line. currentPos
+         is the first char of the pipeline in line.
+   
+   POST: Returns the same as parsePipedCommand(). The
+         text of the pipeline is copied into command_text.
+         currentPos is left on the ';', '&&' or '||' that
+         ended the pipeline, just after a '&' that ended
+         it, or at the end of line.
+*/
+bool PipedCommand::parsePipeline(const string &line, const CharMap &map, int &currentPos) {
+   
+   int pipeline_start = currentPos;
+   
+   bool parsed = parseStages(line, map, currentPos);
+   
+   // keep our own copy of the pipeline for printing
+   command_text.assign(line, pipeline_start, currentPos - pipeline_start);
+   
+   return parsed;
+}
+
+/******************************************************
+   Parses the sub commands of a pipeline one after
+   another, starting at currentPos. Each one parses its
+   own words straight out of line and stops at the next
+   '|' char or at the end of the pipeline.
+   
+   PRE:  map has been classified from line.
+   
+   POST: Returns true if successful, cmds holds the sub
+         commands. Returns false and sets error_reason if
+         unsuccessful. currentPos is the first char after
+         the pipeline.
+*/
+bool PipedCommand::parseStages(const string &line, const CharMap &map, int &currentPos) {
+   
+   num_cmds = 0;
+   is_piped = false;
+   error_reason = "none";
+   pipe_size.mode = PIPE_SIZE_UNSET;
+   pipe_size.bytes = 0;
+   has_priority = false;
+   priority = 0;
+   branches.clear();
+   parallel_index = -1;
+   
+   // the last pipe was a "|+"
+   bool starts_branch = false;
+   
+   // keep parsing until the end of the pipeline, unless error
+   while (true) {
+      
+      // reuse a Command left over from an earlier parse if there
+      // is one, so its buffers don't have to be allocated again
+      if (num_cmds == cmds.size())
+         cmds.push_back(Command());
+      
+      Command &current = cmds[num_cmds];
+      num_cmds++;
+      
+      current.resetCommand();
+      
+      // nothing parsed yet, so this can't fail
+      if (is_piped)
+         current.makePipedJob();
+      
+      if (starts_branch)
+         branches.push_back(num_cmds - 1);
+      
+      // a branch can be nothing but a file to write to
+      int word_start = map.skipSpaces(currentPos);
+      
+      bool to_file = starts_branch && (word_start < line.size()) && (line[word_start] == '>');
+      
+      // parse the command, stops at the next '|' char
+      bool parsed;
+      
+      if (to_file)
+         parsed = current.parseFileStage(line, map, currentPos);
+      else
+         parsed = current.parsePipeStage(line, map, currentPos);
+      
+      // a PIPESIZE= or PRIORITY= word can only go in front of the first one
+      if (parsed && (num_cmds == 1) && (!parsePipeSizeWord(current) || !parsePriorityWord(current)))
+         return false;
+      
+      // but any stage can be PARALLEL=
+      if (parsed && !to_file && !parseParallelWord(current))
+         return false;
+      
+      // a "||" is a command list operator, not a pipe
+      bool at_pipe = (currentPos < line.size()) && (line[currentPos] == '|') &&
+                     (line[currentPos + 1] != '|');
+      
+      // first '|' char found, the first command has to be piped too
+      if (parsed && at_pipe && !is_piped) {
+         is_piped = true;
+         parsed = current.makePipedJob();
+      } else if (at_pipe) {
+         is_piped = true;
+      }
+      
+      if (!parsed) {
+         error_reason = current.getErrorReason();
+         
+         if (is_piped && (error_reason == "Empty command."))
+            error_reason = "Missing a job.";
+         
+         return false;
+      }
+      
+      // end of the pipeline
+      if (!at_pipe)
+         break;
+      
+      // skip past '|' character
+      currentPos++;
+      
+      // and the '+' of a "|+"
+      starts_branch = (line[currentPos] == '+');
+      
+      if (starts_branch)
+         currentPos++;
+      
+      // nothing comes out of a file
+      if (to_file && !starts_branch) {
+         error_reason = "Can't pipe out of a fan-out file.";
+         return false;
+      }
+   }
+   
+   // the shell deals the input to the copies, so there has to
+   // be a pipeline for it to be in the middle of
+   if ((parallel_index != -1) && !is_piped) {
+      error_reason = "PARALLEL= only works in a pipeline.";
+      return false;
+   }
+   
+   if ((parallel_index != -1) && !branches.empty()) {
+      error_reason = "PARALLEL= can't be used with a fan-out.";
+      return false;
+   }
+   
+   // only background jobs wait in the queue
+   if (has_priority && (is_piped || !cmds[0].isBackgroundJob())) {
+      error_reason = "PRIORITY= only works for a background job.";
+      return false;
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Takes a PIPESIZE= word off the front of the first
+   command, if it has one, and keeps the size.
+   
+   PRE:  first has just been parsed.
+   
+   POST: Returns false and sets error_reason if the size
+         can't be read or there's no command after it.
+*/
+bool PipedCommand::parsePipeSizeWord(Command &first) {
+   
+   const char *name = first.getArgsArray()[0];
+   
+   if (strncmp(name, "PIPESIZE=", 9) != 0)
+      return true;
+   
+   if (!parsePipeSize(name + 9, pipe_size)) {
+      error_reason = "Bad pipe size.";
+      return false;
+   }
+   
+   if (!first.dropCommandName()) {
+      error_reason = first.getErrorReason();
+      return false;
+   }
+   
+   return true;
+}
+
+/******************************************************
+   Takes a PRIORITY= word off the front of the first
+   command, if it has one, and keeps the number.
+   
+   PRE:  first has just been parsed.
+   
+   POST: Returns false and sets error_reason if the
+         number can't be read or there's no command
+         after it.
+*/
+bool PipedCommand::parsePriorityWord(Command &first) {
+   
+   const char *name = first.getArgsArray()[0];
+   
+   if (strncmp(name, "PRIORITY=", 9) != 0)
+      return true;
+   
+   char *end;
+   long number = strtol(name + 9, &end, 10);
+   
+   if ((end == name + 9) || (*end != '\0') || (number < -1000000) || (number > 1000000)) {
+      error_reason = "Bad priority.";
+      return false;
+   }
+   
+   if (!first.dropCommandName()) {
+      error_reason = first.getErrorReason();
+      return false;
+   }
+   
+   has_priority = true;
+   priority = number;
+   
+   return true;
+}
+
+/******************************************************
+   Returns the number of "|+" branches in the pipeline.
+   
+   POST: Returns 0 if the pipeline doesn't fan out.
+*/
+int PipedCommand::getNumBranches() const {
+   return branches.size();
+}
+
+/******************************************************
+   Returns the index of the first sub command of one of
+   the "|+" branches.
+   
+   PRE:  0 <= branch_index < getNumBranches()
+*/
+int PipedCommand::getBranchStart(int branch_index) const {
+   return branches[branch_index];
+}
+
+/******************************************************
+   Takes a PARALLEL= word off the front of a stage, if
+   it has one, and keeps the setting.
+   
+   PRE:  current has just been parsed and is the last
+         of the first num_cmds commands.
+   
+   POST: Returns false and sets error_reason if the
+         setting can't be read, another stage already
+         had one, or there's no command after it.
+*/
+bool PipedCommand::parseParallelWord(Command &current) {
+   
+   const char *name = current.getArgsArray()[0];
+   
+   if (strncmp(name, "PARALLEL=", 9) != 0)
+      return true;
+   
+   if (parallel_index != -1) {
+      error_reason = "Only one stage can be PARALLEL=.";
+      return false;
+   }
+   
+   if (!parseParallel(name + 9, parallel_spec)) {
+      error_reason = "Bad PARALLEL= setting.";
+      return false;
+   }
+   
+   if (!current.dropCommandName()) {
+      error_reason = current.getErrorReason();
+      return false;
+   }
+   
+   parallel_index = num_cmds - 1;
+   
+   return true;
+}
+
+/******************************************************
+   Returns which stage of the pipeline is PARALLEL=.
+   
+   POST: Returns -1 if none of them are.
+*/
+int PipedCommand::getParallelIndex() const {
+   return parallel_index;
+}
+
+/******************************************************
+   Returns how the PARALLEL= stage should be run.
+   
+   PRE:  getParallelIndex() isn't -1.
+*/
+const ParallelSpec & PipedCommand::getParallelSpec() const {
+   return parallel_spec;
+}
+
+/******************************************************
+   Reads a number of copies, then ":ordered" or ":ready"
+   and a chunk size in bytes with an optional K or M,
+   both of which can be left out.
+   
+   POST: Returns false and leaves spec alone if text
+         isn't one of those.
+*/
+bool PipedCommand::parseParallel(const char *text, ParallelSpec &spec) {
+   
+   char *end;
+   long copies = strtol(text, &end, 10);
+   
+   if ((end == text) || (copies < 1) || (copies > MAX_PARALLEL_COPIES))
+      return false;
+   
+   ParallelSpec result = { (int) copies, true, PARALLEL_CHUNK_BYTES };
+   const char *option_end = end;
+   
+   while (*option_end == ':') {
+      
+      const char *option = option_end + 1;
+      
+      if ((strncmp(option, "ordered", 7) == 0) && ((option[7] == ':') || (option[7] == '\0'))) {
+         result.ordered = true;
+         option_end = option + 7;
+      } else if ((strncmp(option, "ready", 5) == 0) && ((option[5] == ':') || (option[5] == '\0'))) {
+         result.ordered = false;
+         option_end = option + 5;
+      } else {
+         
+         long bytes = parseByteCount(option, &option_end);
+         
+         if (bytes <= 0)
+            return false;
+         
+         result.chunk_bytes = bytes;
+      }
+   }
+   
+   if (*option_end != '\0')
+      return false;
+   
+   spec = result;
+   
+   return true;
+}
+
+/******************************************************
+   Reads a number of bytes with an optional K or M
+   after it.
+   
+   POST: Returns -1 if text doesn't start with one, or
+         it is over 1G. end is left on the char after it.
+*/
+long PipedCommand::parseByteCount(const char *text, const char **end) {
+   
+   char *number_end;
+   errno = 0;
+   long bytes = strtol(text, &number_end, 10);
+   
+   if ((number_end == text) || (bytes <= 0) || (errno == ERANGE))
+      return -1;
+   
+   long multiplier = 1;
+   
+   if ((*number_end == 'K') || (*number_end == 'k')) {
+      multiplier = 1024;
+      number_end++;
+   } else if ((*number_end == 'M') || (*number_end == 'm')) {
+      multiplier = 1024 * 1024;
+      number_end++;
+   }
+   
+   // nothing the shell makes gets bigger than this anyway,
+   // checked before multiplying so it can't overflow
+   if (bytes > (1024 * 1024 * 1024) / multiplier)
+      return -1;
+   
+   *end = number_end;
+   
+   return bytes * multiplier;
+}
+
+/******************************************************
+   Returns how the pipeline's pipes should be sized.
+   
+   POST: The mode is PIPE_SIZE_UNSET if the pipeline
+         had no PIPESIZE= word.
+*/
+const PipeSize & PipedCommand::getPipeSize() const {
+   return pipe_size;
+}
+
+/******************************************************
+   Returns the priority of a background job.
+   
+   POST: Returns 0 if it had no PRIORITY= word.
+*/
+int PipedCommand::getPriority() const {
+   return priority;
+}
+
+/******************************************************
+   Reads "default", "adaptive", or a number of bytes
+   with an optional K or M after it.
+   
+   POST: Returns false and leaves size alone if text
+         isn't one of those.
+*/
+bool PipedCommand::parsePipeSize(const char *text, PipeSize &size) {
+   
+   if (strcmp(text, "default") == 0) {
+      size.mode = PIPE_SIZE_DEFAULT;
+      size.bytes = 0;
+      return true;
+   }
+   
+   if (strcmp(text, "adaptive") == 0) {
+      size.mode = PIPE_SIZE_ADAPTIVE;
+      size.bytes = 0;
+      return true;
+   }
+   
+   const char *end;
+   long bytes = parseByteCount(text, &end);
+   
+   if ((bytes <= 0) || (*end != '\0'))
+      return false;
+   
+   size.mode = PIPE_SIZE_FIXED;
+   size.bytes = bytes;
+   
+   return true;
+}
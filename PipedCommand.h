@@ -1,137 +1,320 @@
-/* file: PipedCommand.cpp
-   
-   Piped Command Class Header File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class is based around the data and functions
-   needed for storing and parsing piped commands.
-   
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on constructors:                   !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-
-   PipedCommand()
-   --------------------------------------------------
-      This is the basic constructor for the class.
-   
-      POST: The object has been initialized.
-   
-      
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on public methods:                 !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-
-   void setCommandText(string new_cmd_text)
-   --------------------------------------------------
-      Sets the text of the entire command to whatever
-      string the user specifies.
-   
-      PRE:  new_cmd_text is a string containing the text
-            of the command line.
-         
-      POST: new_cmd_text is now the value of this object's
-            command text.
-   
-
-   string getCommandText() const
-   --------------------------------------------------
-      Returns the command text of this object.
-   
-      POST: A string containing the text of the command
-            line is returned.
-   
-   
-   string getErrorReason() const
-   --------------------------------------------------
-      Returns the reason the command couldn't be parsed.
-
-      POST: If command couldn't be parsed, returns a string
-            containing the reason. If command was parsed
-            successfully or has not been parsed at all,
-            returns "none".
-   
-   
-   vector<Command> getCommands() const
-   --------------------------------------------------
-      Returns the vector of sub commands that are
-      all part of this larger object.
-      
-      POST: Returns a vector of Command objects.
-   
-
-   bool checkForPiping()
-   --------------------------------------------------
-      Checks to see if the command is a piped command
-      or if this object isn't needed. (looks for '|' chars)
-         
-      PRE:  The command text of this object has been set.
-      
-      POST: Returns true if the command is piped.
-            Returns false if it is not.
-   
-   
-   bool parsePipedCommand()
-   --------------------------------------------------
-      Tries to parse the piped command into separate
-      sub commands and then parse those commands.
-         
-      PRE:  The command text of this object has been set
-            and is known to be a command that is piped.
-      
-      POST: A boolean is returned based on whether the
-            command was parsed correctly or not. If false
-            is returned, the reason is stored by this
-            object. If the command was parsed correctly
-            and true is returned, all of the data
-            will be set correctly and available using
-            the public "get" commands.
-         
-*/
-
-#ifndef PIPECMD_HEADER
-#define PIPECMD_HEADER
-
-#include <string>
-#include <vector>
-#include <iostream>
-#include "Command.h"
-
-using namespace std;
-
-class PipedCommand {
-   
-    public:
-    
-         // constructor
-         PipedCommand();
-      
-         // set functions
-         void setCommandText(string new_cmd_text);
-         
-         // get functions
-         string getCommandText() const;
-         string getErrorReason() const;
-         vector<Command> getCommands() const;
-         
-         // other functions
-         bool checkForPiping();
-         bool parsePipedCommand();
-    
-    private:
-    
-         //------------------------------------------------------------
-         // Data
-         //------------------------------------------------------------
-         
-         string command_text;
-         string error_reason;
-         
-         // list of commands to be piped
-         vector<Command> cmds;
-    
-};
-
-#endif
+/* file: PipedCommand.cpp
+   
+   Piped Command Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class is based around the data and functions
+   needed for storing and parsing piped commands.
+   
+   A pipeline can start with a PIPESIZE= word to pick
+   how big its pipes are made, which is used instead of
+   the shell's "pipesize" setting:
+   
+      PIPESIZE=1M gzip -dc big.gz | grep error | wc -l
+   
+   The size is "default" (the kernel's), "adaptive"
+   (grown while the pipeline runs if a pipe fills up),
+   or a number of bytes with an optional K or M.
+   
+   A "|+" instead of a '|' fans the output out: each
+   "|+" starts a branch, and every branch gets its own
+   copy of what the stages before the first "|+" write.
+   A branch is a command, or a pipeline of them joined
+   by '|', or just "> file":
+   
+      make 2>&1 |+ > build.log |+ grep error |+ wc -l
+   
+   One stage of a pipeline can have a PARALLEL= word in
+   front of it to run as several copies at once. Its
+   input is cut into chunks at line ends and each chunk
+   goes to a copy of its own:
+   
+      cat big.log | PARALLEL=8 grep -c error | paste -sd+ | bc
+   
+   The setting is the number of copies, then ":ordered"
+   (the output comes out in the order of the input, the
+   default) or ":ready" (each line of output as soon as
+   it is ready), then the size of the chunks, like
+   PARALLEL=8:ready:256K. It can't be used with "|+".
+   
+   A background job can start with a PRIORITY= word,
+   for when there are more jobs than the "joblimit"
+   builtin lets run at once. The waiting jobs with the
+   highest priority start first, 0 being the default:
+   
+      PRIORITY=5 make -C urgent &
+   
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   PipedCommand()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+   
+      POST: The object has been initialized.
+   
+      
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   void setCommandText(const string &new_cmd_text)
+   --------------------------------------------------
+      Sets the text of the entire command to whatever
+      string the user specifies.
+   
+      PRE:  new_cmd_text is a string containing the text
+            of the command line.
+         
+      POST: new_cmd_text is now the value of this object's
+            command text.
+   
+
+   const string & getCommandText() const
+   --------------------------------------------------
+      Returns the command text of this object.
+   
+      POST: A string containing the text of the command
+            line is returned.
+   
+   
+   const string & getErrorReason() const
+   --------------------------------------------------
+      Returns the reason the command couldn't be parsed.
+
+      POST: If command couldn't be parsed, returns a string
+            containing the reason. If command was parsed
+            successfully or has not been parsed at all,
+            returns "none".
+   
+   
+   const Command & getCommand(int command_index) const
+   --------------------------------------------------
+      Returns one of the sub commands without copying it.
+      
+      PRE:  0 <= command_index < getNumCommands()
+      
+      POST: Returns a reference to the Command object. It
+            stays good until this object is parsed again
+            or destroyed.
+   
+   
+   int getNumCommands() const
+   --------------------------------------------------
+      Returns the number of sub commands.
+      
+      POST: Returns the size of the vector of commands.
+   
+
+   const PipeSize & getPipeSize() const
+   --------------------------------------------------
+      Returns the pipe size from the PIPESIZE= word of
+      the pipeline.
+      
+      POST: The mode is PIPE_SIZE_UNSET if there wasn't
+            one.
+      
+      
+   int getNumBranches() const
+   int getBranchStart(int branch_index) const
+   --------------------------------------------------
+      Return the number of "|+" branches and the index of
+      the first sub command of each one. A branch goes on
+      up to the start of the next one, or the end.
+      
+      PRE:  0 <= branch_index < getNumBranches()
+      
+      POST: There are no branches if the pipeline doesn't
+            fan out.
+      
+      
+   int getPriority() const
+   --------------------------------------------------
+      Returns the priority from the PRIORITY= word of a
+      background job.
+      
+      POST: Returns 0 if there wasn't one.
+      
+      
+   int getParallelIndex() const
+   const ParallelSpec & getParallelSpec() const
+   --------------------------------------------------
+      Return which sub command has a PARALLEL= word and
+      how it should be run.
+      
+      POST: The index is -1 if no stage is parallel.
+      
+      
+   static bool parseParallel(const char *text, ParallelSpec &spec)
+   --------------------------------------------------
+      Reads a setting the way PARALLEL= writes it.
+      
+      POST: Returns false and leaves spec alone if text
+            isn't a parallel setting.
+      
+      
+   static bool parsePipeSize(const char *text, PipeSize &size)
+   --------------------------------------------------
+      Reads a pipe size the way PIPESIZE= and the
+      "pipesize" builtin write it.
+      
+      POST: Returns false and leaves size alone if text
+            isn't a pipe size.
+      
+      
+   bool isPiped() const
+   --------------------------------------------------
+      Returns whether the last call to parsePipedCommand()
+      found any '|' chars in the command text.
+      
+      POST: Returns true if the command needs piping.
+            Returns false if it is a lone command.
+   
+
+   bool parsePipedCommand()
+   --------------------------------------------------
+      Tries to parse the piped command into separate
+      sub commands and then parse those commands, all in
+      one pass over the command text.
+         
+      PRE:  The command text of this object has been set.
+            It doesn't need to be checked for piping first,
+            a command line with no '|' chars is parsed into
+            a single command and isPiped() returns false.
+      
+      POST: A boolean is returned based on whether the
+            command was parsed correctly or not. If false
+            is returned, the reason is stored by this
+            object. If the command was parsed correctly
+            and true is returned, all of the data
+            will be set correctly and available using
+            the public "get" commands. The command text
+            can't be a command list.
+   
+   
+   bool parsePipeline(const string &line, const CharMap &map, int &currentPos)
+   --------------------------------------------------
+      Parses one pipeline of a command list, starting at
+      currentPos and ending at the next ';', '&&' or '||'
+      outside of quotes, just after a '&', or at the end
+      of the line.
+      
+      PRE:  map has been classified from line.
+      
+      POST: Returns the same as parsePipedCommand(). The
+            text of the pipeline becomes the command text
+            of this object. currentPos is left on the
+            first char after the pipeline.
+         
+*/
+
+#ifndef PIPECMD_HEADER
+#define PIPECMD_HEADER
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Command.h"
+
+using namespace std;
+
+// ways of sizing the pipes of a pipeline
+enum PipeSizeMode {
+   PIPE_SIZE_UNSET,      // the pipeline didn't say
+   PIPE_SIZE_DEFAULT,    // whatever the kernel gives
+   PIPE_SIZE_FIXED,      // bytes, set when the pipe is made
+   PIPE_SIZE_ADAPTIVE    // grown when it fills up
+};
+
+struct PipeSize {
+   PipeSizeMode mode;
+   int bytes;            // for PIPE_SIZE_FIXED
+};
+
+// most copies a PARALLEL= stage can run at once
+const int MAX_PARALLEL_COPIES = 256;
+
+// how big the chunks of a PARALLEL= stage are by default
+const int PARALLEL_CHUNK_BYTES = 1024 * 1024;
+
+// how a PARALLEL= stage is run
+struct ParallelSpec {
+   int copies;           // how many run at once
+   bool ordered;         // output in the order of the input
+   int chunk_bytes;      // about how much input each copy gets
+};
+
+class PipedCommand {
+   
+    public:
+    
+         // constructor
+         PipedCommand();
+      
+         // set functions
+         void setCommandText(const string &new_cmd_text);
+         
+         // get functions
+         const string & getCommandText() const;
+         const string & getErrorReason() const;
+         const Command & getCommand(int command_index) const;
+         int getNumCommands() const;
+         const PipeSize & getPipeSize() const;
+         int getPriority() const;
+         int getNumBranches() const;
+         int getBranchStart(int branch_index) const;
+         int getParallelIndex() const;
+         const ParallelSpec & getParallelSpec() const;
+         static bool parseParallel(const char *text, ParallelSpec &spec);
+         static bool parsePipeSize(const char *text, PipeSize &size);
+         
+         bool isPiped() const;
+         
+         // other functions
+         bool parsePipedCommand();
+         bool parsePipeline(const string &line, const CharMap &map, int &currentPos);
+    
+    private:
+    
+         // parse the sub commands starting at currentPos
+         bool parseStages(const string &line, const CharMap &map, int &currentPos);
+         bool parsePipeSizeWord(Command &first);
+         bool parsePriorityWord(Command &first);
+         bool parseParallelWord(Command &current);
+         static long parseByteCount(const char *text, const char **end);
+    
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+         
+         string command_text;
+         string error_reason;
+         bool is_piped;
+         PipeSize pipe_size;
+         
+         // from a PRIORITY= word
+         bool has_priority;
+         int priority;
+         
+         // special chars of command_text
+         CharMap char_map;
+         
+         // list of commands to be piped, only the first num_cmds
+         // are in use, the rest are kept around to be reused
+         vector<Command> cmds;
+         int num_cmds;
+         
+         // index of the first sub command of each "|+" branch
+         vector<int> branches;
+         
+         // the PARALLEL= stage, or -1
+         int parallel_index;
+         ParallelSpec parallel_spec;
+    
+};
+
+#endif
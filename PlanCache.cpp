@@ -0,0 +1,143 @@
+/* file: PlanCache.cpp
+
+   Launch Plan Cache Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class remembers the parsed form of command lines
+   the shell has already seen, so a line that is typed
+   (or piped in) again doesn't have to be parsed again.
+
+*/
+
+#include "PlanCache.h"
+
+using namespace std;
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: The cache is empty, the counters are zero and
+         the limit is DEFAULT_PLAN_LIMIT.
+*/
+PlanCache::PlanCache() {
+   limit = DEFAULT_PLAN_LIMIT;
+   num_hits = 0;
+   num_misses = 0;
+}
+
+/******************************************************
+   Returns the launch plan for a command line.
+
+   POST: Returns the plan for line.
+*/
+LaunchPlan & PlanCache::getPlan(const string &line) {
+
+   LineView view = { line.data(), (int) line.size() };
+
+   return getPlan(view);
+}
+
+/******************************************************
+   Returns the launch plan for a line from the reader.
+   A line that is already cached is moved to the front
+   of the list, otherwise it is copied into a new plan,
+   parsed and added to the front.
+
+   POST: Returns the plan for line.
+*/
+LaunchPlan & PlanCache::getPlan(const LineView &line) {
+
+   map<string, list<LaunchPlan>::iterator, PlanKeyLess>::iterator found = index.find(line);
+
+   // cache hit, mark as most recently used
+   if (found != index.end()) {
+      num_hits++;
+      plans.splice(plans.begin(), plans, found->second);
+      return plans.front();
+   }
+
+   // cache miss, parse and compile the line, which also lays out
+   // the argument arrays
+   num_misses++;
+
+   plans.push_front(LaunchPlan());
+   LaunchPlan &plan = plans.front();
+
+   plan.line.assign(line.chars, line.length);
+   plan.cmd_list.setCommandText(plan.line);
+   plan.parsed = plan.cmd_list.parseCommandList();
+
+   index[plan.line] = plans.begin();
+
+   // make room, never throws out the new plan
+   if (limit > 0)
+      trimToSize(limit);
+
+   return plan;
+}
+
+/******************************************************
+   Sets the most plans the cache will hold.
+
+   PRE:  new_limit >= 0, 0 means no limit.
+
+   POST: Least recently used plans have been thrown out
+         until the cache fits.
+*/
+void PlanCache::setLimit(int new_limit) {
+
+   limit = new_limit;
+
+   if (limit > 0)
+      trimToSize(limit);
+}
+
+/******************************************************
+   Throws out all of the plans.
+
+   POST: The cache is empty and the counters are zero.
+*/
+void PlanCache::clear() {
+
+   plans.clear();
+   index.clear();
+
+   num_hits = 0;
+   num_misses = 0;
+}
+
+/******************************************************
+   Prints the hit and miss counters, the number of
+   plans and the limit to standard out.
+
+   POST: The stats have been printed.
+*/
+void PlanCache::printStats() const {
+
+   cout << "Plan cache:" << endl;
+   cout << "  hits:   " << num_hits << endl;
+   cout << "  misses: " << num_misses << endl;
+   cout << "  plans:  " << plans.size() << endl;
+
+   if (limit > 0)
+      cout << "  limit:  " << limit << endl;
+   else
+      cout << "  limit:  none" << endl;
+}
+
+/******************************************************
+   Throws out the least recently used plans until there
+   are max_plans or fewer left.
+
+   PRE:  max_plans > 0
+
+   POST: plans.size() <= max_plans
+*/
+void PlanCache::trimToSize(int max_plans) {
+
+   while (plans.size() > max_plans) {
+      index.erase(plans.back().line);
+      plans.pop_back();
+   }
+}
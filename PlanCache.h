@@ -0,0 +1,148 @@
+/* file: PlanCache.h
+
+   Launch Plan Cache Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class remembers the parsed form of command lines
+   the shell has already seen, so a line that is typed
+   (or piped in) again doesn't have to be parsed again.
+   Each entry is a launch plan: the compiled CommandList
+   for the line, whose commands already have their exec
+   argument arrays laid out. When the cache is full
+   the least recently used plan is thrown out.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   PlanCache()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: The cache is empty and holds at most
+            DEFAULT_PLAN_LIMIT plans.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   LaunchPlan & getPlan(const string &line)
+   LaunchPlan & getPlan(const LineView &line)
+   --------------------------------------------------
+      Returns the launch plan for a command line. If the
+      line isn't in the cache it is parsed and added.
+      A line from the LineReader is looked up without
+      being copied, it is only copied into a new plan.
+
+      POST: Returns the plan. The reference stays good
+            until the next call to getPlan(), setLimit()
+            or clear().
+
+
+   void setLimit(int new_limit)
+   --------------------------------------------------
+      Sets the most plans the cache will hold. A limit
+      of 0 means there is no limit.
+
+      PRE:  new_limit >= 0
+
+      POST: Old plans have been thrown out until the cache
+            fits in the new limit.
+
+
+   void clear()
+   --------------------------------------------------
+      Throws out all of the plans.
+
+      POST: The cache is empty. The hit and miss counters
+            are reset to zero.
+
+
+   void printStats() const
+   --------------------------------------------------
+      Prints the hit and miss counters, the number of
+      plans and the limit to standard out.
+
+*/
+
+#ifndef PLAN_HEADER
+#define PLAN_HEADER
+
+#include <string>
+#include <list>
+#include <map>
+#include <iostream>
+#include "CommandList.h"
+#include "LineReader.h"
+
+using namespace std;
+
+// number of plans held by a new cache
+const int DEFAULT_PLAN_LIMIT = 512;
+
+// a command line that is parsed and ready to run
+struct LaunchPlan {
+   string line;                 // the raw command line
+   CommandList cmd_list;        // pipelines and compiled program
+   bool parsed;                 // false if the line had an error
+};
+
+// orders the keys of the index, and lets a LineView be looked
+// up without making a string out of it
+struct PlanKeyLess {
+
+   typedef void is_transparent;
+
+   bool operator()(const string &left, const string &right) const {
+      return left < right;
+   }
+
+   bool operator()(const string &left, const LineView &right) const {
+      return left.compare(0, string::npos, right.chars, right.length) < 0;
+   }
+
+   bool operator()(const LineView &left, const string &right) const {
+      return right.compare(0, string::npos, left.chars, left.length) > 0;
+   }
+};
+
+class PlanCache {
+
+    public:
+
+         // constructor
+         PlanCache();
+
+         // lookups
+         LaunchPlan & getPlan(const string &line);
+         LaunchPlan & getPlan(const LineView &line);
+
+         // cache control
+         void setLimit(int new_limit);
+         void clear();
+         void printStats() const;
+
+    private:
+
+         // throw out plans until there are max_plans or fewer
+         void trimToSize(int max_plans);
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         // plans in order of use, most recently used at the front
+         list<LaunchPlan> plans;
+
+         // line text to position in plans
+         map<string, list<LaunchPlan>::iterator, PlanKeyLess> index;
+
+         int limit;
+         long num_hits;
+         long num_misses;
+};
+
+#endif
@@ -0,0 +1,410 @@
+/* file: SpawnHelper.cpp
+
+   Spawn Helper Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class runs a small helper process that starts
+   commands for the shell, talking to it over a
+   SOCK_SEQPACKET socketpair so every request and reply
+   is one message.
+
+*/
+
+#include "SpawnHelper.h"
+#include "Spawner.h"
+#include <cstring>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// room for the fds of one message
+union FdControl {
+   struct cmsghdr align;
+   char buffer[CMSG_SPACE(sizeof(int) * HELPER_MAX_FDS)];
+};
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: There is no helper process yet.
+*/
+SpawnHelper::SpawnHelper() {
+   socket_fd = -1;
+   helper_pid = -1;
+}
+
+/******************************************************
+   Forks the helper process, which never returns from
+   serve().
+
+   POST: Returns true if the helper is running.
+*/
+bool SpawnHelper::start() {
+
+   if (socket_fd != -1)
+      return true;
+
+   int sockets[2];
+
+   if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == -1)
+      return false;
+
+   pid_t pid = fork();
+
+   // error
+   if (pid < 0) {
+      close(sockets[0]);
+      close(sockets[1]);
+      return false;
+   }
+
+   // the helper
+   if (pid == 0) {
+      close(sockets[0]);
+      socket_fd = sockets[1];
+      serve();
+      _exit(0);
+   }
+
+   // still here, must be the shell
+   close(sockets[1]);
+   socket_fd = sockets[0];
+   helper_pid = pid;
+
+   return true;
+}
+
+/******************************************************
+   Returns whether there is a helper to send requests to.
+*/
+bool SpawnHelper::isRunning() const {
+   return (socket_fd != -1);
+}
+
+/******************************************************
+   Sends a spawn request to the helper and waits for the
+   answer. The working directory is sent as an O_PATH fd
+   along with every fd the file actions dup2().
+
+   PRE:  The helper is running.
+
+   POST: Returns false if nothing was started, either
+         because the request was too big or the helper
+         is gone. Otherwise pid is the new process, or -1
+         with the failure of spawner set.
+*/
+bool SpawnHelper::spawn(Spawner &spawner, char * const *argv, pid_t &pid) {
+
+   request_actions.clear();
+   request_data.clear();
+   action_index.clear();
+
+   // the command, then its arguments
+   RequestHeader header;
+   header.num_args = 0;
+
+   if (!appendData(spawner.exec_path))
+      return false;
+
+   while (argv[header.num_args] != NULL) {
+
+      if (!appendData(argv[header.num_args]))
+         return false;
+
+      header.num_args++;
+   }
+
+   int fds[HELPER_MAX_FDS];
+   int num_fds = 1;
+
+   // the fds the shell closes in the child don't exist in the
+   // helper, and the ones it sends are closed on exec there
+   for (int actionCtr = 0; actionCtr < spawner.actions.size(); actionCtr++) {
+
+      const Spawner::FileAction &action = spawner.actions[actionCtr];
+
+      if (action.type == Spawner::ACTION_CLOSE)
+         continue;
+
+      RequestAction sent = { action.type, action.fd, -1, -1, action.flags, (int) action.mode };
+
+      if (action.type == Spawner::ACTION_OPEN) {
+
+         sent.path_offset = request_data.size();
+
+         if (!appendData(action.path))
+            return false;
+
+      } else {
+
+         if (num_fds == HELPER_MAX_FDS)
+            return false;
+
+         sent.source_index = num_fds;
+         fds[num_fds] = action.source_fd;
+         num_fds++;
+      }
+
+      request_actions.push_back(sent);
+      action_index.push_back(actionCtr);
+   }
+
+   header.num_actions = request_actions.size();
+   header.data_length = request_data.size();
+
+   int request_length = sizeof(header) + header.num_actions * sizeof(RequestAction) + header.data_length;
+
+   if (request_length > HELPER_MAX_REQUEST)
+      return false;
+
+   // relative paths in the command have to mean the same thing
+   // they do to the shell
+   fds[0] = open(".", O_PATH | O_DIRECTORY | O_CLOEXEC);
+
+   if (fds[0] == -1)
+      return false;
+
+   struct iovec parts[3];
+   parts[0].iov_base = &header;
+   parts[0].iov_len = sizeof(header);
+   parts[1].iov_base = request_actions.data();
+   parts[1].iov_len = header.num_actions * sizeof(RequestAction);
+   parts[2].iov_base = request_data.data();
+   parts[2].iov_len = header.data_length;
+
+   FdControl control;
+   struct msghdr message;
+   memset(&message, 0, sizeof(message));
+
+   message.msg_iov = parts;
+   message.msg_iovlen = 3;
+   message.msg_control = control.buffer;
+   message.msg_controllen = CMSG_SPACE(sizeof(int) * num_fds);
+
+   struct cmsghdr *fd_header = CMSG_FIRSTHDR(&message);
+   fd_header->cmsg_level = SOL_SOCKET;
+   fd_header->cmsg_type = SCM_RIGHTS;
+   fd_header->cmsg_len = CMSG_LEN(sizeof(int) * num_fds);
+   memcpy(CMSG_DATA(fd_header), fds, sizeof(int) * num_fds);
+
+   ssize_t num_sent;
+   do {
+      num_sent = sendmsg(socket_fd, &message, MSG_NOSIGNAL);
+   } while ((num_sent < 0) && (errno == EINTR));
+
+   close(fds[0]);
+
+   Reply reply;
+   ssize_t num_read = -1;
+
+   if (num_sent == request_length) {
+      do {
+         num_read = recv(socket_fd, &reply, sizeof(reply), 0);
+      } while ((num_read < 0) && (errno == EINTR));
+   }
+
+   // the helper is gone, the shell will have to start its own
+   if (num_read != sizeof(reply)) {
+      stop();
+      return false;
+   }
+
+   spawner.failure.step = reply.step;
+   spawner.failure.error = reply.error;
+
+   // the helper numbered the actions it was sent
+   if (reply.step >= 0)
+      spawner.failure.step = action_index[reply.step];
+
+   if (reply.pid <= 0)
+      pid = -1;
+   else
+      pid = spawner.finishSpawn(reply.pid);
+
+   return true;
+}
+
+/******************************************************
+   The helper's main loop. Takes one request at a time
+   until the shell closes its end of the socket.
+
+   POST: Never returns to the caller's code, the helper
+         exits from here.
+*/
+void SpawnHelper::serve() {
+
+   vector<char> message_buffer(HELPER_MAX_REQUEST);
+   vector<char *> args;
+   Spawner spawner;
+
+   while (true) {
+
+      struct iovec part;
+      part.iov_base = message_buffer.data();
+      part.iov_len = message_buffer.size();
+
+      FdControl control;
+      struct msghdr message;
+      memset(&message, 0, sizeof(message));
+
+      message.msg_iov = &part;
+      message.msg_iovlen = 1;
+      message.msg_control = control.buffer;
+      message.msg_controllen = sizeof(control.buffer);
+
+      ssize_t num_read = recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC);
+
+      if ((num_read < 0) && (errno == EINTR))
+         continue;
+
+      // the shell is gone
+      if (num_read <= 0)
+         _exit(0);
+
+      int fds[HELPER_MAX_FDS];
+      int num_fds = 0;
+
+      struct cmsghdr *fd_header = CMSG_FIRSTHDR(&message);
+
+      if ((fd_header != NULL) && (fd_header->cmsg_level == SOL_SOCKET) && (fd_header->cmsg_type == SCM_RIGHTS)) {
+         num_fds = (fd_header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+         memcpy(fds, CMSG_DATA(fd_header), sizeof(int) * num_fds);
+      }
+
+      Reply reply;
+
+      if (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+         reply.pid = -1;
+         reply.step = Spawner::STEP_CREATE;
+         reply.error = E2BIG;
+      } else {
+         runRequest(spawner, args, message_buffer.data(), num_read, fds, num_fds, reply);
+      }
+
+      for (int fdCtr = 0; fdCtr < num_fds; fdCtr++)
+         close(fds[fdCtr]);
+
+      if (send(socket_fd, &reply, sizeof(reply), MSG_NOSIGNAL) != sizeof(reply))
+         _exit(0);
+   }
+}
+
+/******************************************************
+   Checks one request and starts its process as a child
+   of the shell. The shell waits for the process even
+   if it fails, since it isn't the helper's child.
+
+   PRE:  fds[0] is the shell's working directory.
+
+   POST: reply holds the process id and what failed.
+*/
+void SpawnHelper::runRequest(Spawner &spawner, vector<char *> &args, char *message,
+                             int message_length, const int *fds, int num_fds, Reply &reply) {
+
+   reply.pid = -1;
+   reply.step = Spawner::STEP_CREATE;
+   reply.error = EINVAL;
+
+   RequestHeader header;
+
+   if ((message_length < sizeof(header)) || (num_fds < 1))
+      return;
+
+   memcpy(&header, message, sizeof(header));
+
+   int actions_length = header.num_actions * sizeof(RequestAction);
+
+   if ((header.num_args < 1) || (header.num_actions < 0) || (header.data_length < 1)
+       || (message_length != sizeof(header) + actions_length + header.data_length))
+      return;
+
+   char *data = message + sizeof(header) + actions_length;
+
+   if (data[header.data_length - 1] != '\0')
+      return;
+
+   // the command is first in the data, then the arguments
+   args.clear();
+   int data_pos = strlen(data) + 1;
+
+   for (int argCtr = 0; argCtr < header.num_args; argCtr++) {
+
+      if (data_pos >= header.data_length)
+         return;
+
+      args.push_back(data + data_pos);
+      data_pos += strlen(data + data_pos) + 1;
+   }
+
+   args.push_back(NULL);
+
+   spawner.reset();
+
+   for (int actionCtr = 0; actionCtr < header.num_actions; actionCtr++) {
+
+      RequestAction action;
+      memcpy(&action, message + sizeof(header) + actionCtr * sizeof(RequestAction), sizeof(action));
+
+      if (action.type == Spawner::ACTION_OPEN) {
+
+         if ((action.path_offset < 0) || (action.path_offset >= header.data_length))
+            return;
+
+         spawner.addOpen(action.fd, data + action.path_offset, action.flags, action.mode);
+
+      } else if (action.type == Spawner::ACTION_DUP2) {
+
+         if ((action.source_index < 1) || (action.source_index >= num_fds))
+            return;
+
+         spawner.addDup2(fds[action.source_index], action.fd);
+
+      } else {
+         return;
+      }
+   }
+
+   spawner.exec_path = data;
+   spawner.dir_fd = fds[0];
+
+   reply.pid = spawner.spawnSibling(args.data());
+   reply.step = spawner.failure.step;
+   reply.error = spawner.failure.error;
+}
+
+/******************************************************
+   Adds a null terminated string to the request data.
+
+   POST: Returns false if the request would get too big.
+*/
+bool SpawnHelper::appendData(const char *text) {
+
+   int length = strlen(text) + 1;
+
+   if (request_data.size() + length > HELPER_MAX_REQUEST)
+      return false;
+
+   request_data.insert(request_data.end(), text, text + length);
+
+   return true;
+}
+
+/******************************************************
+   Lets go of a helper that stopped answering.
+
+   POST: There is no helper.
+*/
+void SpawnHelper::stop() {
+
+   close(socket_fd);
+   socket_fd = -1;
+
+   // it may already have been waited for by the job manager
+   waitpid(helper_pid, NULL, WNOHANG);
+   helper_pid = -1;
+}
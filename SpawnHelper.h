@@ -0,0 +1,158 @@
+/* file: SpawnHelper.h
+
+   Spawn Helper Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class runs a small helper process that starts
+   commands for the shell. The helper is forked once,
+   right when wsh starts and is still tiny, and then
+   waits on one end of a socketpair for spawn requests.
+   However big the shell gets (caches, job tables,
+   buffers), starting a process costs whatever it costs
+   the tiny helper.
+
+   A request holds the full path of the command, its
+   arguments and the file actions. The working
+   directory and every fd that gets dup2()'d are sent
+   along with SCM_RIGHTS. The helper answers with the
+   process id, or with what went wrong.
+
+   The helper starts each command with clone3() and
+   CLONE_PARENT, so the command is a child of the shell
+   and not of the helper. The shell waits for it with
+   waitpid() the same as any other process it started.
+
+   NOTE: Requests bigger than HELPER_MAX_REQUEST, or
+         with more than HELPER_MAX_FDS fds, are started
+         by the shell itself.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   SpawnHelper()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: There is no helper process yet.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   bool start()
+   --------------------------------------------------
+      Forks the helper process. It should be called as
+      early as possible, while the shell is small.
+
+      POST: Returns true if the helper is running. The
+            helper exits when the shell closes its end
+            of the socket.
+
+
+   bool isRunning() const
+   --------------------------------------------------
+      Returns whether there is a helper to send
+      requests to.
+
+
+   bool spawn(Spawner &spawner, char * const *argv, pid_t &pid)
+   --------------------------------------------------
+      Asks the helper to start a process with the file
+      actions and exec_path of spawner.
+
+      PRE:  The helper is running.
+
+      POST: Returns false if the helper couldn't take
+            the request, and then nothing was started.
+            Otherwise returns true and pid is what
+            Spawner::spawn() would have returned, with
+            the failure of spawner set.
+
+*/
+
+#ifndef SPAWNHELPER_HEADER
+#define SPAWNHELPER_HEADER
+
+#include <vector>
+#include <sys/types.h>
+
+using namespace std;
+
+class Spawner;
+
+// biggest request the helper takes, in bytes
+const int HELPER_MAX_REQUEST = 64 * 1024;
+
+// most fds a request can send
+const int HELPER_MAX_FDS = 32;
+
+class SpawnHelper {
+
+    public:
+
+         // constructor
+         SpawnHelper();
+
+         // the helper process
+         bool start();
+         bool isRunning() const;
+
+         // starting a process through the helper
+         bool spawn(Spawner &spawner, char * const *argv, pid_t &pid);
+
+    private:
+
+         // what is sent for each file action
+         struct RequestAction {
+            int type;
+            int fd;
+            int source_index;   // which of the sent fds, for dup2
+            int path_offset;    // where the path is in the data, for open
+            int flags;
+            int mode;
+         };
+
+         // what comes first in a request
+         struct RequestHeader {
+            int num_args;
+            int num_actions;
+            int data_length;
+         };
+
+         // what the helper answers
+         struct Reply {
+            pid_t pid;
+            int step;
+            int error;
+         };
+
+         // the helper's side
+         void serve();
+         void runRequest(Spawner &spawner, vector<char *> &args, char *message,
+                         int message_length, const int *fds, int num_fds, Reply &reply);
+
+         // building a request
+         bool appendData(const char *text);
+         void stop();
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         // shell's end of the socketpair, -1 if there is no helper
+         int socket_fd;
+         pid_t helper_pid;
+
+         // kept between requests so they don't allocate. action_index
+         // is where each sent action is in the Spawner's list, since
+         // close actions aren't sent
+         vector<RequestAction> request_actions;
+         vector<char> request_data;
+         vector<int> action_index;
+};
+
+#endif
@@ -0,0 +1,736 @@
+/* file: Spawner.cpp
+
+   Process Spawner Class Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class starts processes with fork(), vfork(),
+   posix_spawn() or clone3(), or has the SpawnHelper
+   start them.
+
+*/
+
+#include "Spawner.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sched.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// the way every Spawner starts processes, vfork() is as fast as
+// any of them and still says exactly what went wrong
+SpawnMethod Spawner::method = SPAWN_VFORK;
+
+// where the commands are, shared by every Spawner
+PathCache Spawner::path_cache;
+
+// the helper process, if main() started one
+SpawnHelper Spawner::helper;
+
+#if defined(__x86_64__)
+
+// clone3() has no glibc wrapper. The new process shares the stack
+// with the shell until it execs, just like vfork(), so the return
+// address is kept in a register instead of on the stack where the
+// new process would write over it. returns_twice tells the
+// compiler the same thing it is told about vfork().
+extern "C" long wsh_clone3(void *args, size_t size) __attribute__((returns_twice));
+
+asm(".text\n"
+    ".globl wsh_clone3\n"
+    ".type wsh_clone3, @function\n"
+    "wsh_clone3:\n"
+    "   popq %rdx\n"
+    "   movl $435, %eax\n"
+    "   syscall\n"
+    "   pushq %rdx\n"
+    "   ret\n"
+    ".size wsh_clone3, .-wsh_clone3\n");
+
+#define HAVE_CLONE3 1
+
+#endif
+
+// the first version of struct clone_args, which every kernel
+// with clone3() understands
+struct CloneArgs {
+   uint64_t flags;
+   uint64_t pidfd;
+   uint64_t child_tid;
+   uint64_t parent_tid;
+   uint64_t exit_signal;
+   uint64_t stack;
+   uint64_t stack_size;
+   uint64_t tls;
+};
+
+// reset signal handlers in the new process, from linux/sched.h
+const uint64_t WSH_CLONE_CLEAR_SIGHAND = 0x100000000ULL;
+
+// close_range() marks the fds close-on-exec instead of closing
+// them, from linux/close_range.h
+#ifndef CLOSE_RANGE_CLOEXEC
+#define CLOSE_RANGE_CLOEXEC (1U << 2)
+#endif
+
+/******************************************************
+   This is the basic constructor for the class.
+
+   POST: There are no file actions and nothing failed.
+*/
+Spawner::Spawner() {
+   failure.step = STEP_NONE;
+   failure.error = 0;
+   exec_path = NULL;
+   dir_fd = -1;
+}
+
+/******************************************************
+   Forgets the file actions.
+
+   POST: actions is empty, its capacity is kept.
+*/
+void Spawner::reset() {
+   actions.clear();
+}
+
+/******************************************************
+   Adds an action that opens path onto target_fd.
+*/
+void Spawner::addOpen(int target_fd, const char *path, int flags, mode_t mode) {
+
+   FileAction action = { ACTION_OPEN, target_fd, -1, path, flags, mode };
+   actions.push_back(action);
+}
+
+/******************************************************
+   Adds an action that copies source_fd onto target_fd.
+*/
+void Spawner::addDup2(int source_fd, int target_fd) {
+
+   FileAction action = { ACTION_DUP2, target_fd, source_fd, NULL, 0, 0 };
+   actions.push_back(action);
+}
+
+/******************************************************
+   Adds an action that closes fd.
+*/
+void Spawner::addClose(int fd) {
+
+   FileAction action = { ACTION_CLOSE, fd, -1, NULL, 0, 0 };
+   actions.push_back(action);
+}
+
+/******************************************************
+   Looks up the command and starts a process for it. A
+   cached path that doesn't work any more is forgotten
+   and the PATH is searched again, once.
+
+   PRE:  argv is NULL terminated.
+
+   POST: Returns the process id, or -1 with failure set.
+*/
+pid_t Spawner::spawn(char * const *argv) {
+
+   for (int tryCtr = 0; tryCtr < 2; tryCtr++) {
+
+      exec_path = path_cache.lookup(argv[0]);
+
+      // not on the PATH, don't bother starting a process
+      if (exec_path == NULL) {
+         failure.step = STEP_EXEC;
+         failure.error = ENOENT;
+         return -1;
+      }
+
+      pid_t pid = startProcess(argv);
+
+      bool stale = (pid == -1) && (failure.step == STEP_EXEC) && (failure.error == ENOENT)
+                   && (exec_path != argv[0]);
+
+      if (!stale)
+         return pid;
+
+      path_cache.forget(argv[0]);
+   }
+
+   return -1;
+}
+
+/******************************************************
+   Execs the command in this process. Each fd an action
+   changes is copied out of the way first so it can be
+   put back if the exec fails, and the shell's output
+   doesn't end up in a redirect file.
+
+   PRE:  argv is NULL terminated.
+
+   POST: Only returns if something failed, with failure
+         set and the fds as they were.
+*/
+bool Spawner::execInPlace(char * const *argv) {
+
+   failure.step = STEP_NONE;
+   failure.error = 0;
+
+   exec_path = path_cache.lookup(argv[0]);
+
+   // don't touch any fds for a command that isn't there
+   if (exec_path == NULL) {
+      failure.step = STEP_EXEC;
+      failure.error = ENOENT;
+      return false;
+   }
+
+   int num_actions = actions.size();
+   vector<int> saved_fds(num_actions);
+
+   for (int actionCtr = 0; actionCtr < num_actions; actionCtr++)
+      saved_fds[actionCtr] = fcntl(actions[actionCtr].fd, F_DUPFD_CLOEXEC, 10);
+
+   runChild(argv, failure);
+
+   // still here, put the fds back, newest first. One that wasn't
+   // open before is closed again.
+   for (int actionCtr = num_actions - 1; actionCtr >= 0; actionCtr--) {
+
+      int fd = actions[actionCtr].fd;
+
+      if (saved_fds[actionCtr] == -1) {
+         close(fd);
+      } else {
+         dup2(saved_fds[actionCtr], fd);
+         close(saved_fds[actionCtr]);
+      }
+   }
+
+   // the path went away since it was found
+   if ((failure.step == STEP_EXEC) && (failure.error == ENOENT))
+      path_cache.forget(argv[0]);
+
+   return false;
+}
+
+/******************************************************
+   Does the file actions to this process.
+
+   POST: Returns false with failure set if one failed.
+*/
+bool Spawner::redirectInPlace() {
+
+   failure.step = STEP_NONE;
+   failure.error = 0;
+
+   return runActions(failure);
+}
+
+/******************************************************
+   Starts a process with the current method.
+
+   PRE:  exec_path is the full path of argv[0].
+
+   POST: Returns the process id, or -1 with failure set.
+*/
+pid_t Spawner::startProcess(char * const *argv) {
+
+   failure.step = STEP_NONE;
+   failure.error = 0;
+
+   switch (method) {
+      case SPAWN_VFORK:
+         return spawnVfork(argv);
+      case SPAWN_POSIX_SPAWN:
+         return spawnPosix(argv);
+      case SPAWN_CLONE3:
+         return spawnClone3(argv);
+      case SPAWN_HELPER:
+         return spawnHelper(argv);
+      default:
+         return spawnFork(argv);
+   }
+}
+
+/******************************************************
+   Prints why the last spawn() failed, the same way the
+   job classes always have.
+
+   POST: The error has been printed to standard output.
+*/
+void Spawner::printFailure() const {
+
+   if (failure.step == STEP_CHDIR) {
+      cout << "Could not change directory:" << endl;
+      cout << "  " << strerror(failure.error) << "." << endl;
+      return;
+   }
+
+   if (failure.step == STEP_CREATE) {
+      cout << "Execution error: " << endl;
+      cout << "  Could not create process." << endl;
+      return;
+   }
+
+   if (failure.step >= 0) {
+
+      const FileAction &action = actions[failure.step];
+
+      if (action.type != ACTION_OPEN)
+         cout << "Could not use pipeline:" << endl;
+      else if (action.fd == 0)
+         cout << "Input file error:" << endl;
+      else
+         cout << "Output file error:" << endl;
+
+      cout << "  " << strerror(failure.error) << "." << endl;
+      return;
+   }
+
+   cout << "Execution error:" << endl;
+
+   if ((failure.step == STEP_EXEC) && (failure.error == ENOENT))
+      cout << "  Command not found." << endl;
+   else
+      cout << "  " << strerror(failure.error) << "." << endl;
+}
+
+/******************************************************
+   Returns the exit status sh would give a command that
+   failed like the last spawn() did.
+*/
+int Spawner::getFailureStatus() const {
+
+   if (failure.step != STEP_EXEC)
+      return 1;
+
+   if (failure.error == ENOENT)
+      return 127;
+
+   return 126;
+}
+
+/******************************************************
+   Sets the way every Spawner starts processes.
+
+   POST: Returns false and changes nothing if name isn't
+         a method this machine can use.
+*/
+bool Spawner::setMethod(const string &name) {
+
+   if (name == "fork")
+      method = SPAWN_FORK;
+   else if (name == "vfork")
+      method = SPAWN_VFORK;
+   else if (name == "posix_spawn")
+      method = SPAWN_POSIX_SPAWN;
+#ifdef HAVE_CLONE3
+   else if (name == "clone3")
+      method = SPAWN_CLONE3;
+   else if ((name == "helper") && helper.isRunning())
+      method = SPAWN_HELPER;
+#endif
+   else
+      return false;
+
+   return true;
+}
+
+/******************************************************
+   Returns the name of the way processes are started.
+*/
+const char * Spawner::getMethodName() {
+
+   switch (method) {
+      case SPAWN_VFORK:
+         return "vfork";
+      case SPAWN_POSIX_SPAWN:
+         return "posix_spawn";
+      case SPAWN_CLONE3:
+         return "clone3";
+      case SPAWN_HELPER:
+         return "helper";
+      default:
+         return "fork";
+   }
+}
+
+/******************************************************
+   Returns the table of command paths every Spawner
+   uses.
+*/
+PathCache & Spawner::getPathCache() {
+   return path_cache;
+}
+
+/******************************************************
+   Starts the helper process. It needs clone3() to put
+   new processes under the shell.
+
+   POST: Returns true if the helper is running.
+*/
+bool Spawner::startHelper() {
+
+#ifdef HAVE_CLONE3
+   return helper.start();
+#else
+   return false;
+#endif
+}
+
+/******************************************************
+   Starts the process with fork(). The child reports a
+   failure through a pipe that exec closes, so the
+   shell reads either the failure or nothing at all.
+
+   POST: Returns the process id, or -1 with failure set.
+*/
+pid_t Spawner::spawnFork(char * const *argv) {
+
+   int report[2];
+
+   if (pipe2(report, O_CLOEXEC) == -1) {
+      failure.step = STEP_CREATE;
+      failure.error = errno;
+      return -1;
+   }
+
+   pid_t pid = fork();
+
+   // error
+   if (pid < 0) {
+      failure.step = STEP_CREATE;
+      failure.error = errno;
+      close(report[0]);
+      close(report[1]);
+      return -1;
+   }
+
+   // child process
+   if (pid == 0) {
+
+      Failure child_failure;
+
+      close(report[0]);
+      runChild(argv, child_failure);
+
+      write(report[1], &child_failure, sizeof(child_failure));
+      _exit(127);
+   }
+
+   // still here, must be the parent
+   close(report[1]);
+
+   ssize_t num_read;
+   do {
+      num_read = read(report[0], &failure, sizeof(failure));
+   } while ((num_read < 0) && (errno == EINTR));
+
+   close(report[0]);
+
+   // exec closed the pipe without a word
+   if (num_read != sizeof(failure))
+      failure.step = STEP_NONE;
+
+   return finishSpawn(pid);
+}
+
+/******************************************************
+   Starts the process with vfork(). The shell is stopped
+   until the child execs or exits, and the child writes
+   a failure straight into this object since they share
+   memory.
+
+   POST: Returns the process id, or -1 with failure set.
+*/
+pid_t Spawner::spawnVfork(char * const *argv) {
+
+   pid_t pid = vfork();
+
+   // child process, don't return from here
+   if (pid == 0) {
+      runChild(argv, failure);
+      _exit(127);
+   }
+
+   // error
+   if (pid < 0) {
+      failure.step = STEP_CREATE;
+      failure.error = errno;
+      return -1;
+   }
+
+   return finishSpawn(pid);
+}
+
+/******************************************************
+   Starts the process with posix_spawn(). The file
+   actions are handed over as posix_spawn file actions.
+
+   POST: Returns the process id, or -1 with failure set.
+*/
+pid_t Spawner::spawnPosix(char * const *argv) {
+
+   posix_spawn_file_actions_t file_actions;
+   posix_spawn_file_actions_init(&file_actions);
+
+   bool opens_files = false;
+
+   for (int actionCtr = 0; actionCtr < actions.size(); actionCtr++) {
+
+      const FileAction &action = actions[actionCtr];
+
+      if (action.type == ACTION_OPEN) {
+         posix_spawn_file_actions_addopen(&file_actions, action.fd, action.path, action.flags, action.mode);
+         opens_files = true;
+      }
+      else if (action.type == ACTION_DUP2)
+         posix_spawn_file_actions_adddup2(&file_actions, action.source_fd, action.fd);
+      else
+         posix_spawn_file_actions_addclose(&file_actions, action.fd);
+   }
+
+   // nothing but standard input, output and error gets past exec
+   posix_spawn_file_actions_addclosefrom_np(&file_actions, 3);
+
+   pid_t pid;
+   int error = posix_spawn(&pid, exec_path, &file_actions, NULL, argv, environ);
+
+   posix_spawn_file_actions_destroy(&file_actions);
+
+   // the child has already been waited for. dup2() and close()
+   // don't fail on the pipes we give them, so without an open
+   // it can only have been the exec
+   if (error != 0) {
+      failure.step = opens_files ? STEP_UNKNOWN : STEP_EXEC;
+      failure.error = error;
+      return -1;
+   }
+
+   return pid;
+}
+
+/******************************************************
+   Starts the process with clone3(), sharing memory like
+   vfork() and with the signal handlers cleared so none
+   of the shell's can run in the child.
+
+   POST: Returns the process id, or -1 with failure set.
+*/
+pid_t Spawner::spawnClone3(char * const *argv) {
+
+   pid_t pid = cloneChild(argv, false);
+
+   if (pid == -1)
+      return -1;
+
+   return finishSpawn(pid);
+}
+
+/******************************************************
+   Has the helper start the process. A request that is
+   too big for the helper is started here with vfork()
+   instead, and so is everything after the helper goes
+   away.
+
+   POST: Returns the process id, or -1 with failure set.
+*/
+pid_t Spawner::spawnHelper(char * const *argv) {
+
+   pid_t pid;
+
+   if (helper.isRunning() && helper.spawn(*this, argv, pid))
+      return pid;
+
+   if (!helper.isRunning())
+      method = SPAWN_VFORK;
+
+   return spawnVfork(argv);
+}
+
+/******************************************************
+   Starts a process for the helper with CLONE_PARENT, so
+   it is a child of the shell. A process that failed is
+   left for the shell to wait for.
+
+   POST: Returns the process id, or -1 if no process
+         was made. failure says what went wrong.
+*/
+pid_t Spawner::spawnSibling(char * const *argv) {
+
+   failure.step = STEP_NONE;
+   failure.error = 0;
+
+   return cloneChild(argv, true);
+}
+
+/******************************************************
+   Does the clone3() system call. A sibling is a child
+   of this process's parent, and its exit signal has to
+   be left to the kernel, which uses this process's.
+
+   POST: Returns the process id, or -1 with failure set
+         if there is no new process.
+*/
+pid_t Spawner::cloneChild(char * const *argv, bool sibling) {
+
+#ifdef HAVE_CLONE3
+
+   CloneArgs args;
+   memset(&args, 0, sizeof(args));
+
+   args.flags = CLONE_VM | CLONE_VFORK | WSH_CLONE_CLEAR_SIGHAND;
+   args.exit_signal = SIGCHLD;
+
+   if (sibling) {
+      args.flags |= CLONE_PARENT;
+      args.exit_signal = 0;
+   }
+
+   long pid = wsh_clone3(&args, sizeof(args));
+
+   // child process, don't return from here
+   if (pid == 0) {
+      runChild(argv, failure);
+      _exit(127);
+   }
+
+   // error, the system call returns -errno
+   if (pid < 0) {
+      failure.step = STEP_CREATE;
+      failure.error = -pid;
+      return -1;
+   }
+
+   return pid;
+
+#else
+
+   failure.step = STEP_CREATE;
+   failure.error = ENOSYS;
+   return -1;
+
+#endif
+}
+
+/******************************************************
+   Does the file actions and execs the command. Runs in
+   the new process, which might share memory with the
+   shell, so it only makes system calls.
+
+   POST: Only returns if something failed, and then
+         child_failure says what.
+*/
+void Spawner::runChild(char * const *argv, Failure &child_failure) const {
+
+   if ((dir_fd != -1) && (fchdir(dir_fd) == -1)) {
+      child_failure.step = STEP_CHDIR;
+      child_failure.error = errno;
+      return;
+   }
+
+   if (!runActions(child_failure))
+      return;
+
+   // nothing but standard input, output and error gets past
+   // exec, whatever the shell has open. They are only marked, so
+   // the fork method's report pipe still works if exec fails.
+   close_range(3, ~0U, CLOSE_RANGE_CLOEXEC);
+
+   // linux system call to replace process with another process,
+   // the path was already found so there is no PATH to search
+   execve(exec_path, argv, environ);
+
+   // a file without a #! line is run as a script by sh, the same
+   // way execvp() does it
+   if (errno == ENOEXEC) {
+
+      int num_args = 0;
+      while (argv[num_args] != NULL)
+         num_args++;
+
+      // on the stack, the child might share the shell's heap
+      char *sh_argv[num_args + 2];
+      sh_argv[0] = (char *) "sh";
+      sh_argv[1] = (char *) exec_path;
+
+      for (int argCtr = 1; argCtr <= num_args; argCtr++)
+         sh_argv[argCtr + 1] = argv[argCtr];
+
+      execve("/bin/sh", sh_argv, environ);
+      errno = ENOEXEC;
+   }
+
+   // still here, must be an error
+   child_failure.step = STEP_EXEC;
+   child_failure.error = errno;
+}
+
+/******************************************************
+   Does the file actions in order. Only makes system
+   calls, since it runs in the new process too.
+
+   POST: Returns false if an action failed, and then
+         child_failure says which.
+*/
+bool Spawner::runActions(Failure &child_failure) const {
+
+   for (int actionCtr = 0; actionCtr < actions.size(); actionCtr++) {
+
+      const FileAction &action = actions[actionCtr];
+      int result = 0;
+
+      if (action.type == ACTION_OPEN) {
+
+         int file_descriptor = open(action.path, action.flags, action.mode);
+         result = file_descriptor;
+
+         if ((file_descriptor != -1) && (file_descriptor != action.fd)) {
+            result = dup2(file_descriptor, action.fd);
+            close(file_descriptor);
+         }
+
+      } else if (action.type == ACTION_DUP2) {
+
+         // dup2() onto itself does nothing, but it has to keep the
+         // fd open across exec like posix_spawn does
+         if (action.source_fd == action.fd)
+            result = fcntl(action.fd, F_SETFD, 0);
+         else
+            result = dup2(action.source_fd, action.fd);
+
+      } else {
+         close(action.fd);
+      }
+
+      if (result == -1) {
+         child_failure.step = actionCtr;
+         child_failure.error = errno;
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/******************************************************
+   Waits for a child that failed so it doesn't hang
+   around as a zombie.
+
+   POST: Returns pid if nothing failed, otherwise -1.
+*/
+pid_t Spawner::finishSpawn(pid_t pid) {
+
+   if (failure.step == STEP_NONE)
+      return pid;
+
+   waitpid(pid, NULL, 0);
+
+   return -1;
+}
@@ -0,0 +1,282 @@
+/* file: Spawner.h
+
+   Process Spawner Class Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This class is based around starting a new process
+   that runs a command. The caller lists what the new
+   process should do with its file descriptors (open a
+   file onto one, dup2() one onto another, close one)
+   and then spawns it with an argument array. Every
+   place the shell starts a process goes through here.
+
+   There are five ways of starting the process, picked
+   for the whole shell with the "spawn" builtin. vfork
+   is the default, "make bench-spawn" compares them.
+
+      fork          fork() then exec, copies the page
+                    tables of the shell
+      vfork         vfork() then exec, the new process
+                    borrows the memory of the shell
+                    until it execs
+      posix_spawn   posix_spawn() with the file
+                    descriptor work done as file actions
+      clone3        the clone3() system call with
+                    CLONE_VM and CLONE_VFORK, like vfork
+                    but also clears the signal handlers
+                    of the new process
+      helper        a SpawnHelper process forked when
+                    the shell started does the clone3()
+                    and the new process is still a child
+                    of the shell
+
+   Commands are looked up in a PathCache shared by all
+   of the Spawners and exec'd with execve() on their
+   full path. A command that isn't on the PATH never
+   gets a process at all.
+
+   Only standard input, output and error are passed on
+   to the command. Every other fd is closed when it
+   execs, so nothing the shell has open leaks into it.
+
+   A process that can't be started or can't exec tells
+   the shell why, so errors are always printed by the
+   shell and not by a half started child.
+
+   NOTE: posix_spawn only returns the error number, so
+         when a file couldn't be opened it can't say
+         which file it was.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   Spawner()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+
+      POST: There are no file actions.
+
+
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+   void reset()
+   --------------------------------------------------
+      Forgets the file actions so the object can be used
+      for another process. The space for them is kept.
+
+
+   void addOpen(int target_fd, const char *path, int flags, mode_t mode)
+   void addDup2(int source_fd, int target_fd)
+   void addClose(int fd)
+   --------------------------------------------------
+      Add a file action. The new process does them in
+      the order they were added, before it execs.
+
+      PRE:  path has to stay good until spawn() returns.
+
+
+   pid_t spawn(char * const *argv)
+   --------------------------------------------------
+      Starts a new process that does the file actions
+      and execs argv[0], found with the PathCache. If
+      the cached path has gone away the PATH is
+      searched again once.
+
+      PRE:  argv is NULL terminated.
+
+      POST: Returns the process id of the new process.
+            Returns -1 if it couldn't be started, did
+            a file action wrong or couldn't exec. Then
+            the process has already been waited for and
+            printFailure() says what went wrong.
+
+
+   bool execInPlace(char * const *argv)
+   --------------------------------------------------
+      Replaces this process with argv[0] instead of
+      starting a new one. The file actions are done
+      to this process first.
+
+      PRE:  argv is NULL terminated.
+
+      POST: Only returns if something failed. Then the
+            file descriptors are put back the way they
+            were, false is returned, and printFailure()
+            says what went wrong.
+
+
+   bool redirectInPlace()
+   --------------------------------------------------
+      Does the file actions to this process, for good.
+
+      POST: Returns false if an action failed, and then
+            printFailure() says which.
+
+
+   void printFailure() const
+   --------------------------------------------------
+      Prints why the last spawn() failed to standard
+      output.
+
+
+   int getFailureStatus() const
+   --------------------------------------------------
+      Returns the exit status sh would give a command
+      that failed like the last spawn() did: 127 if it
+      wasn't found, 126 if it couldn't be run and 1 for
+      anything else.
+
+
+   static bool setMethod(const string &name)
+   static const char * getMethodName()
+   --------------------------------------------------
+      Set and get the way every Spawner starts
+      processes, by the names listed above.
+
+      POST: setMethod() returns false and changes
+            nothing if the name isn't known or the
+            method isn't supported on this machine.
+
+
+   static bool startHelper()
+   --------------------------------------------------
+      Starts the SpawnHelper process for the helper
+      method. main() calls this before the shell has
+      grown.
+
+      POST: Returns true if the helper is running.
+
+
+   static PathCache & getPathCache()
+   --------------------------------------------------
+      Returns the table of command paths used by every
+      Spawner, for the "hash" builtin.
+
+*/
+
+#ifndef SPAWN_HEADER
+#define SPAWN_HEADER
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "PathCache.h"
+#include "SpawnHelper.h"
+
+using namespace std;
+
+// ways of starting a process
+enum SpawnMethod {
+   SPAWN_FORK,
+   SPAWN_VFORK,
+   SPAWN_POSIX_SPAWN,
+   SPAWN_CLONE3,
+   SPAWN_HELPER
+};
+
+class Spawner {
+
+    public:
+
+         // constructor
+         Spawner();
+
+         // file actions
+         void reset();
+         void addOpen(int target_fd, const char *path, int flags, mode_t mode);
+         void addDup2(int source_fd, int target_fd);
+         void addClose(int fd);
+
+         // starting the process
+         pid_t spawn(char * const *argv);
+         bool execInPlace(char * const *argv);
+         bool redirectInPlace();
+         void printFailure() const;
+         int getFailureStatus() const;
+
+         // picking the method for the whole shell
+         static bool setMethod(const string &name);
+         static const char * getMethodName();
+         static PathCache & getPathCache();
+         static bool startHelper();
+
+    private:
+
+         // builds requests out of the file actions and starts the
+         // processes on the other end
+         friend class SpawnHelper;
+
+         enum ActionType {
+            ACTION_OPEN,
+            ACTION_DUP2,
+            ACTION_CLOSE
+         };
+
+         struct FileAction {
+            ActionType type;
+            int fd;             // fd to open onto, dup2 onto or close
+            int source_fd;      // for ACTION_DUP2
+            const char *path;   // for ACTION_OPEN
+            int flags;
+            mode_t mode;
+         };
+
+         // what went wrong, filled in by the child
+         struct Failure {
+            int step;    // index of the file action, or one of the below
+            int error;   // errno
+         };
+
+         // steps that aren't file actions
+         static const int STEP_NONE = -1;      // nothing failed
+         static const int STEP_CREATE = -2;    // no process
+         static const int STEP_EXEC = -3;      // exec failed
+         static const int STEP_UNKNOWN = -4;   // posix_spawn failed somewhere
+         static const int STEP_CHDIR = -5;     // couldn't go to dir_fd
+
+         pid_t startProcess(char * const *argv);
+
+         // one for each method
+         pid_t spawnFork(char * const *argv);
+         pid_t spawnVfork(char * const *argv);
+         pid_t spawnPosix(char * const *argv);
+         pid_t spawnClone3(char * const *argv);
+         pid_t spawnHelper(char * const *argv);
+
+         // clone3() with the memory shared until exec
+         pid_t cloneChild(char * const *argv, bool sibling);
+
+         // for the helper, a process the shell waits for
+         pid_t spawnSibling(char * const *argv);
+
+         // what the new process does, only returns if it fails
+         void runChild(char * const *argv, Failure &child_failure) const;
+         bool runActions(Failure &child_failure) const;
+
+         pid_t finishSpawn(pid_t pid);
+
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+
+         vector<FileAction> actions;
+         Failure failure;
+
+         // full path of the command being spawned
+         const char *exec_path;
+
+         // directory the new process starts in, -1 for the same
+         // one as this process
+         int dir_fd;
+
+         static SpawnMethod method;
+         static PathCache path_cache;
+         static SpawnHelper helper;
+};
+
+#endif
@@ -0,0 +1,386 @@
+/* file: bench_jobs.cpp
+
+   Background Job Benchmark
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This is a standalone program that times how long it
+   takes the JobManager to notice a background job has
+   finished, while it waits on an idle input the way
+   the shell waits for a line.
+
+   A storm of "sleep" jobs is started, each told to
+   sleep a little longer than the last so they finish
+   one after another over about a second. Each job's
+   run time, from when it was started to the reap, is
+   compared with how long it was told to sleep. The
+   difference is the reap latency plus the time it
+   takes sleep to start up and exit, so that time is
+   measured first with one job at a time to compare.
+
+   The same is done with a few jobs that finish while
+   a foreground "sleep" runs through a ForeJob, which
+   is when the shell isn't waiting on its input at
+   all. Less the time sleep takes, none of them can be
+   reaped more than FOREGROUND_MAX_MS late, or the run
+   fails.
+
+   Then a burst of "true" jobs that all finish at once
+   is started, to time reaping many jobs together.
+
+   Last, the JobTable is filled with 10k, 100k and 1M
+   jobs that are never run, with made up pids, and
+   adding a job, finding one by pid and by number, and
+   removing one are timed at each size. They should
+   cost the same at every size. For comparison, one
+   look through a plain vector of that many jobs is
+   timed too, which is what finding a reaped pid used
+   to cost.
+
+   "bench_jobs N" picks the number of jobs. The
+   results are printed as JSON, and the exit status is
+   1 if the foreground check failed.
+
+*/
+
+#include "CommandList.h"
+#include "JobManager.h"
+#include "JobTable.h"
+#include "ForeJob.h"
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/time.h>
+
+using namespace std;
+
+// how much later than sleep itself a job can be reaped while
+// a foreground command runs
+const double FOREGROUND_MAX_MS = 20;
+
+/******************************************************
+   Returns the current time in nanoseconds.
+*/
+static double nowNs() {
+
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+
+   return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+/******************************************************
+   Parses a line into the Command of its first
+   pipeline.
+
+   POST: Returns false if the line couldn't be parsed.
+*/
+static bool parseJob(const string &line, Command &command) {
+
+   CommandList cmd_list;
+   cmd_list.setCommandText(line);
+
+   if (!cmd_list.parseCommandList()) {
+      fprintf(stderr, "bench_jobs: %s\n", cmd_list.getErrorReason().c_str());
+      return false;
+   }
+
+   command = cmd_list.getPipeline(0).getCommand(0);
+   return true;
+}
+
+/******************************************************
+   Waits on an input nobody writes to until every job
+   has been reaped.
+
+   PRE:  idle_fd is the read end of a pipe that is
+         never written to.
+*/
+static void reapAll(JobManager &jobManager, int idle_fd) {
+
+   while (jobManager.getNumRunning() > 0)
+      jobManager.waitForInput(idle_fd);
+}
+
+/******************************************************
+   Returns the run times of the finished jobs 1 to
+   num_jobs, in seconds, and forgets them.
+*/
+static vector<double> takeRunTimes(JobManager &jobManager, int num_jobs) {
+
+   vector<double> run_times;
+
+   for (int jobCtr = 1; jobCtr <= num_jobs; jobCtr++)
+      run_times.push_back(jobManager.getRunTime(jobCtr));
+
+   jobManager.clearOldJobs();
+
+   return run_times;
+}
+
+/******************************************************
+   Starts jobs that finish one after another while a
+   foreground "sleep 0.4" runs, and prints one JSON
+   line of how late they were reaped, less the time
+   sleep itself takes.
+
+   POST: Returns false if a job was reaped more than
+         FOREGROUND_MAX_MS late.
+*/
+static bool timeForeground(JobManager &jobManager, double overhead) {
+
+   const int num_fore_jobs = 20;
+   Command command;
+   vector<double> sleeps;
+
+   for (int jobCtr = 0; jobCtr < num_fore_jobs; jobCtr++) {
+
+      char line[64];
+      double sleep_time = 0.05 + jobCtr * 0.01;
+      snprintf(line, sizeof(line), "sleep %.4f &", sleep_time);
+
+      if (!parseJob(line, command))
+         return false;
+
+      jobManager.createBackgroundJob(command, 0);
+      sleeps.push_back(sleep_time);
+   }
+
+   Command fore_command;
+   Spawner spawner;
+
+   if (!parseJob("sleep 0.4", fore_command))
+      return false;
+
+   ForeJob fore_job(fore_command, spawner, jobManager);
+   fore_job.execute();
+
+   // every job is done before the foreground one, so they
+   // should all have been reaped by now
+   bool pass = (jobManager.getNumRunning() == 0);
+
+   while (jobManager.getNumRunning() > 0)
+      jobManager.updateJobStatus();
+
+   vector<double> run_times = takeRunTimes(jobManager, num_fore_jobs);
+   double total = 0;
+   double worst = 0;
+
+   for (int jobCtr = 0; jobCtr < num_fore_jobs; jobCtr++) {
+
+      double late_ms = (run_times[jobCtr] - sleeps[jobCtr] - overhead) * 1e3;
+
+      total += late_ms;
+      worst = max(worst, late_ms);
+   }
+
+   if (worst > FOREGROUND_MAX_MS)
+      pass = false;
+
+   printf("  \"foreground\": { \"jobs\": %d, \"mean_late_ms\": %.3f, \"max_late_ms\": %.3f, \"pass\": %s },\n",
+          num_fore_jobs, total / num_fore_jobs, worst, pass ? "true" : "false");
+
+   return pass;
+}
+
+/******************************************************
+   Times a look through a vector of num_jobs jobs for
+   a pid none of them has, the way every reaped pid was
+   looked up before there was a JobTable.
+
+   POST: Returns the time of one look in microseconds.
+*/
+static double scanUs(const Command &command, int num_jobs) {
+
+   vector<BackJob> jobs(num_jobs, BackJob(command));
+   int num_scans = max(10, 10000000 / num_jobs);
+   int found = 0;
+
+   double start_ns = nowNs();
+
+   for (int scanCtr = 0; scanCtr < num_scans; scanCtr++) {
+      for (int jobCtr = 0; jobCtr < jobs.size(); jobCtr++) {
+         if (jobs[jobCtr].getPid() == scanCtr)
+            found++;
+      }
+   }
+
+   double scan_ns = nowNs() - start_ns;
+
+   // so the loop isn't thrown out
+   if (found > 0)
+      printf("found a pid that wasn't there\n");
+
+   return scan_ns / num_scans / 1e3;
+}
+
+/******************************************************
+   Fills a JobTable with num_jobs jobs and times each
+   kind of change and lookup on it, then prints one
+   JSON line of nanoseconds per operation.
+*/
+static void timeTable(const Command &command, int num_jobs) {
+
+   const pid_t first_pid = 100000;
+   const int num_ops = 1000000;
+
+   JobTable table;
+   vector<JobId> ids;
+   ids.reserve(num_jobs);
+
+   double start_ns = nowNs();
+
+   for (int jobCtr = 0; jobCtr < num_jobs; jobCtr++) {
+      JobId id = table.add(BackJob(command));
+      table.indexPid(id, first_pid + jobCtr);
+      ids.push_back(id);
+   }
+
+   double add_ns = (nowNs() - start_ns) / num_jobs;
+
+   // lookups in a random order, so they aren't all in the cache
+   unsigned int seed = 1;
+   long found = 0;
+
+   start_ns = nowNs();
+
+   for (int opCtr = 0; opCtr < num_ops; opCtr++) {
+      seed = seed * 1103515245 + 12345;
+      found += (table.findPid(first_pid + seed % num_jobs) != NO_JOB);
+   }
+
+   double pid_ns = (nowNs() - start_ns) / num_ops;
+
+   start_ns = nowNs();
+
+   for (int opCtr = 0; opCtr < num_ops; opCtr++) {
+      seed = seed * 1103515245 + 12345;
+      found += (table.find(table.findNumber(seed % num_jobs + 1)) != NULL);
+   }
+
+   double number_ns = (nowNs() - start_ns) / num_ops;
+
+   // take out and put back a job, in the middle of the table
+   int num_churn = min(num_ops, num_jobs);
+
+   start_ns = nowNs();
+
+   for (int opCtr = 0; opCtr < num_churn; opCtr++) {
+      seed = seed * 1103515245 + 12345;
+      int slot = seed % num_jobs;
+
+      table.remove(ids[slot]);
+      ids[slot] = table.add(BackJob(command));
+      table.indexPid(ids[slot], first_pid + slot);
+   }
+
+   double churn_ns = (nowNs() - start_ns) / num_churn;
+
+   if (found != 2L * num_ops)
+      printf("lost a job\n");
+
+   printf("    { \"jobs\": %d, \"add_ns\": %.0f, \"find_pid_ns\": %.0f, \"find_number_ns\": %.0f, "
+          "\"remove_add_ns\": %.0f, \"vector_scan_us\": %.1f }",
+          num_jobs, add_ns, pid_ns, number_ns, churn_ns, scanUs(command, num_jobs));
+}
+
+int main(int argc, char *argv[]) {
+
+   int num_jobs = 200;
+   if (argc > 1)
+      num_jobs = atoi(argv[1]);
+
+   // the shell's input, it never has anything to read
+   int idle_pipe[2];
+   if (pipe(idle_pipe) == -1)
+      return 1;
+
+   JobManager jobManager;
+   Command command;
+
+   // how long sleep itself takes to start and exit, the best of 5
+   const double base_sleep = 0.05;
+   double overhead = 1;
+
+   for (int runCtr = 0; runCtr < 5; runCtr++) {
+
+      if (!parseJob("sleep 0.05 &", command))
+         return 1;
+
+      jobManager.createBackgroundJob(command, 0);
+      reapAll(jobManager, idle_pipe[0]);
+
+      overhead = min(overhead, takeRunTimes(jobManager, 1)[0] - base_sleep);
+   }
+
+   // the storm, one job finishing every 1/num_jobs seconds
+   vector<double> sleeps;
+
+   for (int jobCtr = 0; jobCtr < num_jobs; jobCtr++) {
+
+      char line[64];
+      double sleep_time = 0.2 + (double) jobCtr / num_jobs;
+      snprintf(line, sizeof(line), "sleep %.4f &", sleep_time);
+
+      if (!parseJob(line, command))
+         return 1;
+
+      jobManager.createBackgroundJob(command, 0);
+      sleeps.push_back(sleep_time);
+   }
+
+   reapAll(jobManager, idle_pipe[0]);
+   vector<double> run_times = takeRunTimes(jobManager, num_jobs);
+
+   vector<double> latencies;
+   for (int jobCtr = 0; jobCtr < num_jobs; jobCtr++)
+      latencies.push_back((run_times[jobCtr] - sleeps[jobCtr]) * 1e3);
+
+   sort(latencies.begin(), latencies.end());
+
+   double total = 0;
+   for (int jobCtr = 0; jobCtr < num_jobs; jobCtr++)
+      total += latencies[jobCtr];
+
+   printf("{\n  \"jobs\": %d,\n  \"sleep_overhead_ms\": %.3f,\n", num_jobs, overhead * 1e3);
+   printf("  \"staggered\": { \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f },\n",
+          total / num_jobs, latencies[num_jobs / 2], latencies[num_jobs * 99 / 100], latencies[num_jobs - 1]);
+   fflush(stdout);
+
+   bool pass = timeForeground(jobManager, overhead);
+   fflush(stdout);
+
+   // the burst, every job ends as soon as it starts
+   if (!parseJob("true &", command))
+      return 1;
+
+   double start_ns = nowNs();
+
+   for (int jobCtr = 0; jobCtr < num_jobs; jobCtr++)
+      jobManager.createBackgroundJob(command, 0);
+
+   double started_ns = nowNs();
+   reapAll(jobManager, idle_pipe[0]);
+   double reaped_ns = nowNs();
+
+   takeRunTimes(jobManager, num_jobs);
+
+   printf("  \"burst\": { \"start_ms\": %.1f, \"reap_after_start_ms\": %.2f, \"us_per_job\": %.1f },\n",
+          (started_ns - start_ns) / 1e6, (reaped_ns - started_ns) / 1e6, (reaped_ns - start_ns) / 1e3 / num_jobs);
+
+   printf("  \"table\": [\n");
+
+   const int table_sizes[] = { 10000, 100000, 1000000 };
+
+   for (int sizeCtr = 0; sizeCtr < 3; sizeCtr++) {
+
+      fflush(stdout);
+      timeTable(command, table_sizes[sizeCtr]);
+      printf((sizeCtr == 2) ? "\n" : ",\n");
+   }
+
+   printf("  ]\n}\n");
+
+   return pass ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/* file: bench_parallel.cpp
+
+   Parallel Builtin Benchmark
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This is a standalone program that times how many jobs
+   a second the ParallelRunner behind the "parallel"
+   builtin starts and reaps, next to "xargs -P" doing
+   the same work.
+
+   A file of N numbered lines is made first. Then for 1,
+   4 and 16 jobs at a time, every line is run as
+
+      parallel -j P true            xargs -P P -n 1 true
+      parallel -j P -k echo {}      xargs -P P -I{} echo {}
+
+   with the output thrown away. The jobs do next to
+   nothing, so the time is all starting and reaping
+   them. xargs is started the way the shell would start
+   it, and its time includes its own start up, which is
+   the extra process layer the builtin saves.
+
+   Each is run three times and the fastest run is kept.
+   "bench_parallel N" picks the number of lines. The
+   results are printed as JSON.
+
+*/
+
+#include "ParallelRunner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+
+using namespace std;
+
+/******************************************************
+   Returns the current time in nanoseconds.
+*/
+static double nowNs() {
+
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+
+   return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+/******************************************************
+   Runs a template over every line of the list with
+   the ParallelRunner, three times.
+
+   POST: Returns the fastest run in jobs per second, or
+         -1 if a run didn't start every job or failed.
+*/
+static double runnerJobsPerSec(const char *list_path, const vector<string> &command, int max_jobs, bool ordered, int num_lines) {
+
+   ParallelRunner runner;
+   int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+   double best_ns = -1;
+
+   for (int runCtr = 0; runCtr < 3; runCtr++) {
+
+      int list_fd = open(list_path, O_RDONLY | O_CLOEXEC);
+
+      double start_ns = nowNs();
+      int status = runner.run(command, max_jobs, ordered, list_fd, null_fd);
+      double run_ns = nowNs() - start_ns;
+
+      close(list_fd);
+
+      if ((status != 0) || (runner.getNumStarted() != num_lines)) {
+         close(null_fd);
+         return -1;
+      }
+
+      if ((best_ns < 0) || (run_ns < best_ns))
+         best_ns = run_ns;
+   }
+
+   close(null_fd);
+
+   return num_lines / (best_ns / 1e9);
+}
+
+/******************************************************
+   Runs xargs with the arguments in argv on the list,
+   with its output thrown away, three times.
+
+   POST: Returns the fastest run in jobs per second, or
+         -1 if xargs couldn't be run or failed.
+*/
+static double xargsJobsPerSec(const char *list_path, char * const *argv, int num_lines) {
+
+   Spawner spawner;
+   double best_ns = -1;
+
+   for (int runCtr = 0; runCtr < 3; runCtr++) {
+
+      spawner.reset();
+      spawner.addOpen(0, list_path, O_RDONLY, 0);
+      spawner.addOpen(1, "/dev/null", O_WRONLY, 0);
+
+      double start_ns = nowNs();
+      pid_t pid = spawner.spawn(argv);
+
+      if (pid == -1) {
+         spawner.printFailure();
+         return -1;
+      }
+
+      int status;
+      waitpid(pid, &status, 0);
+      double run_ns = nowNs() - start_ns;
+
+      if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+         return -1;
+
+      if ((best_ns < 0) || (run_ns < best_ns))
+         best_ns = run_ns;
+   }
+
+   return num_lines / (best_ns / 1e9);
+}
+
+int main(int argc, char *argv[]) {
+
+   int num_lines = 2000;
+   if (argc > 1)
+      num_lines = atoi(argv[1]);
+
+   // the list of lines, "1" to "N"
+   char list_path[] = "/tmp/bench_parallel_XXXXXX";
+   int list_fd = mkstemp(list_path);
+
+   if (list_fd == -1)
+      return 1;
+
+   FILE *list = fdopen(list_fd, "w");
+   for (int lineCtr = 1; lineCtr <= num_lines; lineCtr++)
+      fprintf(list, "%d\n", lineCtr);
+   fclose(list);
+
+   vector<string> run_true;
+   run_true.push_back("true");
+
+   vector<string> run_echo;
+   run_echo.push_back("echo");
+   run_echo.push_back("{}");
+
+   const int job_counts[] = { 1, 4, 16 };
+   bool pass = true;
+
+   printf("{\n  \"lines\": %d,\n  \"spawn\": \"%s\",\n  \"runs\": [\n", num_lines, Spawner::getMethodName());
+
+   for (int countCtr = 0; countCtr < 3; countCtr++) {
+
+      int max_jobs = job_counts[countCtr];
+      char jobs_text[16];
+      snprintf(jobs_text, sizeof(jobs_text), "%d", max_jobs);
+
+      char *xargs_true[] = { (char *) "xargs", (char *) "-P", jobs_text, (char *) "-n", (char *) "1",
+                             (char *) "true", NULL };
+      char *xargs_echo[] = { (char *) "xargs", (char *) "-P", jobs_text, (char *) "-I{}",
+                             (char *) "echo", (char *) "{}", NULL };
+
+      fflush(stdout);
+
+      double parallel_true = runnerJobsPerSec(list_path, run_true, max_jobs, false, num_lines);
+      double parallel_echo = runnerJobsPerSec(list_path, run_echo, max_jobs, true, num_lines);
+      double xargs_true_rate = xargsJobsPerSec(list_path, xargs_true, num_lines);
+      double xargs_echo_rate = xargsJobsPerSec(list_path, xargs_echo, num_lines);
+
+      if ((parallel_true < 0) || (parallel_echo < 0))
+         pass = false;
+
+      printf("    { \"jobs\": %d, \"parallel_true_per_s\": %.0f, \"xargs_true_per_s\": %.0f, "
+             "\"parallel_k_echo_per_s\": %.0f, \"xargs_echo_per_s\": %.0f }%s\n",
+             max_jobs, parallel_true, xargs_true_rate, parallel_echo, xargs_echo_rate,
+             (countCtr == 2) ? "" : ",");
+   }
+
+   printf("  ],\n  \"pass\": %s\n}\n", pass ? "true" : "false");
+
+   unlink(list_path);
+
+   return pass ? 0 : 1;
+}
@@ -0,0 +1,582 @@
+/* file: bench_parse.cpp
+
+   Parser Benchmark and Fuzzer
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This is a standalone program that runs the command
+   line parsers over a generated corpus of lines:
+
+      short           typical short commands
+      quoted          short commands full of quotes and
+                      escapes
+      argument_heavy  lines with thousands of arguments
+      deep_pipeline   pipelines hundreds of stages long
+      malformed       broken lines: missing quotes,
+                      dangling operators, random bytes
+      pipeline_1mb    one 1 MB pipeline, and one of 2 MB
+      pipeline_2mb    that should take twice as long
+
+   Every line is compiled into a new CommandList, the
+   same thing the plan cache does for a line it hasn't
+   seen. For each part of the corpus it reports lines
+   per second, ns per byte and heap allocations per
+   line. Then it checks that compiling a line into a
+   reused CommandList and getting the exec argument
+   arrays of its commands does no heap allocations at
+   all. The results are printed as JSON and the program
+   exits with status 1 if a check fails.
+
+   "bench_parse --fuzz N [seed]" runs the fuzz entry
+   point on N inputs made by mutating the corpus
+   instead. The entry point can also be linked with
+   libFuzzer by compiling with -DLIBFUZZER, which leaves
+   out main(). "make fuzz-parse" builds it with the
+   address and undefined behavior sanitizers, so a bad
+   read aborts the run.
+
+*/
+
+#include "Command.h"
+#include "PipedCommand.h"
+#include "CommandList.h"
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdint.h>
+#include <sys/time.h>
+
+using namespace std;
+
+// number of times operator new has been called
+static long num_allocs = 0;
+
+void * operator new(size_t size) {
+
+   num_allocs++;
+
+   void *mem = malloc(size ? size : 1);
+   if (mem == NULL)
+      throw bad_alloc();
+
+   return mem;
+}
+
+void operator delete(void *mem) throw() {
+   free(mem);
+}
+
+void operator delete(void *mem, size_t) throw() {
+   free(mem);
+}
+
+/******************************************************
+   Returns the current time in nanoseconds.
+*/
+static double nowNs() {
+
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+
+   return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+/******************************************************
+   Returns a random number from 0 to limit - 1. The
+   corpus is made from a fixed seed, so every run
+   parses the same lines.
+*/
+static int randomBelow(int limit) {
+   return rand() % limit;
+}
+
+/******************************************************
+   Returns one of the words of a NULL terminated list
+   at random.
+*/
+static const char * pickWord(const char * const *words) {
+
+   int num_words = 0;
+   while (words[num_words] != NULL)
+      num_words++;
+
+   return words[randomBelow(num_words)];
+}
+
+static const char * const COMMAND_WORDS[] = {
+   "ls", "cat", "grep", "echo", "sort", "wc", "make", "./wsh", "head", "sed", NULL
+};
+
+static const char * const ARGUMENT_WORDS[] = {
+   "-l", "-a", "-v", "-n", "/usr/bin", "file.txt", "main.cpp", "--color=auto",
+   "log.txt", "wsh", "-r", "42", NULL
+};
+
+static const char * const QUOTED_WORDS[] = {
+   "\"my file.txt\"", "'a|b'", "it\\'s", "\"say \\\"hi\\\"\"", "'$HOME'",
+   "a\\ b", "\"\"", "''", "\"x;y && z\"", NULL
+};
+
+static const char * const BROKEN_PIECES[] = {
+   "\"", "'", "\\", "|", "||", "&&", ";", "&", "<", ">", "< <", "| |",
+   " ", "*", "~", "\"unterminated", "&& ||", "|+", "|+ >", "PARALLEL=2", "PARALLEL=3:ready:1K", "PRIORITY=5", "PRIORITY=x",
+   "PIPESIZE=99999999999999M", "PARALLEL=2:ready:99999999999999K", "& &&", "& ||", NULL
+};
+
+/******************************************************
+   Builds a short command like somebody would type.
+   With quoted set, about half of the arguments are
+   quoted or escaped.
+*/
+static string makeShortLine(bool quoted) {
+
+   string line = pickWord(COMMAND_WORDS);
+
+   int num_args = randomBelow(5);
+   for (int argCtr = 0; argCtr < num_args; argCtr++) {
+      line += ' ';
+      line += (quoted && randomBelow(2)) ? pickWord(QUOTED_WORDS) : pickWord(ARGUMENT_WORDS);
+   }
+
+   // now and then add a redirect, a pipe or a list operator
+   switch (randomBelow(6)) {
+      case 0: line += " > out.txt"; break;
+      case 1: line += " < in.txt"; break;
+      case 2: line += " | wc -l"; break;
+      case 3: line += " && echo done"; break;
+      case 4: line += " &"; break;
+   }
+
+   return line;
+}
+
+/******************************************************
+   Builds a command with num_args arguments.
+*/
+static string makeArgumentLine(int num_args) {
+
+   string line = "echo";
+
+   for (int argCtr = 0; argCtr < num_args; argCtr++) {
+      line += ' ';
+      line += pickWord(ARGUMENT_WORDS);
+   }
+
+   return line + " < input.txt > output.txt";
+}
+
+/******************************************************
+   Builds a pipeline with num_stages stages.
+*/
+static string makePipelineLine(int num_stages) {
+
+   string line = "cat log.txt";
+
+   for (int stageCtr = 1; stageCtr < num_stages; stageCtr++) {
+      line += " | ";
+      line += pickWord(COMMAND_WORDS);
+      line += ' ';
+      line += pickWord(ARGUMENT_WORDS);
+   }
+
+   return line;
+}
+
+/******************************************************
+   Builds a pipeline of about num_bytes chars out of
+   many short stages.
+*/
+static string makeBigPipeline(int num_bytes) {
+
+   string line = "cat log.txt";
+   while (line.size() < num_bytes) {
+      line += " | grep -v debug";
+   }
+
+   return line;
+}
+
+/******************************************************
+   Breaks a line: pieces of shell syntax are put in at
+   random places, chars are replaced with random bytes,
+   or the line is cut short.
+*/
+static string mutateLine(string line) {
+
+   int num_changes = 1 + randomBelow(4);
+
+   for (int changeCtr = 0; changeCtr < num_changes; changeCtr++) {
+
+      int pos = randomBelow(line.size() + 1);
+
+      switch (randomBelow(4)) {
+         case 0:
+            line.insert(pos, pickWord(BROKEN_PIECES));
+            break;
+         case 1:
+            if (pos < line.size())
+               line[pos] = (char) randomBelow(256);
+            break;
+         case 2:
+            line.erase(pos);
+            break;
+         case 3:
+            line.insert(pos, 1, (char) randomBelow(256));
+            break;
+      }
+   }
+
+   return line;
+}
+
+// one named part of the corpus
+struct CorpusPart {
+   const char *name;
+   vector<string> lines;
+   int passes;   // times the lines are parsed, for steadier timing
+};
+
+/******************************************************
+   Builds the whole corpus.
+
+   POST: corpus holds every part, in the order they
+         are reported.
+*/
+static void makeCorpus(vector<CorpusPart> &corpus) {
+
+   srand(342);
+
+   corpus.resize(7);
+
+   corpus[0].name = "short";
+   corpus[0].passes = 20;
+   for (int lineCtr = 0; lineCtr < 2000; lineCtr++)
+      corpus[0].lines.push_back(makeShortLine(false));
+
+   corpus[1].name = "quoted";
+   corpus[1].passes = 20;
+   for (int lineCtr = 0; lineCtr < 2000; lineCtr++)
+      corpus[1].lines.push_back(makeShortLine(true));
+
+   corpus[2].name = "argument_heavy";
+   corpus[2].passes = 5;
+   for (int lineCtr = 0; lineCtr < 50; lineCtr++)
+      corpus[2].lines.push_back(makeArgumentLine(1000 + randomBelow(4000)));
+
+   corpus[3].name = "deep_pipeline";
+   corpus[3].passes = 5;
+   for (int lineCtr = 0; lineCtr < 50; lineCtr++)
+      corpus[3].lines.push_back(makePipelineLine(100 + randomBelow(400)));
+
+   corpus[4].name = "malformed";
+   corpus[4].passes = 20;
+   for (int lineCtr = 0; lineCtr < 2000; lineCtr++)
+      corpus[4].lines.push_back(mutateLine(makeShortLine(randomBelow(2))));
+   corpus[4].lines.push_back("true & && echo hi");
+   corpus[4].lines.push_back("sleep 5 & || echo failed");
+
+   corpus[5].name = "pipeline_1mb";
+   corpus[5].passes = 3;
+   corpus[5].lines.push_back(makeBigPipeline(1 << 20));
+
+   corpus[6].name = "pipeline_2mb";
+   corpus[6].passes = 3;
+   corpus[6].lines.push_back(makeBigPipeline(2 << 20));
+}
+
+/******************************************************
+   Prints text as a JSON string, quotes and all.
+*/
+static void printJsonString(const string &text) {
+
+   putchar('"');
+
+   for (int charCtr = 0; charCtr < text.size(); charCtr++) {
+
+      unsigned char current = text[charCtr];
+
+      if (current == '"' || current == '\\')
+         printf("\\%c", current);
+      else if (current < 0x20 || current >= 0x7f)
+         printf("\\u%04x", current);
+      else
+         putchar(current);
+   }
+
+   putchar('"');
+}
+
+/******************************************************
+   Compiles every line of a part of the corpus into a
+   new CommandList and prints the results.
+
+   POST: One JSON object has been printed, without a
+         comma or newline after it.
+*/
+static void benchPart(const CorpusPart &part) {
+
+   long num_bytes = 0;
+   for (int lineCtr = 0; lineCtr < part.lines.size(); lineCtr++)
+      num_bytes += part.lines[lineCtr].size();
+
+   long num_lines = (long) part.lines.size() * part.passes;
+
+   long start_allocs = num_allocs;
+   double start_ns = nowNs();
+
+   for (int passCtr = 0; passCtr < part.passes; passCtr++) {
+      for (int lineCtr = 0; lineCtr < part.lines.size(); lineCtr++) {
+         CommandList cmd_list;
+         cmd_list.setCommandText(part.lines[lineCtr]);
+         cmd_list.parseCommandList();
+      }
+   }
+
+   double elapsed_ns = nowNs() - start_ns;
+   long allocs = num_allocs - start_allocs;
+
+   printf("    { \"name\": \"%s\", \"lines\": %ld, \"bytes\": %ld, "
+          "\"lines_per_sec\": %.1f, \"ns_per_byte\": %.3f, \"allocs_per_line\": %.3f }",
+          part.name, (long) part.lines.size(), num_bytes,
+          num_lines / (elapsed_ns / 1e9),
+          elapsed_ns / ((double) num_bytes * part.passes),
+          (double) allocs / num_lines);
+}
+
+/******************************************************
+   Compiles line into the same CommandList over and over
+   and gets the argument array of every command, like
+   the shell does on its way to exec.
+
+   PRE:  line parses without errors.
+
+   POST: Prints the result as a JSON object. Returns true
+         if nothing was allocated once the CommandList's
+         buffers had grown big enough.
+*/
+static bool checkHotPath(const string &line) {
+
+   CommandList cmd_list;
+   long allocs = 0;
+   char * const *argv = NULL;
+
+   // first time around is allowed to grow the buffers
+   for (int iterCtr = 0; iterCtr < 1001; iterCtr++) {
+
+      if (iterCtr == 1)
+         allocs = num_allocs;
+
+      cmd_list.setCommandText(line);
+      cmd_list.parseCommandList();
+
+      for (int pipeCtr = 0; pipeCtr < cmd_list.getNumPipelines(); pipeCtr++) {
+
+         const PipedCommand &piped = cmd_list.getPipeline(pipeCtr);
+
+         for (int cmdCtr = 0; cmdCtr < piped.getNumCommands(); cmdCtr++) {
+            argv = piped.getCommand(cmdCtr).getArgsArray();
+         }
+      }
+   }
+
+   allocs = num_allocs - allocs;
+
+   printf("    { \"line\": ");
+   printJsonString(line);
+   printf(", \"argv0\": ");
+   printJsonString(argv[0]);
+   printf(", \"allocs_per_line\": %.3f, \"pass\": %s }",
+          (double) allocs / 1000, (allocs == 0) ? "true" : "false");
+
+   return allocs == 0;
+}
+
+/******************************************************
+   Stops the fuzzer with a message if a check failed.
+   The line is printed in hex so it can be replayed.
+*/
+static void fuzzCheck(bool ok, const char *what, const string &line) {
+
+   if (ok)
+      return;
+
+   fprintf(stderr, "fuzz: %s\n  line: ", what);
+   for (int charCtr = 0; charCtr < line.size(); charCtr++)
+      fprintf(stderr, "%02x", (unsigned char) line[charCtr]);
+   fprintf(stderr, "\n");
+
+   abort();
+}
+
+/******************************************************
+   Checks that the exec argument array of a parsed
+   command has the command name and every argument in
+   order, and ends with NULL. A fan-out file has no
+   command, only its file.
+*/
+static void fuzzCheckCommand(const Command &cmd, const string &line) {
+
+   if (cmd.isFileStage()) {
+      fuzzCheck(cmd.getArgsArray() == NULL, "fan-out file has an argv", line);
+      fuzzCheck(cmd.getOutputFilePath() != NULL, "fan-out file has no path", line);
+      return;
+   }
+
+   char * const *argv = cmd.getArgsArray();
+   fuzzCheck(argv != NULL && argv[0] != NULL, "parsed command has no argv", line);
+
+   fuzzCheck(cmd.getCommandName() == argv[0], "argv[0] is not the command name", line);
+
+   for (int argCtr = 0; argCtr < cmd.getArgCount(); argCtr++)
+      fuzzCheck(cmd.getArg(argCtr) == argv[argCtr + 1], "argv doesn't match the arguments", line);
+
+   fuzzCheck(argv[cmd.getArgCount() + 1] == NULL, "argv doesn't end with NULL", line);
+}
+
+/******************************************************
+   The fuzz entry point. Parses the input with each of
+   the parsers and checks what comes out. A failed
+   check aborts, and so do the sanitizers on bad memory
+   use. It has the libFuzzer signature so it can be
+   linked with libFuzzer as is.
+
+   POST: Returns 0.
+*/
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+
+   string line((const char *) data, size);
+
+   // a lone command
+   Command cmd;
+   cmd.setCommandText(line);
+   if (cmd.parseCommandText())
+      fuzzCheckCommand(cmd, line);
+
+   // a single pipeline
+   PipedCommand piped;
+   piped.setCommandText(line);
+   if (piped.parsePipedCommand()) {
+      for (int cmdCtr = 0; cmdCtr < piped.getNumCommands(); cmdCtr++)
+         fuzzCheckCommand(piped.getCommand(cmdCtr), line);
+   }
+
+   // a command list and its program
+   CommandList cmd_list;
+   cmd_list.setCommandText(line);
+   if (!cmd_list.parseCommandList())
+      return 0;
+
+   const vector<Instruction> &program = cmd_list.getProgram();
+
+   for (int instCtr = 0; instCtr < program.size(); instCtr++) {
+
+      const Instruction &current = program[instCtr];
+
+      if (current.op == OP_JUMP_IF_FAILED || current.op == OP_JUMP_IF_OK)
+         fuzzCheck(current.arg > instCtr && current.arg <= program.size(), "jump goes nowhere", line);
+      else
+         fuzzCheck(current.arg >= 0 && current.arg < cmd_list.getNumPipelines(), "bad pipeline index", line);
+
+      // a '&' ends its and_or, so no '&&' or '||' jump comes after it
+      if ((current.op == OP_RUN_BACKGROUND) && (instCtr + 1 < program.size()))
+         fuzzCheck(program[instCtr + 1].op != OP_JUMP_IF_FAILED && program[instCtr + 1].op != OP_JUMP_IF_OK,
+                   "a background job has a jump after it", line);
+   }
+
+   for (int pipeCtr = 0; pipeCtr < cmd_list.getNumPipelines(); pipeCtr++) {
+
+      const PipedCommand &pipeline = cmd_list.getPipeline(pipeCtr);
+
+      for (int cmdCtr = 0; cmdCtr < pipeline.getNumCommands(); cmdCtr++)
+         fuzzCheckCommand(pipeline.getCommand(cmdCtr), line);
+   }
+
+   return 0;
+}
+
+#ifndef LIBFUZZER
+
+/******************************************************
+   Runs the fuzz entry point on num_inputs lines made by
+   mutating lines of the corpus. Every input is copied
+   into a buffer of its own size, so the sanitizers see
+   any read past its end.
+
+   POST: Returns if nothing went wrong, otherwise the
+         program has aborted.
+*/
+static void runFuzzer(const vector<CorpusPart> &corpus, long num_inputs, int seed) {
+
+   srand(seed);
+
+   // every piece once at the front of a pipeline, where the
+   // PIPESIZE= and PARALLEL= words are read
+   for (int pieceCtr = 0; BROKEN_PIECES[pieceCtr] != NULL; pieceCtr++) {
+
+      string line = string(BROKEN_PIECES[pieceCtr]) + " cat log.txt | wc -l";
+      LLVMFuzzerTestOneInput((const uint8_t *) line.data(), line.size());
+   }
+
+   // only the small parts, the big pipelines would take forever
+   const int num_parts = 5;
+
+   for (long inputCtr = 0; inputCtr < num_inputs; inputCtr++) {
+
+      const CorpusPart &part = corpus[randomBelow(num_parts)];
+      string line = mutateLine(part.lines[randomBelow(part.lines.size())]);
+
+      uint8_t *data = (uint8_t *) malloc(line.size() ? line.size() : 1);
+      memcpy(data, line.data(), line.size());
+
+      LLVMFuzzerTestOneInput(data, line.size());
+
+      free(data);
+   }
+
+   printf("{ \"fuzz_inputs\": %ld, \"seed\": %d, \"pass\": true }\n", num_inputs, seed);
+}
+
+int main(int argc, char *argv[]) {
+
+   vector<CorpusPart> corpus;
+   makeCorpus(corpus);
+
+   if (argc >= 3 && string(argv[1]) == "--fuzz") {
+      runFuzzer(corpus, atol(argv[2]), (argc >= 4) ? atoi(argv[3]) : 1);
+      return 0;
+   }
+
+   printf("{\n  \"corpus\": [\n");
+
+   for (int partCtr = 0; partCtr < corpus.size(); partCtr++) {
+      benchPart(corpus[partCtr]);
+      printf(partCtr + 1 < corpus.size() ? ",\n" : "\n");
+   }
+
+   printf("  ],\n  \"hot_path\": [\n");
+
+   const char *hot_lines[] = {
+      "ls -l -a /usr/bin > listing.txt &",
+      "ls -l /usr/bin | grep wsh | sort -r | wc -l",
+      "grep -e 'a|b' \"my file\" | sed s/x/\\ y/",
+      "make && ./wsh || echo failed ; sleep 5 & ls | wc"
+   };
+   const int num_hot_lines = 4;
+
+   bool no_allocs = true;
+
+   for (int lineCtr = 0; lineCtr < num_hot_lines; lineCtr++) {
+      no_allocs = checkHotPath(hot_lines[lineCtr]) && no_allocs;
+      printf(lineCtr + 1 < num_hot_lines ? ",\n" : "\n");
+   }
+
+   printf("  ],\n  \"pass\": %s\n}\n", no_allocs ? "true" : "false");
+
+   if (!no_allocs)
+      return 1;
+
+   return 0;
+}
+
+#endif
@@ -0,0 +1,199 @@
+/* file: bench_pipe.cpp
+
+   Pipeline Benchmark
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This is a standalone program that times how long the
+   PipeManager takes to run "true | cat | ... | cat"
+   as the number of stages grows. Setting up a stage
+   should cost the same however long the pipeline is,
+   so the time per stage should stay flat. A pipeline
+   that closed every pipe in every child would show it
+   growing with the length instead.
+
+   Each pipeline is run three times and the fastest
+   run is kept. The results are printed as JSON.
+
+   "bench_pipe N N ..." picks the numbers of stages.
+
+   After that, 1 GB is pushed through a two stage dd
+   pipeline with each pipe size ("PIPESIZE=" word) to
+   show what bigger pipes are worth in MB/s. Last, 1 GB
+   is sent to a file and a second dd, once through a
+   tee process and once with the shell's "|+" fan-out.
+   Then "gzip -6" is run over 3 million lines as a
+   PARALLEL= stage of 1, 2, 4 and 8 copies, which should
+   speed up with the number of cores.
+
+*/
+
+#include "CommandList.h"
+#include "PipeManager.h"
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/time.h>
+
+using namespace std;
+
+/******************************************************
+   Returns the current time in nanoseconds.
+*/
+static double nowNs() {
+
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+
+   return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+/******************************************************
+   Parses a line and runs its first pipeline three
+   times.
+
+   POST: Returns the fastest run in nanoseconds, or -1
+         if the line couldn't be parsed.
+*/
+static double bestRunNs(PipeManager &pipeManager, const string &line) {
+
+   CommandList cmd_list;
+   cmd_list.setCommandText(line);
+
+   if (!cmd_list.parseCommandList()) {
+      fprintf(stderr, "bench_pipe: %s\n", cmd_list.getErrorReason().c_str());
+      return -1;
+   }
+
+   double best_ns = -1;
+
+   for (int runCtr = 0; runCtr < 3; runCtr++) {
+
+      double start_ns = nowNs();
+      pipeManager.execute(cmd_list.getPipeline(0));
+      double run_ns = nowNs() - start_ns;
+
+      if ((best_ns < 0) || (run_ns < best_ns))
+         best_ns = run_ns;
+   }
+
+   return best_ns;
+}
+
+int main(int argc, char *argv[]) {
+
+   vector<int> sizes;
+   for (int argCtr = 1; argCtr < argc; argCtr++)
+      sizes.push_back(atoi(argv[argCtr]));
+
+   if (sizes.empty()) {
+      sizes.push_back(10);
+      sizes.push_back(50);
+      sizes.push_back(100);
+      sizes.push_back(250);
+      sizes.push_back(500);
+      sizes.push_back(1000);
+   }
+
+   PipeManager pipeManager;
+
+   printf("{\n  \"results\": [\n");
+
+   for (int sizeCtr = 0; sizeCtr < sizes.size(); sizeCtr++) {
+
+      int num_stages = sizes[sizeCtr];
+
+      string line = "true";
+      for (int stageCtr = 1; stageCtr < num_stages; stageCtr++)
+         line += " | cat";
+
+      double best_ns = bestRunNs(pipeManager, line);
+
+      if (best_ns < 0)
+         return 1;
+
+      printf("    { \"stages\": %d, \"ms\": %.2f, \"us_per_stage\": %.1f, \"exit_status\": %d }",
+             num_stages, best_ns / 1e6, best_ns / 1e3 / num_stages, pipeManager.getExitStatus());
+
+      printf((sizeCtr + 1 == sizes.size()) ? "\n" : ",\n");
+      fflush(stdout);
+   }
+
+   printf("  ],\n  \"throughput\": [\n");
+
+   const char *pipe_sizes[] = { "default", "256K", "1M", "adaptive" };
+   const int num_pipe_sizes = 4;
+   const double num_mb = 1024;
+
+   for (int sizeCtr = 0; sizeCtr < num_pipe_sizes; sizeCtr++) {
+
+      string line = string("PIPESIZE=") + pipe_sizes[sizeCtr]
+                    + " dd if=/dev/zero bs=1M count=1024 status=none | dd of=/dev/null bs=1M status=none";
+
+      double best_ns = bestRunNs(pipeManager, line);
+
+      if (best_ns < 0)
+         return 1;
+
+      printf("    { \"pipe_size\": \"%s\", \"ms\": %.1f, \"mb_per_s\": %.0f, \"exit_status\": %d }",
+             pipe_sizes[sizeCtr], best_ns / 1e6, num_mb / (best_ns / 1e9), pipeManager.getExitStatus());
+
+      printf((sizeCtr + 1 == num_pipe_sizes) ? "\n" : ",\n");
+      fflush(stdout);
+   }
+
+   printf("  ],\n  \"fan_out\": [\n");
+
+   const char *fan_out_names[] = { "tee_process", "shell_fan_out" };
+   const char *fan_out_lines[] = {
+      "dd if=/dev/zero bs=1M count=1024 status=none | tee /dev/null | dd of=/dev/null bs=1M status=none",
+      "dd if=/dev/zero bs=1M count=1024 status=none |+ > /dev/null |+ dd of=/dev/null bs=1M status=none"
+   };
+   const int num_fan_outs = 2;
+
+   for (int fanCtr = 0; fanCtr < num_fan_outs; fanCtr++) {
+
+      double best_ns = bestRunNs(pipeManager, fan_out_lines[fanCtr]);
+
+      if (best_ns < 0)
+         return 1;
+
+      printf("    { \"case\": \"%s\", \"ms\": %.1f, \"mb_per_s\": %.0f, \"exit_status\": %d }",
+             fan_out_names[fanCtr], best_ns / 1e6, num_mb / (best_ns / 1e9), pipeManager.getExitStatus());
+
+      printf((fanCtr + 1 == num_fan_outs) ? "\n" : ",\n");
+      fflush(stdout);
+   }
+
+   printf("  ],\n  \"parallel\": [\n");
+
+   const int copy_counts[] = { 1, 2, 4, 8 };
+   const int num_copy_counts = 4;
+   double one_copy_ns = -1;
+
+   for (int countCtr = 0; countCtr < num_copy_counts; countCtr++) {
+
+      char line[128];
+      snprintf(line, sizeof(line), "seq 1 3000000 | PARALLEL=%d gzip -6 | dd of=/dev/null status=none",
+               copy_counts[countCtr]);
+
+      double best_ns = bestRunNs(pipeManager, line);
+
+      if (best_ns < 0)
+         return 1;
+
+      if (countCtr == 0)
+         one_copy_ns = best_ns;
+
+      printf("    { \"copies\": %d, \"ms\": %.1f, \"speedup\": %.2f, \"exit_status\": %d }",
+             copy_counts[countCtr], best_ns / 1e6, one_copy_ns / best_ns, pipeManager.getExitStatus());
+
+      printf((countCtr + 1 == num_copy_counts) ? "\n" : ",\n");
+      fflush(stdout);
+   }
+
+   printf("  ]\n}\n");
+
+   return 0;
+}
@@ -0,0 +1,169 @@
+/* file: bench_spawn.cpp
+
+   Spawn Benchmark
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This is a standalone program that times how fast
+   each Spawner method can start and wait for /bin/true
+   while the process doing the spawning gets bigger.
+   fork() has to copy the page tables of the whole
+   process, so it slows down as the resident memory
+   grows, while the others don't have to. The helper
+   method is forked before any memory is grown, so its
+   cost shouldn't move at all.
+
+   Memory is grown in steps by allocating it and
+   writing to every page so it is really resident. At
+   each step every method spawns for about half a
+   second. The results are printed as JSON.
+
+   "bench_spawn MB MB ..." picks the sizes to test.
+
+*/
+
+#include "Spawner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+/******************************************************
+   Returns the current time in nanoseconds.
+*/
+static double nowNs() {
+
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+
+   return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+/******************************************************
+   Returns the resident memory of this process in MB,
+   read from /proc/self/statm.
+*/
+static long residentMb() {
+
+   long total_pages = 0;
+   long resident_pages = 0;
+
+   FILE *statm = fopen("/proc/self/statm", "r");
+   if (statm == NULL)
+      return -1;
+
+   if (fscanf(statm, "%ld %ld", &total_pages, &resident_pages) != 2)
+      resident_pages = -1;
+
+   fclose(statm);
+
+   return resident_pages * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+/******************************************************
+   Spawns /bin/true and waits for it over and over for
+   about half a second.
+
+   PRE:  method is a name Spawner::setMethod() knows.
+
+   POST: Returns the spawns per second, or -1 if the
+         method can't be used here or a spawn failed.
+*/
+static double spawnRate(const char *method) {
+
+   if (!Spawner::setMethod(method))
+      return -1;
+
+   char true_path[] = "/bin/true";
+   char *argv[] = { true_path, NULL };
+
+   Spawner spawner;
+   long num_spawns = 0;
+   double start_ns = nowNs();
+   double elapsed_ns = 0;
+
+   while (elapsed_ns < 0.5e9) {
+
+      pid_t pid = spawner.spawn(argv);
+      if (pid == -1) {
+         spawner.printFailure();
+         return -1;
+      }
+
+      waitpid(pid, NULL, 0);
+
+      num_spawns++;
+      elapsed_ns = nowNs() - start_ns;
+   }
+
+   return num_spawns / (elapsed_ns / 1e9);
+}
+
+int main(int argc, char *argv[]) {
+
+   const char *methods[] = { "fork", "vfork", "posix_spawn", "clone3", "helper" };
+   const int num_methods = 5;
+
+   // forked while this process is still small, like wsh does
+   Spawner::startHelper();
+
+   // sizes in MB to grow the process to
+   vector<long> sizes;
+   for (int argCtr = 1; argCtr < argc; argCtr++)
+      sizes.push_back(atol(argv[argCtr]));
+
+   if (sizes.empty()) {
+      sizes.push_back(0);
+      sizes.push_back(64);
+      sizes.push_back(256);
+      sizes.push_back(1024);
+   }
+
+   // the memory is never freed, each step adds to the last one
+   long allocated_mb = 0;
+
+   printf("{\n  \"results\": [\n");
+
+   for (int sizeCtr = 0; sizeCtr < sizes.size(); sizeCtr++) {
+
+      if (sizes[sizeCtr] > allocated_mb) {
+
+         size_t num_bytes = (size_t) (sizes[sizeCtr] - allocated_mb) * 1024 * 1024;
+         char *memory = (char *) malloc(num_bytes);
+
+         if (memory == NULL) {
+            fprintf(stderr, "bench_spawn: could not allocate %ld MB\n", sizes[sizeCtr]);
+            return 1;
+         }
+
+         memset(memory, 1, num_bytes);
+         allocated_mb = sizes[sizeCtr];
+      }
+
+      long resident = residentMb();
+
+      for (int methodCtr = 0; methodCtr < num_methods; methodCtr++) {
+
+         double rate = spawnRate(methods[methodCtr]);
+
+         printf("    { \"rss_mb\": %ld, \"method\": \"%s\", ", resident, methods[methodCtr]);
+
+         if (rate < 0)
+            printf("\"spawns_per_sec\": null }");
+         else
+            printf("\"spawns_per_sec\": %.1f }", rate);
+
+         bool last = (sizeCtr + 1 == sizes.size()) && (methodCtr + 1 == num_methods);
+         printf(last ? "\n" : ",\n");
+         fflush(stdout);
+      }
+   }
+
+   printf("  ]\n}\n");
+
+   return 0;
+}
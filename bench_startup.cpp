@@ -0,0 +1,156 @@
+/* file: bench_startup.cpp
+
+   Startup Benchmark
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+
+   This is a standalone program that times how long
+   wsh takes from being started to running its first
+   command. Each case runs /bin/true over and over for
+   about half a second:
+
+      direct        /bin/true with no shell at all
+      wsh_c         wsh -c /bin/true
+      wsh_script    wsh script.wsh, the script holding
+                    the one line /bin/true
+      wsh_stdin     the same script on standard input,
+                    the way wsh was run before it had
+                    a quiet mode
+
+   The time each run takes over the direct one is what
+   wsh costs before the command is exec'd. The results
+   are printed as JSON.
+
+   "bench_startup path/to/wsh" picks the shell to time,
+   it is ./wsh by default.
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+extern char **environ;
+
+/******************************************************
+   Returns the current time in nanoseconds.
+*/
+static double nowNs() {
+
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+
+   return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+/******************************************************
+   Runs argv over and over for about half a second with
+   its output thrown away.
+
+   PRE:  argv is NULL terminated. stdin_path is a file
+         for standard input, or NULL to leave it alone.
+
+   POST: Returns the microseconds each run took, or -1
+         if a run failed.
+*/
+static double runTime(char * const *argv, const char *stdin_path) {
+
+   posix_spawn_file_actions_t file_actions;
+   posix_spawn_file_actions_init(&file_actions);
+   posix_spawn_file_actions_addopen(&file_actions, 1, "/dev/null", O_WRONLY, 0);
+
+   if (stdin_path != NULL)
+      posix_spawn_file_actions_addopen(&file_actions, 0, stdin_path, O_RDONLY, 0);
+
+   long num_runs = 0;
+   double start_ns = nowNs();
+   double elapsed_ns = 0;
+
+   while (elapsed_ns < 0.5e9) {
+
+      pid_t pid;
+      int status;
+
+      if ((posix_spawn(&pid, argv[0], &file_actions, NULL, argv, environ) != 0)
+          || (waitpid(pid, &status, 0) == -1) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+         posix_spawn_file_actions_destroy(&file_actions);
+         return -1;
+      }
+
+      num_runs++;
+      elapsed_ns = nowNs() - start_ns;
+   }
+
+   posix_spawn_file_actions_destroy(&file_actions);
+
+   return elapsed_ns / num_runs / 1e3;
+}
+
+int main(int argc, char *argv[]) {
+
+   char *wsh_path = (char *) "./wsh";
+
+   if (argc > 1)
+      wsh_path = argv[1];
+
+   // the script every wsh case runs
+   char script_path[] = "/tmp/bench_startup_XXXXXX";
+   int script_fd = mkstemp(script_path);
+
+   if ((script_fd == -1) || (write(script_fd, "/bin/true\n", 10) != 10)) {
+      fprintf(stderr, "bench_startup: could not write the script\n");
+      return 1;
+   }
+
+   close(script_fd);
+
+   char true_path[] = "/bin/true";
+   char dash_c[] = "-c";
+
+   char *direct_argv[] = { true_path, NULL };
+   char *wsh_c_argv[] = { wsh_path, dash_c, true_path, NULL };
+   char *wsh_script_argv[] = { wsh_path, script_path, NULL };
+   char *wsh_stdin_argv[] = { wsh_path, NULL };
+
+   const char *names[] = { "direct", "wsh_c", "wsh_script", "wsh_stdin" };
+   char * const *argvs[] = { direct_argv, wsh_c_argv, wsh_script_argv, wsh_stdin_argv };
+   const char *stdin_paths[] = { NULL, NULL, NULL, script_path };
+   const int num_cases = 4;
+
+   double direct_us = -1;
+
+   printf("{\n  \"results\": [\n");
+
+   for (int caseCtr = 0; caseCtr < num_cases; caseCtr++) {
+
+      double run_us = runTime(argvs[caseCtr], stdin_paths[caseCtr]);
+
+      if (caseCtr == 0)
+         direct_us = run_us;
+
+      printf("    { \"case\": \"%s\", ", names[caseCtr]);
+
+      if (run_us < 0)
+         printf("\"us_per_run\": null, \"startup_us\": null }");
+      else if (direct_us < 0)
+         printf("\"us_per_run\": %.1f, \"startup_us\": null }", run_us);
+      else
+         printf("\"us_per_run\": %.1f, \"startup_us\": %.1f }", run_us, run_us - direct_us);
+
+      printf((caseCtr + 1 == num_cases) ? "\n" : ",\n");
+      fflush(stdout);
+   }
+
+   printf("  ]\n}\n");
+
+   unlink(script_path);
+
+   return 0;
+}
@@ -1,25 +1,103 @@
-/* file: main.cpp
-   
-   Startup File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This is the entry point for the program that creates
-   a new shell object and then starts the control loop.
-   
-*/
-
-
-#include "wimpyshell.h"
-#include <iostream>
-
-using namespace std;
-
-int main() {
-   
-   WimpyShell newShell;
-   newShell.startShell();
-   
-   return 0;
-}
+/* file: main.cpp
+   
+   Startup File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This is the entry point for the program that creates
+   a new shell object and then starts the control loop.
+   
+      wsh               reads commands from standard
+                        input, with a prompt if it is a
+                        terminal
+      wsh -c 'line'     runs one command line quietly
+      wsh script.wsh    runs a script file quietly
+   
+   The quiet modes don't print anything but errors and
+   don't start the spawn helper, so the time from
+   starting wsh to its first exec stays small. "make
+   bench-startup" measures it.
+   
+   When built with COUNT_ALLOCS defined (make wsh-allocs),
+   every call to operator new is counted so the shell can
+   report how many allocations each command line took.
+   
+*/
+
+
+#include "wimpyshell.h"
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+
+#ifdef COUNT_ALLOCS
+#include <cstdlib>
+#include <new>
+#endif
+
+using namespace std;
+
+#ifdef COUNT_ALLOCS
+
+// number of times operator new has been called, read by WimpyShell
+long wsh_num_allocs = 0;
+
+void * operator new(size_t size) {
+   
+   wsh_num_allocs++;
+   
+   void *mem = malloc(size ? size : 1);
+   if (mem == NULL)
+      throw bad_alloc();
+   
+   return mem;
+}
+
+void operator delete(void *mem) throw() {
+   free(mem);
+}
+
+void operator delete(void *mem, size_t) throw() {
+   free(mem);
+}
+
+#endif
+
+int main(int argc, char *argv[]) {
+   
+   // a command line
+   if ((argc == 3) && (strcmp(argv[1], "-c") == 0)) {
+      WimpyShell newShell;
+      return newShell.runString(argv[2]);
+   }
+   
+   // a script file
+   if ((argc == 2) && (argv[1][0] != '-')) {
+      
+      int script_fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+      
+      if (script_fd == -1) {
+         cout << "Could not open script:" << endl;
+         cout << "  " << strerror(errno) << "." << endl;
+         return 127;
+      }
+      
+      WimpyShell newShell;
+      return newShell.runScript(script_fd);
+   }
+   
+   if (argc != 1) {
+      cout << "Usage: wsh [-c command | script]" << endl;
+      return 2;
+   }
+   
+   // the helper is forked before the shell grows at all, if it
+   // can't start the "helper" spawn method just isn't there
+   Spawner::startHelper();
+   
+   WimpyShell newShell;
+   newShell.startShell();
+   
+   return 0;
+}
@@ -1,247 +1,853 @@
-/* file: wimpyshell.cpp
-   
-   Shell Implementation File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class represents the entire Wimpy Shell. An
-   instance of this class is essentially an entire
-   shell. It's only public method is to start the main
-   control loop of the shell.
-   
-   NOTE: There is a maximum limit on the number of
-         characters that are supported for the current
-         working directory (CWD). Extremely nested
-         folders will probably break this shell.
-   
-*/
-
-#include "wimpyshell.h"
-
-using namespace std;
-
-/******************************************************
-   This is the basic constructor for the class.
-   
-   POST: The object is initialized.
-*/
-WimpyShell::WimpyShell() {
-
-   // nothing to initialize, really
-}
-
-/******************************************************
-   This starts the main control loop for Wimpy Shell.
-   
-   POST: Wimpy Shell is now running until the user
-         decides to quit the program.
-*/
-void WimpyShell::startShell() {
-   
-   cout << "Welcome to Wimpy Shell v1.0" << endl;
-   
-   // main control loop
-   while (!cin.eof()) {
-      
-      currentCmdLine.resetCommand();
-      
-      // command line prompt
-      cout << "wsh: ";
-      
-      // get a command line from the user
-      string userInputString;
-      getline(cin, userInputString);
-      currentCmdLine.setCommandText(userInputString);
-      
-      // update status of jobs before starting another one
-      jobManager.updateJobStatus();
-      
-      // check for piping, must process differently
-      PipedCommand pipedCmdLine;
-      pipedCmdLine.setCommandText(currentCmdLine.getCommandText());
-      
-      if (pipedCmdLine.checkForPiping()) { // piped command
-         
-         if (!pipedCmdLine.parsePipedCommand()) {
-            cout << "Command could not be parsed: " << endl;
-            cout << "  " << pipedCmdLine.getErrorReason() << endl;
-         } else {
-            PipeManager pipeManager(pipedCmdLine);
-            pipeManager.execute();
-         }
-         
-      } else { // normal command
-       
-         // parse and check for errors
-         if (!currentCmdLine.parseCommandText()) {
-            
-            if (!(currentCmdLine.getErrorReason() == "Empty command.")) {
-               cout << "Command could not be parsed: " << endl;
-               cout << "  " << currentCmdLine.getErrorReason() << endl;
-            }
-            
-         } else { // parsed correctly
-            
-            // try to run builtin commands
-            if(!runBuiltinCommands()) {
-               
-               // not a builtin, run background or foreground job
-               if (currentCmdLine.isBackgroundJob()) {
-                  jobManager.createBackgroundJob(currentCmdLine);
-               } else {
-                  ForeJob run_me(currentCmdLine);
-                  run_me.execute();
-               } 
-            }
-            
-         }
-         
-      }
-      
-      // update jobs again and print
-      jobManager.updateJobStatus();
-      jobManager.printJobs();
-      jobManager.clearOldJobs();
-      
-   } // end of main while
-   
-   currentCmdLine.resetCommand();
-}
-
-/******************************************************
-   Checks the current command to see if it should be
-   handled as a builtin command by the shell. If it
-   is, the command is executed.
-   
-   POST: Returns true if the current command is a
-         builtin, regardless of if it executes
-         successfully. Returns false if the current
-         command is not a builtin command.
-*/
-bool WimpyShell::runBuiltinCommands() {
-   
-   // end the shell
-   if (currentCmdLine.getCommandName() == "exit") {
-      exit(0);
-   }
-   
-   // change directory
-   if (currentCmdLine.getCommandName() == "cd") {
-      runChangeDir();
-      return true;
-   }
-   
-   // wait for background process
-   if (currentCmdLine.getCommandName() == "wait") {
-      runWait();
-      return true;
-   }
-   
-   // personal vanity
-   if (currentCmdLine.getCommandName() == "aboutwsh") {
-      runAboutwsh();
-      return true;
-   } 
-   
-   return false;
-}
-
-/******************************************************
-   Tries to change the current working directory of
-   wimpy shell to the first argument of the cd command.
-   The current working directory is then printed to
-   standard output.
-   
-   PRE:  currentCmdLine must be a change directory
-         "cd" command.
-   
-   POST: Returns after an attempt is made to change the
-         CWD and the CWD is printed to stdout. If an
-         error was encountered an error message is printed
-         and the CWD remains the same.
-*/
-void WimpyShell::runChangeDir() {
-   
-   // check to make sure an argument exists, segmentation faults BAD!!!
-   if (currentCmdLine.getArgs().empty()) {
-      
-      cout << "Could not change directory:" << endl;
-      cout << "  No directory given." << endl;
-      
-   // otherwise try to change directory
-   } else {
-    
-      // linux system call
-      int change_success = chdir(currentCmdLine.getArgs()[0].c_str());
-      
-      if (change_success == -1) {
-         cout << "Could not change directory:" << endl;
-         
-         if (errno == 2) { // file not found
-            cout << "  No such directory." << endl;
-         } else {
-            cout << "  " << strerror(errno) << "." << endl;
-         }
-      } 
-      
-   }
-   
-   // create array to store address
-   char *cwd_ptr = NULL;
-   cwd_ptr = new char [MAX_CWD_SIZE];
-
-   // linux system call
-   getcwd(cwd_ptr, MAX_CWD_SIZE);
-   
-   // convert cstring to string and print
-   string cwd = static_cast<const char*>(cwd_ptr);
-   cout << "Working directory " << cwd << endl;
-   
-   delete [] cwd_ptr;
-   cwd_ptr = NULL;
-}
-
-/******************************************************
-   Tries to wait for the background job specified
-   in the command arguments to finished executing.
-   
-   PRE:  currentCmdLine must be a "wait" command.
-   
-   POST: Returns after an attempt is made to wait for
-         the process specified in the first argument
-         of currentCmdLine.
-*/
-void WimpyShell::runWait() {
-      
-   // check for an argument
-   if (currentCmdLine.getArgs().size() == 0) {
-      cout << "Could not wait for job:" << endl;
-      cout << "  No job number given." << endl;
-   
-   // try to wait for the job
-   } else {
-      int job_num = atoi(currentCmdLine.getArgs()[0].c_str());
-      jobManager.waitForJob(job_num);
-   }
-}
-
-/******************************************************
-   Prints my ode to personal vanity to standard output.
-   
-   PRE:  currentCmdLine must be the about Wimpy Shell
-         "aboutwsh" command.
-   
-   POST: Returns after the logo and info has been printed.
-*/
-void WimpyShell::runAboutwsh() {
-   
-   cout << " _      _                                  ___" << endl;
-   cout << "  |  |  /    ,                            /    )   /           /   /" << endl;
-   cout << "  | /| /        _  _      __              \\       /__    __   /   /" << endl;
-   cout << "  |/ |/    /   / /  )   /   ) /   /        \\     /   ) /___) /   /" << endl;
-   cout << "__/  |____/___/ /  /___/___/_(___/_____(____/___/   /_(___ _/___/___" << endl;
-   cout << "                      /         /" << endl;
-   cout << "                     /      (_ /" << endl << endl;
-   cout << "Wimpy Shell was written by Shea Daniels in 2006." << endl << endl;
-}
+/* file: wimpyshell.cpp
+   
+   Shell Implementation File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class represents the entire Wimpy Shell. An
+   instance of this class is essentially an entire
+   shell. Its public methods start the main control
+   loop of the shell, either for somebody typing at it
+   or quietly for a script or a "-c" command line.
+   
+   NOTE: There is a maximum limit on the number of
+         characters that are supported for the current
+         working directory (CWD). Extremely nested
+         folders will probably break this shell.
+   
+*/
+
+#include "wimpyshell.h"
+
+using namespace std;
+
+#ifdef COUNT_ALLOCS
+// allocation counter from main.cpp
+extern long wsh_num_allocs;
+#endif
+
+/******************************************************
+   This is the basic constructor for the class.
+   
+   POST: The object is initialized.
+*/
+WimpyShell::WimpyShell() {
+
+   last_status = 0;
+   clear_plans = false;
+   quiet = false;
+   
+   // pipelines and "parallel" reap the background jobs while they run
+   pipeManager.setJobManager(&jobManager);
+   parallelRunner.setJobManager(&jobManager);
+}
+
+/******************************************************
+   This starts the main control loop for Wimpy Shell.
+   
+   POST: Wimpy Shell is now running until the user
+         decides to quit the program.
+*/
+void WimpyShell::startShell() {
+   
+   cout << "Welcome to Wimpy Shell v1.0" << endl;
+   
+   // read straight from standard input, only prompting
+   // when somebody is typing the lines
+   lineReader.openInput(STDIN_FILENO);
+   runLines();
+}
+
+/******************************************************
+   Runs every line of a script file, quietly.
+   
+   PRE:  script_fd is open for reading.
+   
+   POST: Returns the exit status of the last command.
+*/
+int WimpyShell::runScript(int script_fd) {
+   
+   quiet = true;
+   lineReader.openInput(script_fd);
+   runLines();
+   
+   return last_status;
+}
+
+/******************************************************
+   Runs every line of a string, quietly.
+   
+   PRE:  text is null terminated.
+   
+   POST: Returns the exit status of the last command.
+*/
+int WimpyShell::runString(const char *text) {
+   
+   quiet = true;
+   lineReader.openString(text, strlen(text));
+   runLines();
+   
+   return last_status;
+}
+
+/******************************************************
+   The main control loop: reads each line from the line
+   reader and runs it. Unless the shell is quiet, a
+   prompt is printed for a terminal and background jobs
+   are reported after each line.
+   
+   PRE:  The line reader has its input.
+   
+   POST: Every line has been run.
+*/
+void WimpyShell::runLines() {
+   
+   // main control loop
+   while (true) {
+      
+#ifdef COUNT_ALLOCS
+      long start_allocs = wsh_num_allocs;
+#endif
+      
+      currentCmdLine.resetCommand();
+      
+      // command line prompt
+      if (!quiet && lineReader.isInteractive())
+         cout << "wsh: " << flush;
+      
+      if (!quiet)
+         waitForLine();
+      
+      // get a command line, it isn't copied unless the plan
+      // cache hasn't seen it before
+      LineView inputLine;
+      
+      if (!lineReader.nextLine(inputLine))
+         break;
+      
+      // update status of jobs before starting another one
+      jobManager.updateJobStatus();
+      
+      // commands could have been added to the PATH since the
+      // last line
+      Spawner::getPathCache().recheckDirs();
+      
+      // get the compiled line from the plan cache, the line is
+      // only parsed (in one pass, lists and pipes and all) the
+      // first time
+      LaunchPlan &plan = planCache.getPlan(inputLine);
+      CommandList &cmdList = plan.cmd_list;
+      
+      if (!plan.parsed) { // check for errors
+         
+         if (!(cmdList.getErrorReason() == "Empty command.")) {
+            cout << "Command could not be parsed: " << endl;
+            cout << "  " << cmdList.getErrorReason() << endl;
+         }
+         
+      } else { // parsed correctly
+         
+         printWarnings(cmdList);
+         runCommandList(cmdList);
+      }
+      
+      // "plancache clear" has to wait until the plan is done running
+      if (clear_plans) {
+         planCache.clear();
+         clear_plans = false;
+      }
+      
+      // update jobs again and print
+      jobManager.updateJobStatus();
+      
+      if (!quiet)
+         jobManager.printJobs();
+      
+      jobManager.clearOldJobs();
+      
+#ifdef COUNT_ALLOCS
+      cerr << "[allocs: " << (wsh_num_allocs - start_allocs) << "]" << endl;
+#endif
+      
+   } // end of main while
+   
+   currentCmdLine.resetCommand();
+}
+
+/******************************************************
+   Waits for the next line to be typed, reporting each
+   background job as soon as it finishes instead of
+   after the next line. The prompt is printed again
+   after a report, though anything typed so far is
+   still waiting in the terminal.
+   
+   POST: The next line can be read without waiting on
+         background jobs.
+*/
+void WimpyShell::waitForLine() {
+   
+   int wait_fd = lineReader.getWaitFd();
+   
+   if (wait_fd == -1)
+      return;
+   
+   while (jobManager.waitForInput(wait_fd)) {
+      
+      cout << endl;
+      jobManager.printJobs();
+      jobManager.clearOldJobs();
+      
+      if (lineReader.isInteractive())
+         cout << "wsh: " << flush;
+   }
+}
+
+/******************************************************
+   Runs the compiled program of a command list. The
+   program counter walks the instructions in order, the
+   run instructions hand their pipeline to a ForeJob, the
+   JobManager or the PipeManager and keep its exit status
+   in last_status, and the jumps look at last_status to
+   skip the other side of an '&&' or '||'.
+   
+   A command that is the last instruction of the last
+   line of the input is exec'd in place of the shell,
+   since nothing could run after it anyway.
+   
+   PRE:  cmdList has been parsed successfully.
+   
+   POST: Every pipeline the program reached has been run.
+*/
+void WimpyShell::runCommandList(const CommandList &cmdList) {
+   
+   const vector<Instruction> &program = cmdList.getProgram();
+   int num_instructions = program.size();
+   int pc = 0;
+   
+   while (pc < num_instructions) {
+      
+      const Instruction &current = program[pc];
+      pc++;
+      
+      switch (current.op) {
+         
+         case OP_RUN_COMMAND:
+            
+            currentCmdLine = cmdList.getPipeline(current.arg).getCommand(0);
+            
+            // try to run builtin commands, then a foreground job
+            if (!runBuiltinCommands()) {
+               
+               lineReader.shareInput();
+               ForeJob run_me(currentCmdLine, spawner, jobManager);
+               
+               // nothing runs after the last command, so it can take the
+               // shell's place, unless there are background jobs left to
+               // report or start
+               bool last_command = (pc == num_instructions) && lineReader.atEnd();
+               bool jobs_left = quiet ? (jobManager.getNumQueued() > 0) : (jobManager.getNumJobs() > 0);
+               
+               if (last_command && !jobs_left)
+                  run_me.replaceShell(0);
+               else
+                  run_me.execute();
+               
+               last_status = run_me.getExitStatus();
+            }
+            break;
+            
+         case OP_RUN_BACKGROUND:
+            
+            currentCmdLine = cmdList.getPipeline(current.arg).getCommand(0);
+            
+            // background jobs count as a success once they start
+            if (!runBuiltinCommands()) {
+               lineReader.shareInput();
+               jobManager.createBackgroundJob(currentCmdLine, cmdList.getPipeline(current.arg).getPriority());
+               last_status = 0;
+            }
+            break;
+            
+         case OP_RUN_PIPELINE:
+            
+            lineReader.shareInput();
+            pipeManager.execute(cmdList.getPipeline(current.arg));
+            last_status = pipeManager.getExitStatus();
+            break;
+            
+         case OP_JUMP_IF_FAILED:
+            
+            if (last_status != 0)
+               pc = current.arg;
+            break;
+            
+         case OP_JUMP_IF_OK:
+            
+            if (last_status == 0)
+               pc = current.arg;
+            break;
+      }
+   }
+}
+
+/******************************************************
+   Checks the current command to see if it should be
+   handled as a builtin command by the shell. If it
+   is, the command is executed.
+   
+   POST: Returns true if the current command is a
+         builtin, regardless of if it executes
+         successfully, and last_status is set to 0 or
+         1 if it failed. Returns false if the current
+         command is not a builtin command.
+*/
+bool WimpyShell::runBuiltinCommands() {
+   
+   // builtins only change this when they fail
+   last_status = 0;
+   
+   // end the shell
+   if (currentCmdLine.hasCommandName("exit")) {
+      exit(0);
+   }
+   
+   // change directory
+   if (currentCmdLine.hasCommandName("cd")) {
+      runChangeDir();
+      return true;
+   }
+   
+   // wait for background process
+   if (currentCmdLine.hasCommandName("wait")) {
+      runWait();
+      return true;
+   }
+   
+   // list background jobs and their history
+   if (currentCmdLine.hasCommandName("jobs")) {
+      runJobs();
+      return true;
+   }
+   
+   // plan cache stats and control
+   if (currentCmdLine.hasCommandName("plancache")) {
+      runPlanCache();
+      return true;
+   }
+   
+   // how new processes are started
+   if (currentCmdLine.hasCommandName("spawn")) {
+      runSpawn();
+      return true;
+   }
+   
+   // replace the shell with a command
+   if (currentCmdLine.hasCommandName("exec")) {
+      runExec();
+      return true;
+   }
+   
+   // where commands are found
+   if (currentCmdLine.hasCommandName("hash")) {
+      runHash();
+      return true;
+   }
+   
+   // how big pipes are made
+   if (currentCmdLine.hasCommandName("pipesize")) {
+      runPipeSize();
+      return true;
+   }
+   
+   // how many background jobs run at once
+   if (currentCmdLine.hasCommandName("joblimit")) {
+      runJobLimit();
+      return true;
+   }
+   
+   // a command for each line of the input, like xargs -P
+   if (currentCmdLine.hasCommandName("parallel")) {
+      runParallel();
+      return true;
+   }
+   
+   // personal vanity
+   if (currentCmdLine.hasCommandName("aboutwsh")) {
+      runAboutwsh();
+      return true;
+   } 
+   
+   return false;
+}
+
+/******************************************************
+   Tries to change the current working directory of
+   wimpy shell to the first argument of the cd command.
+   The current working directory is then printed to
+   standard output.
+   
+   PRE:  currentCmdLine must be a change directory
+         "cd" command.
+   
+   POST: Returns after an attempt is made to change the
+         CWD and the CWD is printed to stdout. If an
+         error was encountered an error message is printed
+         and the CWD remains the same.
+*/
+void WimpyShell::runChangeDir() {
+   
+   // check to make sure an argument exists, segmentation faults BAD!!!
+   if (currentCmdLine.getArgCount() == 0) {
+      
+      cout << "Could not change directory:" << endl;
+      cout << "  No directory given." << endl;
+      last_status = 1;
+      
+   // otherwise try to change directory
+   } else {
+    
+      // linux system call
+      int change_success = chdir(currentCmdLine.getArg(0).c_str());
+      
+      if (change_success == -1) {
+         cout << "Could not change directory:" << endl;
+         last_status = 1;
+         
+         if (errno == 2) { // file not found
+            cout << "  No such directory." << endl;
+         } else {
+            cout << "  " << strerror(errno) << "." << endl;
+         }
+      } 
+      
+   }
+   
+   // array to store address, on the stack so nothing is allocated
+   char cwd[MAX_CWD_SIZE];
+
+   // linux system call
+   getcwd(cwd, MAX_CWD_SIZE);
+   
+   cout << "Working directory " << cwd << endl;
+}
+
+/******************************************************
+   Tries to wait for the background job specified
+   in the command arguments to finished executing.
+   
+   PRE:  currentCmdLine must be a "wait" command.
+   
+   POST: Returns after an attempt is made to wait for
+         the process specified in the first argument
+         of currentCmdLine.
+*/
+void WimpyShell::runWait() {
+      
+   // check for an argument
+   if (currentCmdLine.getArgCount() == 0) {
+      cout << "Could not wait for job:" << endl;
+      cout << "  No job number given." << endl;
+   
+   // try to wait for the job
+   } else {
+      int job_num = atoi(currentCmdLine.getArg(0).c_str());
+      jobManager.waitForJob(job_num);
+   }
+}
+
+/******************************************************
+   Lists the running background jobs and the ones in
+   the history. "-l" adds each job's pid, and how the
+   finished ones exited and what they used.
+   
+   PRE:  currentCmdLine must be a "jobs" command.
+   
+   POST: Returns after the jobs have been printed.
+*/
+void WimpyShell::runJobs() {
+   
+   int num_args = currentCmdLine.getArgCount();
+   
+   if ((num_args == 0) || ((num_args == 1) && (currentCmdLine.getArg(0) == "-l"))) {
+      jobManager.printHistory(num_args == 1);
+      return;
+   }
+   
+   cout << "Could not list jobs:" << endl;
+   cout << "  Usage: jobs [-l]" << endl;
+   last_status = 1;
+}
+
+/******************************************************
+   Prints or changes the plan cache. With no arguments
+   the hit and miss counters are printed, "clear" empties
+   the cache, and "limit N" sets the most plans it will
+   hold (0 for no limit).
+   
+   PRE:  currentCmdLine must be a "plancache" command.
+   
+   POST: Returns after the stats have been printed or
+         the cache has been changed.
+*/
+void WimpyShell::runPlanCache() {
+   
+   // just print the stats
+   if (currentCmdLine.getArgCount() == 0) {
+      planCache.printStats();
+      return;
+   }
+   
+   // the plan that is running right now lives in the cache,
+   // so startShell() clears it once the line is done
+   if (currentCmdLine.getArg(0) == "clear") {
+      clear_plans = true;
+      return;
+   }
+   
+   if ((currentCmdLine.getArg(0) == "limit") && (currentCmdLine.getArgCount() == 2)) {
+      
+      int new_limit = atoi(currentCmdLine.getArg(1).c_str());
+      
+      if (new_limit >= 0) {
+         planCache.setLimit(new_limit);
+         return;
+      }
+   }
+   
+   cout << "Could not change plan cache:" << endl;
+   cout << "  Usage: plancache [clear | limit N]" << endl;
+   last_status = 1;
+}
+
+/******************************************************
+   Prints or changes the way new processes are started.
+   With no arguments the current method is printed,
+   otherwise the argument is the method to switch to.
+   
+   PRE:  currentCmdLine must be a "spawn" command.
+   
+   POST: Returns after the method has been printed or
+         changed.
+*/
+void WimpyShell::runSpawn() {
+   
+   // just print the method
+   if (currentCmdLine.getArgCount() == 0) {
+      cout << "Spawn method: " << Spawner::getMethodName() << endl;
+      return;
+   }
+   
+   if ((currentCmdLine.getArgCount() == 1) && Spawner::setMethod(currentCmdLine.getArg(0)))
+      return;
+   
+   cout << "Could not change spawn method:" << endl;
+   cout << "  Usage: spawn [fork | vfork | posix_spawn | clone3 | helper]" << endl;
+   last_status = 1;
+}
+
+/******************************************************
+   Prints or changes the table of command paths. With
+   no arguments the table is printed, "-r" empties it,
+   and otherwise each argument is looked up and put in
+   the table before it is run.
+   
+   PRE:  currentCmdLine must be a "hash" command.
+   
+   POST: Returns after the table has been printed or
+         changed. last_status is 1 if a command wasn't
+         found.
+*/
+void WimpyShell::runHash() {
+   
+   PathCache &path_cache = Spawner::getPathCache();
+   int num_args = currentCmdLine.getArgCount();
+   
+   // just print the table
+   if (num_args == 0) {
+      path_cache.printTable();
+      return;
+   }
+   
+   if ((num_args == 1) && (currentCmdLine.getArg(0) == "-r")) {
+      path_cache.clear();
+      return;
+   }
+   
+   for (int argCtr = 0; argCtr < num_args; argCtr++) {
+      
+      string name = currentCmdLine.getArg(argCtr);
+      
+      if (path_cache.lookup(name.c_str()) == NULL) {
+         cout << "Could not hash command:" << endl;
+         cout << "  " << name << " not found." << endl;
+         last_status = 1;
+      }
+   }
+}
+
+/******************************************************
+   Prints or changes the size of the pipes made for
+   pipelines that don't have a PIPESIZE= word. With no
+   arguments the size is printed.
+   
+   PRE:  currentCmdLine must be a "pipesize" command.
+   
+   POST: Returns after the size has been printed or
+         changed.
+*/
+void WimpyShell::runPipeSize() {
+   
+   // just print the size
+   if (currentCmdLine.getArgCount() == 0) {
+      
+      const PipeSize &size = PipeManager::getPipeSize();
+      
+      if (size.mode == PIPE_SIZE_FIXED)
+         cout << "Pipe size: " << size.bytes << " bytes" << endl;
+      else if (size.mode == PIPE_SIZE_ADAPTIVE)
+         cout << "Pipe size: adaptive" << endl;
+      else
+         cout << "Pipe size: default" << endl;
+      
+      return;
+   }
+   
+   PipeSize new_size;
+   
+   if ((currentCmdLine.getArgCount() == 1) && PipedCommand::parsePipeSize(currentCmdLine.getArg(0).c_str(), new_size)) {
+      PipeManager::setPipeSize(new_size);
+      return;
+   }
+   
+   cout << "Could not change pipe size:" << endl;
+   cout << "  Usage: pipesize [default | adaptive | BYTES[K|M]]" << endl;
+   last_status = 1;
+}
+
+/******************************************************
+   Prints or changes the most background jobs that run
+   at once, 0 for no limit. With no arguments the limit
+   is printed.
+   
+   PRE:  currentCmdLine must be a "joblimit" command.
+   
+   POST: Returns after the limit has been printed or
+         changed. Raising it starts queued jobs.
+*/
+void WimpyShell::runJobLimit() {
+   
+   // just print the limit
+   if (currentCmdLine.getArgCount() == 0) {
+      
+      if (jobManager.getMaxRunning() == 0)
+         cout << "Job limit: none" << endl;
+      else
+         cout << "Job limit: " << jobManager.getMaxRunning() << endl;
+      
+      return;
+   }
+   
+   if (currentCmdLine.getArgCount() == 1) {
+      
+      string text = currentCmdLine.getArg(0);
+      char *end;
+      long new_max = strtol(text.c_str(), &end, 10);
+      
+      if ((end != text.c_str()) && (*end == '\0') && (new_max >= 0) && (new_max <= 1000000)) {
+         jobManager.setMaxRunning(new_max);
+         return;
+      }
+   }
+   
+   cout << "Could not change job limit:" << endl;
+   cout << "  Usage: joblimit [N]" << endl;
+   last_status = 1;
+}
+
+/******************************************************
+   Runs the command in the arguments once for each line
+   of the input, some number of them at a time. The
+   lines come from the file given with "-a", the input
+   redirect, or else standard input. "-j N" is how many
+   run at once, the number of CPUs if it isn't given,
+   and "-k" keeps the output in the order of the lines.
+   
+   PRE:  currentCmdLine must be a "parallel" command.
+   
+   POST: Returns after every job has finished, with
+         last_status 0 if they all exited with 0.
+*/
+void WimpyShell::runParallel() {
+   
+   int num_args = currentCmdLine.getArgCount();
+   int max_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+   bool ordered = false;
+   const char *in_path = currentCmdLine.getInputFilePath();
+   string arg_file;
+   bool usage_ok = true;
+   int argCtr = 0;
+   
+   // the options, up to the first word that isn't one
+   while (usage_ok && (argCtr < num_args) && (currentCmdLine.getArg(argCtr)[0] == '-')) {
+      
+      string option = currentCmdLine.getArg(argCtr++);
+      
+      if (option == "-k") {
+         ordered = true;
+      } else if ((option == "-j") && (argCtr < num_args)) {
+         
+         string text = currentCmdLine.getArg(argCtr++);
+         char *end;
+         max_jobs = strtol(text.c_str(), &end, 10);
+         
+         usage_ok = (end != text.c_str()) && (*end == '\0') && (max_jobs > 0) && (max_jobs <= 100000);
+         
+      } else if ((option == "-a") && (argCtr < num_args)) {
+         arg_file = currentCmdLine.getArg(argCtr++);
+         in_path = arg_file.c_str();
+      } else {
+         usage_ok = false;
+      }
+   }
+   
+   if (!usage_ok || (argCtr == num_args)) {
+      cout << "Could not run parallel:" << endl;
+      cout << "  Usage: parallel [-j N] [-k] [-a FILE] COMMAND [ARG...]" << endl;
+      last_status = 1;
+      return;
+   }
+   
+   vector<string> command;
+   for (; argCtr < num_args; argCtr++)
+      command.push_back(currentCmdLine.getArg(argCtr));
+   
+   if (max_jobs < 1)
+      max_jobs = 1;
+   
+   int in_fd = 0;
+   int out_fd = 1;
+   
+   if (in_path != NULL) {
+      
+      in_fd = open(in_path, O_RDONLY | O_CLOEXEC);
+      
+      if (in_fd == -1) {
+         cout << "Input file error:" << endl;
+         cout << "  " << strerror(errno) << "." << endl;
+         last_status = 1;
+         return;
+      }
+   } else {
+      lineReader.shareInput();
+   }
+   
+   if (currentCmdLine.isOutputRedirected()) {
+      
+      out_fd = open(currentCmdLine.getOutputFilePath(), O_CREAT|O_WRONLY|O_TRUNC|O_CLOEXEC, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+      
+      if (out_fd == -1) {
+         cout << "Output file error:" << endl;
+         cout << "  " << strerror(errno) << "." << endl;
+         
+         if (in_fd != 0)
+            close(in_fd);
+         
+         last_status = 1;
+         return;
+      }
+   }
+   
+   // anything the shell printed goes out before the jobs' output
+   cout.flush();
+   
+   last_status = parallelRunner.run(command, max_jobs, ordered, in_fd, out_fd);
+   
+   if (in_fd != 0)
+      close(in_fd);
+   
+   if (out_fd != 1)
+      close(out_fd);
+}
+
+/******************************************************
+   Replaces the shell with the command in the arguments,
+   with its redirections done to the shell first. With
+   no command the redirections are for the shell itself
+   from then on, like sh does.
+   
+   PRE:  currentCmdLine must be an "exec" command.
+   
+   POST: Only returns if there was no command or it
+         couldn't be run, and then last_status is 1 (or
+         126 or 127) if something failed.
+*/
+void WimpyShell::runExec() {
+   
+   // the shell can't be in the background and still be here
+   if (currentCmdLine.isBackgroundJob()) {
+      cout << "Could not exec:" << endl;
+      cout << "  exec can't run in the background." << endl;
+      last_status = 1;
+      return;
+   }
+   
+   ForeJob run_me(currentCmdLine, spawner, jobManager);
+   
+   if (currentCmdLine.getArgCount() == 0) {
+      
+      if (!run_me.redirectShell())
+         last_status = 1;
+      
+      return;
+   }
+   
+   lineReader.shareInput();
+   run_me.replaceShell(1);
+   last_status = run_me.getExitStatus();
+}
+
+/******************************************************
+   Warns the user about any unsupported features used
+   by the commands of a parsed command line.
+   
+   POST: A warning has been printed for each command
+         that uses an unsupported feature.
+*/
+void WimpyShell::printWarnings(const CommandList &cmdList) {
+   
+   for (int pipeCtr = 0; pipeCtr < cmdList.getNumPipelines(); pipeCtr++) {
+      
+      const PipedCommand &pipedCmdLine = cmdList.getPipeline(pipeCtr);
+      
+      for (int cmdCtr = 0; cmdCtr < pipedCmdLine.getNumCommands(); cmdCtr++) {
+         
+         const string &unsupported = pipedCmdLine.getCommand(cmdCtr).getUnsupportedFeature();
+         
+         if (unsupported != "none") {
+            cout << "Warning:" << endl;
+            cout << "  Unsupported feature: " << unsupported << endl;
+         }
+      }
+   }
+}
+
+/******************************************************
+   Prints my ode to personal vanity to standard output.
+   
+   PRE:  currentCmdLine must be the about Wimpy Shell
+         "aboutwsh" command.
+   
+   POST: Returns after the logo and info has been printed.
+*/
+void WimpyShell::runAboutwsh() {
+   
+   cout << " _      _                                  ___" << endl;
+   cout << "  |  |  /    ,                            /    )   /           /   /" << endl;
+   cout << "  | /| /        _  _      __              \\       /__    __   /   /" << endl;
+   cout << "  |/ |/    /   / /  )   /   ) /   /        \\     /   ) /___) /   /" << endl;
+   cout << "__/  |____/___/ /  /___/___/_(___/_____(____/___/   /_(___ _/___/___" << endl;
+   cout << "                      /         /" << endl;
+   cout << "                     /      (_ /" << endl << endl;
+   cout << "Wimpy Shell was written by Shea Daniels in 2006." << endl << endl;
+}
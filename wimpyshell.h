@@ -1,84 +1,148 @@
-/* file: wimpyshell.h
-   
-   Shell Header File
-   ==================================================
-   Wimpy Shell Project - Com Sci 342
-   Shea Daniels
-   
-   This class represents the entire Wimpy Shell. An
-   instance of this class is essentially an entire
-   shell. It's only public method is to start the main
-   control loop of the shell.
-   
-   NOTE: There is a maximum limit on the number of
-         characters that are supported for the current
-         working directory (CWD). Extremely nested
-         folders will probably break this shell.
-         
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on constructors:                   !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   WimpyShell()
-   --------------------------------------------------
-      This is the basic constructor for the class.
-      
-      POST: The object is initialized.
-   
-   
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   ! Information on public methods:                 !
-   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-   
-   void startShell()
-   --------------------------------------------------
-      This starts the main control loop for Wimpy Shell.
-   
-      POST: Wimpy Shell is now running until the user
-         decides to quit the program.
-   
-*/
-
-#ifndef WSH_HEADER
-#define WSH_HEADER
-
-#include <iostream>
-#include <string>
-#include <unistd.h>
-#include <errno.h>
-#include "JobManager.h"
-#include "PipeManager.h"
-#include "Command.h"
-#include "PipedCommand.h"
-#include "ForeJob.h"
-
-// size limit (# of chars) supported for the current working directory
-const int MAX_CWD_SIZE = 256;
-
-class WimpyShell {
-    
-    public:
-    
-         // constructor
-         WimpyShell();
-         
-         // this is where the all the magic happens
-         void startShell();
-    
-    private:
-         
-         // methods dealing with builtin commands
-         bool runBuiltinCommands();
-         void runChangeDir();
-         void runWait();
-         void runAboutwsh();
-         
-         //------------------------------------------------------------
-         // Data
-         //------------------------------------------------------------
-         JobManager jobManager;
-         Command currentCmdLine;
-};
-
-#endif
+/* file: wimpyshell.h
+   
+   Shell Header File
+   ==================================================
+   Wimpy Shell Project - Com Sci 342
+   Shea Daniels
+   
+   This class represents the entire Wimpy Shell. An
+   instance of this class is essentially an entire
+   shell. Its public methods start the main control
+   loop of the shell, either for somebody typing at it
+   or quietly for a script or a "-c" command line.
+   
+   NOTE: There is a maximum limit on the number of
+         characters that are supported for the current
+         working directory (CWD). Extremely nested
+         folders will probably break this shell.
+         
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on constructors:                   !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   WimpyShell()
+   --------------------------------------------------
+      This is the basic constructor for the class.
+      
+      POST: The object is initialized.
+   
+   
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   ! Information on public methods:                 !
+   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+   
+   void startShell()
+   --------------------------------------------------
+      This starts the main control loop for Wimpy Shell.
+   
+      POST: Wimpy Shell is now running until the user
+         decides to quit the program.
+   
+   
+   NOTE: While it waits for a line, the shell also
+         waits on the background jobs, and reports each
+         one as soon as it finishes, then prompts again.
+   
+   
+   int runScript(int script_fd)
+   int runString(const char *text)
+   --------------------------------------------------
+      Run every line of a script file or a string
+      without the welcome message, prompts or updates
+      on background jobs. The last command is exec'd in
+      place of the shell, so these only return if it
+      was a builtin or couldn't be run.
+      
+      PRE:  script_fd is open for reading. text is null
+            terminated.
+      
+      POST: Returns the exit status of the last command.
+   
+*/
+
+#ifndef WSH_HEADER
+#define WSH_HEADER
+
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <errno.h>
+#include "JobManager.h"
+#include "PipeManager.h"
+#include "Command.h"
+#include "PipedCommand.h"
+#include "CommandList.h"
+#include "ForeJob.h"
+#include "ParallelRunner.h"
+#include "PlanCache.h"
+#include "LineReader.h"
+#include "Spawner.h"
+
+// size limit (# of chars) supported for the current working directory
+const int MAX_CWD_SIZE = 256;
+
+class WimpyShell {
+    
+    public:
+    
+         // constructor
+         WimpyShell();
+         
+         // this is where the all the magic happens
+         void startShell();
+         int runScript(int script_fd);
+         int runString(const char *text);
+    
+    private:
+         
+         // the main control loop
+         void runLines();
+         void waitForLine();
+         
+         // runs the compiled program of a line
+         void runCommandList(const CommandList &cmdList);
+         
+         // methods dealing with builtin commands
+         bool runBuiltinCommands();
+         void runChangeDir();
+         void runWait();
+         void runJobs();
+         void runPlanCache();
+         void runSpawn();
+         void runHash();
+         void runPipeSize();
+         void runJobLimit();
+         void runParallel();
+         void runExec();
+         void runAboutwsh();
+         
+         // warnings about parsed commands
+         void printWarnings(const CommandList &cmdList);
+         
+         //------------------------------------------------------------
+         // Data
+         //------------------------------------------------------------
+         JobManager jobManager;
+         PipeManager pipeManager;
+         PlanCache planCache;
+         Command currentCmdLine;
+         LineReader lineReader;
+         
+         // starts foreground jobs
+         Spawner spawner;
+         
+         // runs the "parallel" builtin
+         ParallelRunner parallelRunner;
+         
+         // exit status of the last command, for && and ||
+         int last_status;
+         
+         // set by "plancache clear", done after the line runs
+         bool clear_plans;
+         
+         // no prompts or job updates, for scripts and "-c"
+         bool quiet;
+};
+
+#endif